@@ -1,6 +1,8 @@
 import argparse
 import json
+import math
 import os
+import struct
 import sys
 
 def LoadFile( file_name ):
@@ -16,8 +18,15 @@ def WriteFile( file_name, file_content ):
 		file.write( file_content )
 
 
+# "-0" is negative zero, like in parser, python makes integer zero from it.
+def ParseJsonInt( int_str ):
+	if int_str == "-0":
+		return -0.0
+	return int(int_str)
+
+
 def ParseJson( json_content_str ):
-	return json.loads( json_content_str )
+	return json.loads( json_content_str, parse_int= ParseJsonInt )
 
 
 named_values_counter= 0
@@ -28,28 +37,6 @@ def NextCounter():
 	return str(result)
 
 
-def PrepareIntValue( int_value ):
-
-	int_value = int(int_value)
-
-	# Clamp to common range of int64_t and uint64_t
-	if int_value > 0xFFFFFFFFFFFFFFFF:
-		int_value= 0xFFFFFFFFFFFFFFFF
-	elif int_value < -0x8000000000000000:
-		int_value=   -0x8000000000000000
-
-	# Convert big unsigned value to int64_t
-	if int_value >  0x7FFFFFFFFFFFFFFF:
-		int_value= int_value - 0x10000000000000000
-
-	# Hack for most negative value.
-	if int_value == -0x8000000000000000:
-		return "0x8000000000000000ll"
-
-	# Finally, convert to string
-	return str(int_value) + "ll"
-
-
 #produce valid c++ string literal
 def MakeQuotedEscapedString( s ):
 	result= "u8\""
@@ -58,7 +45,8 @@ def MakeQuotedEscapedString( s ):
 		if c == '"' :
 			result= result + "\\\""
 		elif c == '\0':
-			result= result + "\0"
+			# Use three-digit octal sequence, because next symbol may be digit.
+			result= result + "\\000"
 		elif c == '\\':
 			result= result + "\\\\"
 		elif c == '\b':
@@ -87,16 +75,98 @@ object_values_pool= dict()
 array_values_pool= dict()
 string_values_data_pool= dict()
 
-# Output stream of all initializers
-out_stream= ""
+# Output stream of all initializers. Streams are lists of pieces, joined at end - repeated concatenation of big strings is too slow.
+out_stream= []
 
 # Some params
 save_string_for_numbers= False
+pack_number_arrays= True
 pack_strings_into_struct= True
 
 strings_struct_name= "strings"
-strings_struct_stream= ""
-strings_struct_initializer_stream= ""
+strings_struct_stream= []
+strings_struct_initializer_stream= []
+
+# Returns integer literal for packed array element.
+def MakeInt64Literal( int_value ):
+	# Most negative value can not be written as negated literal.
+	if int_value == -0x8000000000000000:
+		return "(-0x7FFFFFFFFFFFFFFFll - 1ll)"
+	return str(int_value) + "ll"
+
+
+# Returns kind of number ("Int64", "Uint64" or "Double") and number, converted to this kind.
+# Kind is chosen like in parser: exact integers (including doubles with integer value, like 1.0 or 1e2) are stored as integers,
+# negative zero and other numbers - as doubles.
+def GetNumberKind( number ):
+	if type(number) is float and number.is_integer() and -0x8000000000000000 <= number <= 0xFFFFFFFFFFFFFFFF and \
+		not ( number == 0.0 and math.copysign( 1.0, number ) < 0.0 ):
+		number= int(number)
+	if type(number) is int and -0x8000000000000000 <= number <= 0x7FFFFFFFFFFFFFFF:
+		return ( "Int64", number )
+	if type(number) is int and 0 <= number <= 0xFFFFFFFFFFFFFFFF:
+		return ( "Uint64", number )
+	return ( "Double", float(number) )
+
+
+# Returns initializer of number value.
+def MakeNumberValueInitializer( number, has_string ):
+	has_string_str= "true" if has_string else "false"
+	kind, number= GetNumberKind( number )
+	if kind == "Int64":
+		return "NumberValue::FromInt64( " + MakeInt64Literal(number) + ", " + has_string_str + " )"
+	if kind == "Uint64":
+		return "NumberValue::FromUint64( " + str(number) + "ull, " + has_string_str + " )"
+	return "NumberValue::FromDouble( " + repr(number) + ", " + has_string_str + " )"
+
+
+# Emits array of numbers as packed array, if this is possible. Returns name of value or None.
+# Packed array must produce exactly same int and double values, as separate number values, and keep kind of numbers.
+def WritePackedNumberArray( json_list ):
+	global out_stream
+
+	if len(json_list) == 0:
+		return None
+
+	# Bools are ints in python, so, check exact type.
+	for element in json_list:
+		if not ( type(element) is int or type(element) is float ):
+			return None
+
+	# Integers and doubles are not packed together, because packed array does not keep kind of number.
+	kinds= [ GetNumberKind( element ) for element in json_list ]
+	if all( kind == "Int64" for kind, number in kinds ):
+		layout= "PackedInt64s"
+		storage_type= "PackedInt64ArrayValueWithStorage"
+		elements_strings= [ MakeInt64Literal(number) for kind, number in kinds ]
+	elif all( kind == "Double" for kind, number in kinds ):
+		layout= "PackedDoubles"
+		storage_type= "PackedDoubleArrayValueWithStorage"
+		elements_strings= [ repr(number) for kind, number in kinds ]
+	else:
+		return None
+
+	elements_storage= ""
+	for element_string in elements_strings:
+		elements_storage+= "\t\t" + element_string + ",\n"
+
+	global array_values_pool
+	pool_key= layout + "\n" + elements_storage
+	pool_array= array_values_pool.get( pool_key, None )
+	if pool_array is not None:
+		return pool_array
+
+	arr_storage_name= "array_storage" + NextCounter()
+	arr_value_name= arr_storage_name + ".value"
+
+	array_values_pool[ pool_key ]= arr_value_name
+
+	object_count= str(len(json_list)) + "u"
+	out_stream.append( "constexpr const " + storage_type + "<" + object_count + "> " + arr_storage_name + \
+	"\n{\n" + "\tArrayValue(" + object_count + ", ArrayValue::Layout::" + layout + "),\n" + "\t{\n" + elements_storage + "\t}\n" + "};\n\n" )
+
+	return arr_value_name
+
 
 # Returns name of value.
 def WritePanzerJsonValue( json_struct ):
@@ -133,10 +203,17 @@ def WritePanzerJsonValue( json_struct ):
 		result_object_storage= "constexpr const ObjectValueWithEntriesStorage<" + object_count + "> " + obj_storage_name + \
 		"\n{\n" + "\tObjectValue(" + object_count + "),\n" + "\t{\n" + result_object_storage + "\t}\n" + "};\n\n"
 
-		out_stream+= result_object_storage
+		out_stream.append( result_object_storage )
 		return obj_value_name
 
 	if type(json_struct) is list:
+		global pack_number_arrays
+		global save_string_for_numbers
+		if pack_number_arrays and not save_string_for_numbers:
+			packed_array= WritePackedNumberArray( json_struct )
+			if packed_array is not None:
+				return packed_array
+
 		result_array_storage= ""
 
 		for array_member in json_struct :
@@ -158,7 +235,7 @@ def WritePanzerJsonValue( json_struct ):
 		result_array_storage= "constexpr const ArrayValueWithElementsStorage<" + object_count + "> " + arr_storage_name + \
 		"\n{\n" + "\tArrayValue(" + object_count + "),\n" + "\t{\n" + result_array_storage + "\t}\n" + "};\n\n"
 
-		out_stream+= result_array_storage
+		out_stream.append( result_array_storage )
 		return arr_value_name
 
 	if type(json_struct) is str:
@@ -180,9 +257,10 @@ def WritePanzerJsonValue( json_struct ):
 
 				quoted_string= MakeQuotedEscapedString(json_struct)
 				str_length= str(len(json_struct.encode("utf-8")) + 1) + "u"
+				string_value_initializer= "StringValue( " + str(len(json_struct.encode("utf-8"))) + "u )"
 
-				strings_struct_stream+= "\tStringValueWithStorage<" + str_length + "> " + storage_name + ";\n"
-				strings_struct_initializer_stream+= "\t{ StringValue(), " + quoted_string + " },\n"
+				strings_struct_stream.append( "\tStringValueWithStorage<" + str_length + "> " + storage_name + ";\n" )
+				strings_struct_initializer_stream.append( "\t{ " + string_value_initializer + ", " + quoted_string + " },\n" )
 
 				# Also, save pointer to storage of string value.
 				# We can use this pointer, also, for objects keys.
@@ -195,14 +273,15 @@ def WritePanzerJsonValue( json_struct ):
 				string_values_pool[ json_struct ]= var_name
 				quoted_string= MakeQuotedEscapedString(json_struct)
 				str_length= str(len(json_struct.encode("utf-8")) + 1) + "u"
+				string_value_initializer= "StringValue( " + str(len(json_struct.encode("utf-8"))) + "u )"
 				result_string_storage= "constexpr StringValueWithStorage<" + str_length + "> " + storage_name + \
-				"\n{\n" + "\tStringValue(),\n" + "\t" + quoted_string + "\n};\n\n"
+				"\n{\n" + "\t" + string_value_initializer + ",\n" + "\t" + quoted_string + "\n};\n\n"
 
 				# Also, save pointer to storage of string value.
 				# We can use this pointer, also, for objects keys.
 				string_values_data_pool[ json_struct ]= storage_name + ".string"
 
-				out_stream+= result_string_storage
+				out_stream.append( result_string_storage )
 				return var_name
 
 		else:
@@ -211,8 +290,11 @@ def WritePanzerJsonValue( json_struct ):
 	if type(json_struct) is int or type(json_struct) is float:
 		# Use numbers pooling - emit same value once.
 		global number_values_pool
-		# Make combined key - for value as int and float. Because, we can lost precision, if we will use only int or float keys.
-		pool_key = str(float(json_struct)) + "___" + str(int(json_struct))
+		# Key is emitted kind and exact value of this kind, so, numbers of different kinds are not mixed.
+		kind, number= GetNumberKind( json_struct )
+		pool_key= kind + "___" + repr(number)
+		if save_string_for_numbers:
+			pool_key+= "___" + str(json_struct)
 		pool_value = number_values_pool.get( pool_key, None )
 		if pool_value is None:
 
@@ -220,17 +302,16 @@ def WritePanzerJsonValue( json_struct ):
 			var_name= storage_name + ".value"
 			number_values_pool[ pool_key ]= var_name
 
-			global save_string_for_numbers
 			if save_string_for_numbers:
 				num_str= str(json_struct)
 				num_str_quoted= "\"" + num_str + "\""
 				result_number_storage= "constexpr NumberValueWithStringStorage<" + str(len(num_str) + 1) + "u> " + storage_name + \
-				"\n{\n" + "\tNumberValue( " + PrepareIntValue(json_struct) + ", " + str(float(json_struct)) + ", true ),\n" + "\t" + num_str_quoted + "\n};\n\n"
+				"\n{\n" + "\t" + MakeNumberValueInitializer( json_struct, True ) + ",\n" + "\t" + num_str_quoted + "\n};\n\n"
 			else:
 				result_number_storage= "constexpr NumberValueWithStringStorage<0u> " + storage_name + \
-				"\n{\n" + "\tNumberValue( " + PrepareIntValue(json_struct) + ", " + str(float(json_struct)) + ", false )" + "\n};\n\n"
+				"\n{\n" + "\t" + MakeNumberValueInitializer( json_struct, False ) + "\n};\n\n"
 
-			out_stream+= result_number_storage
+			out_stream.append( result_number_storage )
 			return var_name
 
 		else:
@@ -245,12 +326,12 @@ def WritePanzerJsonValue( json_struct ):
 			var_name= "bool_value_true"
 			if not true_bool_value_emitted:
 				true_bool_value_emitted= True
-				out_stream+= "constexpr BoolValue " + var_name + "(" + str(json_struct).lower() + ");\n\n"
+				out_stream.append( "constexpr BoolValue " + var_name + "(" + str(json_struct).lower() + ");\n\n" )
 		else:
 			var_name= "bool_value_false"
 			if not false_bool_value_emitted:
 				false_bool_value_emitted= True
-				out_stream+= "constexpr BoolValue " + var_name + "(" + str(json_struct).lower() + ");\n\n"
+				out_stream.append( "constexpr BoolValue " + var_name + "(" + str(json_struct).lower() + ");\n\n" )
 		return var_name
 
 	if json_struct is None:
@@ -260,7 +341,7 @@ def WritePanzerJsonValue( json_struct ):
 		var_name= "null_value"
 		if not null_value_emitted:
 			null_value_emitted= True
-			out_stream+= "constexpr NullValue " + var_name + ";\n\n"
+			out_stream.append( "constexpr NullValue " + var_name + ";\n\n" )
 		return var_name
 
 	return ""
@@ -283,11 +364,11 @@ def WritePanzerJsonCpp( json_struct, h_file_name, variable_name ):
 
 	if pack_strings_into_struct:
 		result+= "struct StringsStorage final\n{\n"
-		result+= strings_struct_stream
+		result+= "".join( strings_struct_stream )
 		result+= "};\n\n"
-		result+= "constexpr StringsStorage " + strings_struct_name + "\n{\n" + strings_struct_initializer_stream + "};\n\n"
+		result+= "constexpr StringsStorage " + strings_struct_name + "\n{\n" + "".join( strings_struct_initializer_stream ) + "};\n\n"
 
-	result+= out_stream
+	result+= "".join( out_stream )
 	result+= "} //namespace\n\n"
 	result= result + "const PanzerJson::ValueBase& " + variable_name + "= " + root_value + ";\n"
 	return result
@@ -300,9 +381,229 @@ def WritePanzerJsonHpp( variable_name ):
 	return result
 
 
+# Blob mode.
+# Document is written as binary snapshot (see "snapshot.cpp") - image of parser storage with offsets in place of pointers,
+# plus list of these pointers (relocations). Generated code loads it with "Snapshot::Load" on first access.
+# Blob is built for 64-bit little-endian data layout. On other platforms "Snapshot::Load" rejects it.
+
+# Must be same, as in "snapshot.cpp".
+snapshot_magic= b"PJSNAPSH"
+snapshot_endianness_tag= 0x01020304
+snapshot_version= 1
+# Sizes of pointer, ObjectValue, ArrayValue, StringValue, NumberValue and alignment of double.
+snapshot_layout_signature= 8 | 8 << 5 | 8 << 10 | 8 << 15 | 16 << 20 | 8 << 25
+
+# Values of enums from "value.hpp".
+type_null= 0
+type_object= 1
+type_array= 2
+type_string= 3
+type_number= 4
+type_bool= 5
+array_layout_elements= 0
+array_layout_packed_doubles= 1
+array_layout_packed_int64s= 2
+number_kind_int64= 0
+number_kind_uint64= 1
+number_kind_double= 2
+string_unknown_length= 0xFFFFFFFF
+
+min_inline_number= -( 1 << 30 )
+max_inline_number= ( 1 << 30 ) - 1
+
+class BlobBuilder:
+
+	def __init__( self ):
+		self.storage= bytearray()
+		self.relocations= []
+		# Values pooling - same values are written once.
+		self.null_value= None
+		self.bool_values= [ None, None ]
+		self.number_values_pool= dict()
+		self.string_values_pool= dict()
+		self.keys_pool= dict()
+		self.containers_pool= dict()
+
+	# Values are pointer-aligned, like in parser storage.
+	def Align( self ):
+		self.storage.extend( bytes( -len(self.storage) % 8 ) )
+
+	# Returns offset of written data.
+	def Append( self, data ):
+		self.Align()
+		offset= len(self.storage)
+		self.storage.extend( data )
+		return offset
+
+	# Returns offset of value. Values, which are not pointers (inline numbers), are returned as tuple.
+	def WriteValue( self, json_struct, allow_inline ):
+		if type(json_struct) is dict:
+			body= bytearray()
+			body_relocations= []
+			for object_key in sorted( json_struct ):
+				key_offset= self.WriteKey( object_key )
+				value= self.WriteValue( json_struct[object_key], True )
+				body_relocations.append( len(body) )
+				body.extend( struct.pack( "<Q", key_offset ) )
+				self.AppendElement( body, body_relocations, value )
+			return self.WriteContainer( struct.pack( "<BBxxI", type_object, 0, len(json_struct) ), body, body_relocations )
+
+		if type(json_struct) is list:
+			if pack_number_arrays and not save_string_for_numbers:
+				packed= self.MakePackedNumberArray( json_struct )
+				if packed is not None:
+					return self.WriteContainer( packed, b"", [] )
+
+			body= bytearray()
+			body_relocations= []
+			for array_member in json_struct:
+				self.AppendElement( body, body_relocations, self.WriteValue( array_member, True ) )
+			return self.WriteContainer( struct.pack( "<BBxxI", type_array, array_layout_elements, len(json_struct) ), body, body_relocations )
+
+		if type(json_struct) is str:
+			offset= self.string_values_pool.get( json_struct, None )
+			if offset is None:
+				string_data= json_struct.encode( "utf-8" )
+				length= len(string_data) if len(string_data) < string_unknown_length else string_unknown_length
+				offset= self.Append( struct.pack( "<BBxxI", type_string, 0, length ) + string_data + b"\0" )
+				self.string_values_pool[ json_struct ]= offset
+			return offset
+
+		if type(json_struct) is int or type(json_struct) is float:
+			kind, number= GetNumberKind( json_struct )
+			if allow_inline and not save_string_for_numbers and kind == "Int64" and min_inline_number <= number <= max_inline_number:
+				return ( number, )
+
+			# Key is kind and exact value of this kind, like in non-blob mode.
+			pool_key= kind + "___" + repr(number)
+			if save_string_for_numbers:
+				pool_key+= "___" + str(json_struct)
+			offset= self.number_values_pool.get( pool_key, None )
+			if offset is None:
+				if kind == "Int64":
+					kind_value, payload= number_kind_int64, struct.pack( "<q", number )
+				elif kind == "Uint64":
+					kind_value, payload= number_kind_uint64, struct.pack( "<Q", number )
+				else:
+					kind_value, payload= number_kind_double, struct.pack( "<d", number )
+
+				number_value= struct.pack( "<BBBxxxxx", type_number, 1 if save_string_for_numbers else 0, kind_value ) + payload
+				if save_string_for_numbers:
+					number_value+= str(json_struct).encode( "utf-8" ) + b"\0"
+				offset= self.Append( number_value )
+				self.number_values_pool[ pool_key ]= offset
+			return offset
+
+		if type(json_struct) is bool:
+			index= 1 if json_struct else 0
+			if self.bool_values[index] is None:
+				self.bool_values[index]= self.Append( struct.pack( "<BB", type_bool, index ) )
+			return self.bool_values[index]
+
+		if self.null_value is None:
+			self.null_value= self.Append( struct.pack( "<Bx", type_null ) )
+		return self.null_value
+
+	# Returns offset of null-terminated key string. Storage of string values is reused for keys.
+	def WriteKey( self, key ):
+		string_offset= self.string_values_pool.get( key, None )
+		if string_offset is not None:
+			return string_offset + 8
+
+		offset= self.keys_pool.get( key, None )
+		if offset is None:
+			offset= self.Append( key.encode( "utf-8" ) + b"\0" )
+			self.keys_pool[ key ]= offset
+		return offset
+
+	def AppendElement( self, body, body_relocations, value ):
+		if type(value) is tuple:
+			body.extend( struct.pack( "<Q", ( ( value[0] << 1 ) | 1 ) & 0xFFFFFFFFFFFFFFFF ) )
+		else:
+			body_relocations.append( len(body) )
+			body.extend( struct.pack( "<Q", value ) )
+
+	# Containers are pooled by their content. Equal children have same offsets, so, equal containers have equal content.
+	def WriteContainer( self, header, body, body_relocations ):
+		pool_key= bytes(header) + bytes(body)
+		offset= self.containers_pool.get( pool_key, None )
+		if offset is None:
+			offset= self.Append( pool_key )
+			body_offset= offset + len(header)
+			self.relocations.extend( body_offset + relocation for relocation in body_relocations )
+			self.containers_pool[ pool_key ]= offset
+		return offset
+
+	# Returns header and elements of packed array or None. Rules are same, as in "WritePackedNumberArray".
+	def MakePackedNumberArray( self, json_list ):
+		if len(json_list) == 0:
+			return None
+
+		for element in json_list:
+			if not ( type(element) is int or type(element) is float ):
+				return None
+
+		kinds= [ GetNumberKind( element ) for element in json_list ]
+		numbers= [ number for kind, number in kinds ]
+		if all( kind == "Int64" for kind, number in kinds ):
+			return struct.pack( "<BBxxI", type_array, array_layout_packed_int64s, len(json_list) ) + struct.pack( "<" + str(len(json_list)) + "q", *numbers )
+		if all( kind == "Double" for kind, number in kinds ):
+			return struct.pack( "<BBxxI", type_array, array_layout_packed_doubles, len(json_list) ) + struct.pack( "<" + str(len(json_list)) + "d", *numbers )
+		return None
+
+	# Returns snapshot bytes.
+	def Build( self, json_struct ):
+		root= self.WriteValue( json_struct, False )
+		self.Align()
+
+		relocations_data= struct.pack( "<" + str(len(self.relocations)) + "Q", *self.relocations )
+		header= bytearray( struct.pack( "<8sIIIIQQQQ", snapshot_magic, snapshot_endianness_tag, snapshot_version, snapshot_layout_signature,
+			0, root, len(self.storage), len(self.relocations), 0 ) )
+
+		checksum= CalculateSnapshotChecksum( relocations_data, CalculateSnapshotChecksum( self.storage, CalculateSnapshotChecksum( header, 14695981039346656037 ) ) )
+		struct.pack_into( "<Q", header, len(header) - 8, checksum )
+
+		return bytes(header) + bytes(self.storage) + relocations_data
+
+
+# FNV-1a for 64-bit words, same as in "snapshot.cpp".
+def CalculateSnapshotChecksum( data, hash ):
+	for word in struct.unpack( "<" + str(len(data) // 8) + "Q", data ):
+		hash= ( ( hash ^ word ) * 1099511628211 ) & 0xFFFFFFFFFFFFFFFF
+	return hash
+
+
+def WritePanzerJsonBlobCpp( json_struct, h_file_name, variable_name ):
+	blob= BlobBuilder().Build( json_struct )
+	words= struct.unpack( "<" + str(len(blob) // 8) + "Q", blob )
+
+	result= [ "#include <PanzerJson/snapshot.hpp>\n\n" ]
+	result.append( "#include \"" + h_file_name + "\"\n\n" )
+	result.append( "namespace\n{\n\n" )
+	result.append( "// Snapshot for 64-bit little-endian platforms.\n" )
+	result.append( "const uint64_t blob[" + str(len(words)) + "u]\n{\n" )
+	for i in range( 0, len(words), 8 ):
+		result.append( "\t" + "".join( "0x%016Xull, " % word for word in words[ i : i + 8 ] ) + "\n" )
+	result.append( "};\n\n" )
+	result.append( "} //namespace\n\n" )
+	result.append( "const PanzerJson::Parser::Result* " + variable_name + "()\n{\n" )
+	result.append( "\tstatic const PanzerJson::Parser::ResultPtr result= PanzerJson::Snapshot::Load( blob, sizeof(blob) );\n" )
+	result.append( "\treturn result.get();\n}\n" )
+	return "".join( result )
+
+
+def WritePanzerJsonBlobHpp( variable_name ):
+	result= "#pragma once\n"
+	result+= "#include <PanzerJson/parser.hpp>\n"
+	result+= "// Returns document, loaded from embedded snapshot. Returns null on platforms with other data layout.\n"
+	result+= "const PanzerJson::Parser::Result* " + variable_name + "();\n"
+	return result
+
+
 def main():
 	global save_string_for_numbers
 	global pack_strings_into_struct
+	global pack_number_arrays
 
 	parser = argparse.ArgumentParser(description='Process some integers.')
 	parser.add_argument( "-i", help= "input json file", type=str )
@@ -310,11 +611,14 @@ def main():
 	parser.add_argument( "-n", help= "name of result variable", type=str )
 	parser.add_argument( "-s", help= "save or not strings for numbers", action="store_true" )
 	parser.add_argument( "--do-not-pack-strings", help= "Do not pack string values into struct", action="store_true" )
+	parser.add_argument( "--do-not-pack-number-arrays", help= "Do not pack arrays of numbers", action="store_true" )
+	parser.add_argument( "--blob", help= "Write document as binary snapshot and function for its loading", action="store_true" )
 
 	args= parser.parse_args()
 
 	save_string_for_numbers= args.s
 	pack_strings_into_struct= not args.do_not_pack_strings
+	pack_number_arrays= not args.do_not_pack_number_arrays
 
 	print( "Convert \"" + args.i + "\" to \"" + args.o + "\"" )
 	if save_string_for_numbers:
@@ -339,8 +643,13 @@ def main():
 
 	file_content= LoadFile( args.i )
 	json_struct= ParseJson( file_content )
-	cpp_result= WritePanzerJsonCpp( json_struct, hpp_file, args.n )
-	hpp_result= WritePanzerJsonHpp( args.n )
+	if args.blob:
+		print( "Write blob" )
+		cpp_result= WritePanzerJsonBlobCpp( json_struct, hpp_file, args.n )
+		hpp_result= WritePanzerJsonBlobHpp( args.n )
+	else:
+		cpp_result= WritePanzerJsonCpp( json_struct, hpp_file, args.n )
+		hpp_result= WritePanzerJsonHpp( args.n )
 
 	WriteFile( cpp_file, cpp_result )
 	WriteFile( hpp_file, hpp_result )
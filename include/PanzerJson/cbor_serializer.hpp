@@ -0,0 +1,22 @@
+#pragma once
+#include "output_buffer.hpp"
+#include "value.hpp"
+
+namespace PanzerJson
+{
+
+// Serializer into CBOR (RFC 8949) binary format. Result may be parsed with "Parser::ParseCbor".
+// Integer numbers are written as integers, doubles - as shortest float (half, single or double), which stores them exactly.
+// Lengths are always definite. Strings with escape sequences are unescaped.
+class CborSerializer final
+{
+public:
+	void Serialize( Value value, OutputBuffer& out );
+
+private:
+	void Serialize_r( OutputBuffer& out, const ValueBase& value );
+	void SerializeElement( OutputBuffer& out, const ValueBase* value ); // Value may be inline number.
+	void SerializeNumber( OutputBuffer& out, const NumberValue& number );
+};
+
+} // namespace PanzerJson
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace PanzerJson
+{
+
+// Piece of output. Layout is same as for "iovec".
+struct OutputChunk final
+{
+	const void* data;
+	size_t size;
+};
+
+// Scatter-gather output - list of chunks.
+// Punctuation, numbers and escape sequences are copied into internal scratch storage.
+// Big parts of strings of document are not copied - chunks reference them directly.
+// So, output must live no longer, than serialized document.
+class ChunkedOutput final
+{
+public:
+	// Parts of strings, shorter, than "min_reference_size", are copied, because many small chunks are slower, than copying.
+	explicit ChunkedOutput( size_t min_reference_size= 64u );
+
+	ChunkedOutput( const ChunkedOutput& )= delete;
+	ChunkedOutput& operator=( const ChunkedOutput& )= delete;
+
+	// Copy data into scratch storage.
+	void Write( char c );
+	void Write( const char* data, size_t size );
+	// Reference data. Data must live longer, than output.
+	void WriteReference( const char* data, size_t size );
+
+	const OutputChunk* GetChunks() const noexcept;
+	size_t GetChunkCount() const noexcept;
+	// Total size of all chunks.
+	size_t GetSize() const noexcept;
+
+	void Clear() noexcept;
+
+private:
+	std::vector<OutputChunk> chunks_;
+	std::vector< std::unique_ptr<char[]> > scratch_blocks_;
+	char* scratch_cur_= nullptr;
+	char* scratch_end_= nullptr;
+	bool last_chunk_is_scratch_= false; // True, if last chunk ends at "scratch_cur_".
+	size_t size_= 0u;
+	const size_t min_reference_size_;
+};
+
+// Writes all chunks into file or socket descriptor with "writev". Handles partial writes.
+// Returns false on error. Available only on POSIX systems.
+bool WriteChunks( int fd, const OutputChunk* chunks, size_t chunk_count );
+
+} // namespace PanzerJson
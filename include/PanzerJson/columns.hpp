@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+
+#include "value.hpp"
+
+namespace PanzerJson
+{
+
+// Columnar (structure of arrays) representation of some members of array of objects.
+// Values of each column are placed in contiguous buffer, so, processing of them is cache-friendly and can be vectorized.
+
+enum class ColumnType : unsigned char
+{
+	Double,
+	Int64,
+	String,
+};
+
+struct ColumnDescription final
+{
+	StringType name;
+	ColumnType type;
+};
+
+class Column final
+{
+public:
+	ColumnType GetType() const noexcept;
+
+	// Returns rows count.
+	size_t GetSize() const noexcept;
+
+	// Values of column. Returns nullptr for columns of other type.
+	// Values for invalid rows are zeros or empty strings.
+	const double* GetDoubles() const noexcept;
+	const int64_t* GetInts() const noexcept;
+	const StringType* GetStrings() const noexcept;
+
+	// Bit "i % 64" of word "i / 64" is set, if row "i" has valid value.
+	// Last word bits after rows count are zeros.
+	const uint64_t* GetValidityBitmap() const noexcept;
+	bool IsValid( size_t row ) const noexcept;
+	size_t GetValidCount() const noexcept;
+
+private:
+	friend std::vector<Column> ExtractColumns( Value, const ColumnDescription*, size_t, unsigned int );
+
+	ColumnType type_= ColumnType::Double;
+	size_t size_= 0u;
+	std::vector<double> doubles_;
+	std::vector<int64_t> ints_;
+	std::vector<StringType> strings_;
+	std::vector<uint64_t> validity_;
+};
+
+// Extracts columns from array of objects. All columns are filled in one pass over rows.
+// Row value is valid, if row is object and it contains member of column type (number for numeric columns, string for string columns).
+// If "thread_count" > 1, rows are split between threads.
+// Strings are pointers to document strings, so, columns must live no longer, than document.
+// Returns empty columns if value is not array.
+std::vector<Column> ExtractColumns(
+	Value array,
+	const ColumnDescription* descriptions,
+	size_t column_count,
+	unsigned int thread_count= 1u );
+
+// Aggregates of valid rows of numeric column.
+// If there are no valid rows, "min" and "max" are zeros.
+template<class T>
+struct ColumnAggregates final
+{
+	size_t count;
+	T sum;
+	T min;
+	T max;
+};
+
+// Returns zeros for columns of other type.
+ColumnAggregates<double> AggregateDoubles( const Column& column ) noexcept;
+ColumnAggregates<int64_t> AggregateInts( const Column& column ) noexcept; // Sum wraps on overflow.
+
+} // namespace PanzerJson
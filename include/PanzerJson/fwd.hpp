@@ -12,9 +12,18 @@ struct StringValue;
 struct NumberValue;
 struct BoolValue;
 
+class Key;
 class Value;
 
 class Parser;
+class Snapshot;
 class Serializer;
+class OutputBuffer;
+class ChunkedOutput;
+class SerializationCache;
+class CborSerializer;
+class MessagePackSerializer;
+
+class Column;
 
 } // namespace PanzerJson
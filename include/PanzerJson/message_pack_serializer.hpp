@@ -0,0 +1,70 @@
+#pragma once
+#include <type_traits>
+#include "output_buffer.hpp"
+#include "value.hpp"
+
+namespace PanzerJson
+{
+
+// Serializer into MessagePack binary format. Result may be parsed with "Parser::ParseMessagePack".
+// Existing values are written with "AddValue". Also documents may be built directly, without creation of values.
+// Sizes of arrays and maps must be known before their elements - call "AddArray"/"AddMap" with count of elements,
+// than add all elements (for maps - key and value for each member).
+// Integers are written in shortest form, doubles - as float32, if this is exact, else as float64.
+// Strings, arrays and maps are limited by 2^32-1 bytes/elements. Bigger ones are refused - nothing is written and false is returned.
+// "AddValue" returns false, if some string or container of value is too big. Output is not valid MessagePack in this case.
+
+// Example:
+/*
+	OutputBuffer out;
+	MessagePackSerializer serializer( out );
+	serializer.AddMap( 2u );
+	serializer.AddString( "one" );
+	serializer.AddNumber( 1 );
+	serializer.AddString( "arr" );
+	serializer.AddArray( 2u );
+	serializer.AddNull();
+	serializer.AddValue( some_value );
+*/
+class MessagePackSerializer final
+{
+public:
+	explicit MessagePackSerializer( OutputBuffer& out ) noexcept;
+
+	bool AddValue( Value value );
+
+	void AddNull();
+	void AddBool( bool value );
+
+	template<class T>
+	typename std::enable_if< std::is_integral<T>::value && std::is_signed<T>::value, void >::type
+	AddNumber( const T number ) { AddNumberInternal( int64_t(number) ); }
+
+	template<class T>
+	typename std::enable_if< std::is_integral<T>::value && std::is_unsigned<T>::value, void >::type
+	AddNumber( const T number ) { AddNumberInternal( uint64_t(number) ); }
+
+	template<class T>
+	typename std::enable_if< std::is_floating_point<T>::value, void >::type
+	AddNumber( const T number ) { AddNumberInternal( double(number) ); }
+
+	bool AddString( const StringView& str );
+
+	bool AddArray( size_t element_count );
+	bool AddMap( size_t member_count );
+
+private:
+	void AddNumberInternal(  int64_t value );
+	void AddNumberInternal( uint64_t value );
+	void AddNumberInternal(   double value );
+
+	bool SerializeValue( const ValueBase& value );
+	bool SerializeElement( const ValueBase* value ); // Value may be inline number.
+	void SerializeNumber( const NumberValue& number );
+	void WriteHead( unsigned char format, uint64_t argument, size_t argument_size );
+
+private:
+	OutputBuffer& out_;
+};
+
+} // namespace PanzerJson
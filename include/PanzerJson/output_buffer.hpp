@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+
+#include "value.hpp"
+
+namespace PanzerJson
+{
+
+// Contiguous output buffer - fast sink for serializers.
+// Data is written with plain memory copying, without any virtual calls.
+// Buffer may be growable - it stores all output, or fixed - it passes its content into flush function, when it is full.
+class OutputBuffer final
+{
+public:
+	typedef void (*FlushFunction)( void* user_data, const char* data, size_t size );
+
+public:
+	// Growable buffer.
+	OutputBuffer() noexcept;
+	// Fixed buffer. Buffer memory must live longer, than OutputBuffer.
+	// Content is not flushed in destructor - call "Flush" at end of writing.
+	OutputBuffer( char* buffer, size_t buffer_size, FlushFunction flush_function, void* user_data ) noexcept;
+
+	OutputBuffer( const OutputBuffer& )= delete;
+	OutputBuffer& operator=( const OutputBuffer& )= delete;
+
+	void Write( char c );
+	void Write( const char* data, size_t size );
+
+	// Stream-like interface, so, buffer may be used in place of stl-like streams.
+	OutputBuffer& operator<<( char c );
+	OutputBuffer& operator<<( const char* str );
+	OutputBuffer& operator<<( const StringView& str );
+
+	// Direct writing. Returns pointer to space for at least "size" bytes.
+	// For fixed buffers "size" must be not greater, than buffer size.
+	// Call "Commit" with actually written size after writing.
+	char* Reserve( size_t size );
+	void Commit( size_t size ) noexcept;
+
+	// Pass content of fixed buffer into flush function. Does nothing for growable buffers.
+	void Flush();
+
+	// Content of growable buffer or not flushed content of fixed buffer.
+	const char* GetData() const noexcept;
+	size_t GetSize() const noexcept;
+
+	void Clear() noexcept;
+
+	bool IsGrowable() const noexcept;
+
+private:
+	void Overflow( size_t size );
+	void WriteSlow( const char* data, size_t size );
+
+private:
+	std::unique_ptr<char[]> storage_; // Only for growable buffers.
+	char* begin_;
+	char* cur_;
+	char* end_;
+	const FlushFunction flush_function_; // Null for growable buffers.
+	void* const user_data_;
+};
+
+} // namespace PanzerJson
+
+#include "output_buffer.inl"
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstring>
+
+namespace PanzerJson
+{
+
+inline void OutputBuffer::Write( const char c )
+{
+	if( cur_ == end_ )
+		Overflow( 1u );
+	*cur_= c;
+	++cur_;
+}
+
+inline void OutputBuffer::Write( const char* const data, const size_t size )
+{
+	if( size > static_cast<size_t>( end_ - cur_ ) )
+	{
+		WriteSlow( data, size );
+		return;
+	}
+	std::memcpy( cur_, data, size );
+	cur_+= size;
+}
+
+inline OutputBuffer& OutputBuffer::operator<<( const char c )
+{
+	Write( c );
+	return *this;
+}
+
+inline OutputBuffer& OutputBuffer::operator<<( const char* const str )
+{
+	Write( str, std::strlen( str ) );
+	return *this;
+}
+
+inline OutputBuffer& OutputBuffer::operator<<( const StringView& str )
+{
+	Write( str.data, str.size );
+	return *this;
+}
+
+inline char* OutputBuffer::Reserve( const size_t size )
+{
+	if( size > static_cast<size_t>( end_ - cur_ ) )
+		Overflow( size );
+	return cur_;
+}
+
+inline void OutputBuffer::Commit( const size_t size ) noexcept
+{
+	cur_+= size;
+}
+
+inline const char* OutputBuffer::GetData() const noexcept
+{
+	return begin_;
+}
+
+inline size_t OutputBuffer::GetSize() const noexcept
+{
+	return static_cast<size_t>( cur_ - begin_ );
+}
+
+inline void OutputBuffer::Clear() noexcept
+{
+	cur_= begin_;
+}
+
+inline bool OutputBuffer::IsGrowable() const noexcept
+{
+	return flush_function_ == nullptr;
+}
+
+} // namespace PanzerJson
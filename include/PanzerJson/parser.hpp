@@ -40,6 +40,7 @@ public:
 
 	private:
 		friend class Parser;
+		friend class Snapshot;
 		Result& operator=( const Result& )= delete;
 		Result( const Result& )= delete;
 
@@ -58,6 +59,18 @@ public:
 	ResultPtr Parse( const char* json_text_null_teriminated );
 	ResultPtr Parse( const char* json_text, size_t json_text_length );
 
+	// Parse CBOR (RFC 8949) data. Result has same structure, as for json, and uses same settings.
+	// Supported items are integers, floats, text strings, arrays, maps with text keys, null, undefined (as null), bools.
+	// Tags are skipped. Byte strings, other simple values and maps with not text keys are errors ("UnexpectedLexem").
+	// Error position is offset in bytes.
+	ResultPtr ParseCbor( const void* data, size_t data_size );
+
+	// Parse MessagePack data. Result has same structure, as for json, and uses same settings.
+	// Supported types are nil, bool, int, float, str, array and map with str keys.
+	// Bin and ext types and maps with not str keys are errors ("UnexpectedLexem").
+	// Error position is offset in bytes.
+	ResultPtr ParseMessagePack( const void* data, size_t data_size );
+
 	// Enable json root to be not only array or object.
 	void SetEnableNoncompositeJsonRoot( bool enable ) noexcept;
 	bool GetEnableNoncompositeJsonRoot() const noexcept;
@@ -70,17 +83,69 @@ public:
 	void SetSaveNumberStrings( bool save ) noexcept;
 	bool GetSaveNumberStrings() const noexcept;
 
+	// Store each unique object key only once.
+	// Objects with same keys will have same keys pointers, this reduces memory usage and speeds-up lookups via "Key".
+	void SetInternKeys( bool intern ) noexcept;
+	bool GetInternKeys() const noexcept;
+
+	// Store keys of objects with same keys only once, in shared shape. Objects with shapes store only values.
+	// Works only with keys interning.
+	void SetShareObjectShapes( bool share ) noexcept;
+	bool GetShareObjectShapes() const noexcept;
+
+	// Store only strings of numbers, convert them on access.
+	// Speed-ups parsing, if numbers are not accessed, and serializer writes original strings.
+	// Inline numbers and packed arrays are not used in this mode.
+	void SetLazyNumbers( bool lazy ) noexcept;
+	bool GetLazyNumbers() const noexcept;
+
+	// Store strings values with escape sequences as is, unescape them on first access.
+	// Serializer writes such strings without unescaping. Object keys are always unescaped.
+	void SetLazyStringsUnescaping( bool lazy ) noexcept;
+	bool GetLazyStringsUnescaping() const noexcept;
+
+	// Store arrays of numbers as plain arrays of int64 or double values, without separate value for each number.
+	// Only arrays, where all numbers are integers or all numbers are doubles, are packed, so, serialized result is same.
+	// Works only without saving of number strings and without lazy numbers.
+	void SetPackNumberArrays( bool pack ) noexcept;
+	bool GetPackNumberArrays() const noexcept;
+
 	void ResetCaches();
 
 private:
+	void StartParsing( const char* data, size_t data_size );
+	bool FinishParsing( const ValueBase* root ); // Returns false and sets error, if root is not allowed.
+	ResultPtr MakeResult( bool all_ok );
+
 	void PrepareFrequentValues();
+	// Pointers to frequent values in storage.
+	static const ValueBase* GetNullValue() noexcept;
+	static const ValueBase* GetBoolValue( bool value ) noexcept;
 	const ValueBase* Parse_r(); // Can set error flag.
-	StringType ParseString(); // Can set error flag.
+	const ValueBase* ParseCbor_r(); // Can set error flag.
+	bool ReadCborArgument( unsigned int additional_info, uint64_t& out_argument ); // Can set error flag.
+	StringType ParseCborString( uint64_t length, bool indefinite, size_t* out_length ); // Can set error flag.
+	const ValueBase* ParseMessagePack_r(); // Can set error flag.
+	bool ReadMessagePackUint( size_t size, uint64_t& out_value ); // Reads big-endian number. Can set error flag.
+	StringType ParseMessagePackString( uint64_t length ); // Can set error flag.
+	// Functions for values creation. Elements are taken from stacks, starting from given positions.
+	const ValueBase* CreateObject( size_t object_entries_stack_pos );
+	const ValueBase* CreateArray( size_t array_elements_stack_pos );
+	// String is null for numbers without string.
+	const ValueBase* CreateNumber( NumberValue::Kind kind, NumberValue::Payload payload, const char* str, size_t str_size );
+	StringType ParseString( bool keep_escapes= false, bool* out_has_escapes= nullptr, size_t* out_length= nullptr ); // Can set error flag.
+	StringType InternKey( StringType key );
+	size_t TryPackNumberArray( size_t array_elements_stack_pos ); // Returns 0, if array not packed.
+	size_t GetObjectShape( const ObjectValue::ObjectEntry* entries, size_t entries_count ); // Returns 0, if shape not created.
+	const char* GetStorageString( StringType str ) const;
 	void SkipWhitespaces(); // Can set error flag.
 	void SkipWhitespacesAtEnd(); // Can set error flag.
 
-	void CorrectPointers_r( ValueBase& value ); // Also, sorts objects keys.
+	void CorrectPointers_r( ValueBase& value );
+	void CorrectValuePointer_r( const ValueBase*& value ); // Value may be inline number.
+	void CorrectShapes();
 	StringType CorrectStringPointer( StringType str );
+	const void* CorrectPointer( const void* ptr );
 
 private:
 	const char* start_;
@@ -92,14 +157,42 @@ private:
 	bool enable_noncomposite_json_root_= true;
 	bool enable_comments_= true;
 	bool save_number_strings_= false;
+	bool intern_keys_= true;
+	bool share_object_shapes_= true;
+	bool pack_number_arrays_= true;
+	bool lazy_numbers_= false;
+	bool lazy_strings_unescaping_= false;
 
-	std::vector<unsigned char> number_digits_;
+	std::vector<uint64_t> packed_numbers_; // Temporary buffer for numbers of packed arrays.
 
 	// Stacks for temporary storing of array/object elements.
 	// Lower-level object can use stack, when upper-level object uses it.
 	// But, bweh parsing of lower-level was done, upper-level object can continue push values to this stack.
 	std::vector<const ValueBase*> array_elements_stack_;
 	std::vector<ObjectValue::ObjectEntry> object_entries_stack_;
+
+	// Hash table of keys, already placed into result storage.
+	// Open addressing is used. Zero offset means empty cell, because storage starts with frequent values, not strings.
+	struct InternedKey
+	{
+		size_t offset;
+		size_t length;
+		size_t hash;
+	};
+	std::vector<InternedKey> interned_keys_;
+	size_t interned_keys_count_= 0u;
+
+	// Hash table of objects keys sets.
+	// Shape created only for second object with same keys. Zero keys count means empty cell.
+	struct ObjectShapeInfo
+	{
+		size_t hash;
+		size_t key_count;
+		size_t first_object_offset;
+		size_t shape_offset;
+	};
+	std::vector<ObjectShapeInfo> object_shapes_;
+	size_t object_shapes_count_= 0u;
 };
 
 } // namespace PanzerJson
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+
+#include "value.hpp"
+
+namespace PanzerJson
+{
+
+// Serializer for nonblocking outputs, like sockets in event loops.
+// Serialized value is written by portions into buffers of any size.
+// When buffer is full, serialization is suspended and resumed by next call from exact position, even from middle of string.
+// Memory usage is independent of output size. Value must live longer, than serializer.
+// Output is same, as output of "Serializer".
+
+// Example:
+/*
+	ResumableSerializer serializer( value );
+	while( !serializer.IsFinished() )
+	{
+		const size_t size= serializer.Write( buffer, sizeof(buffer) );
+		// Send "size" bytes of buffer. If socket would block - wait and call "Write" with rest of buffer later.
+	}
+*/
+class ResumableSerializer final
+{
+public:
+	explicit ResumableSerializer( Value value );
+
+	void SetEscapeSlash( bool escape_slash ) noexcept;
+
+	// Writes next portion of output. Returns written size.
+	// Written size is less, than buffer size, only if serialization is finished.
+	size_t Write( char* buffer, size_t buffer_size );
+
+	bool IsFinished() const noexcept;
+
+private:
+	// Produces next output part - pending symbols or string.
+	void Step();
+	void StartValue( Value value );
+	void StartString( const char* data, size_t size, bool escape, char suffix );
+	void SetPendingNumber( Value value );
+
+private:
+	struct StackEntry
+	{
+		Value container;
+		size_t index;
+	};
+
+	std::vector<StackEntry> stack_;
+	Value next_value_;
+	bool has_next_value_= true;
+	bool escape_slash_= false;
+
+	// Current string. String is written by parts. Symbols with escape sequences are written via pending symbols.
+	const char* string_= nullptr;
+	size_t string_size_= 0u;
+	size_t string_pos_= 0u;
+	bool string_escape_= false; // False for strings, written as is (number strings, already escaped strings).
+	char string_suffix_= '\0'; // Symbol after string (':' for keys).
+	bool in_string_= false;
+
+	// Small parts of output - punctuation, numbers, escape sequences.
+	char pending_[64];
+	size_t pending_pos_= 0u;
+	size_t pending_size_= 0u;
+};
+
+} // namespace PanzerJson
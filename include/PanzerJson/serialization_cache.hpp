@@ -0,0 +1,46 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "value.hpp"
+
+namespace PanzerJson
+{
+
+// Cache of serialized form of objects and arrays.
+// Parsed and compiled values are immutable, so, serialized form of value never changes.
+// Cache is filled lazily by serializer with cache set and is used for values, passed into serializer.
+// Cache is bounded by memory budget - when it is exhausted, new values are not cached. Cached values are never evicted.
+// Cache is thread-safe. Cache must live longer, than results of zero-copy serialization, which may reference cached data.
+// Values are identified only by their addresses. So, storage of cached values (parse result, snapshot) must not be freed,
+// while cache is in use. If it is freed, "Clear" must be called before next usage of cache,
+// otherwise other value, placed at same address, gets serialized form of freed value.
+class SerializationCache final
+{
+public:
+	explicit SerializationCache( size_t memory_budget );
+
+	SerializationCache( const SerializationCache& )= delete;
+	SerializationCache& operator=( const SerializationCache& )= delete;
+
+	// Returns cached data or view with null data, if value is not cached.
+	StringView Find( const ValueBase* value, bool escape_slash ) const;
+	// Returns view of cached data or view with null data, if there is not enough memory budget.
+	StringView Insert( const ValueBase* value, bool escape_slash, const char* data, size_t size );
+
+	size_t GetUsedMemory() const;
+
+	// Not thread-safe. Invalidates all cached data. Must be called after freeing of storage of cached values.
+	void Clear() noexcept;
+
+private:
+	typedef std::unordered_map< const ValueBase*, std::string > MapType;
+
+	mutable std::mutex mutex_;
+	MapType cache_[2]; // For serialization with and without escaping of slash.
+	size_t used_memory_= 0u;
+	const size_t memory_budget_;
+};
+
+} // namespace PanzerJson
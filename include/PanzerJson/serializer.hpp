@@ -1,25 +1,128 @@
 #pragma once
+#include <vector>
+
+#include "chunked_output.hpp"
+#include "output_buffer.hpp"
+#include "serialization_cache.hpp"
 #include "value.hpp"
 #include "../../src/serializers_common.hpp"
 
 namespace PanzerJson
 {
 
-// Simple serializer. Uses stl-like streams.
+// Formatting policies for "Serializer::SerializeFormatted".
+
+struct CompactFormatting final
+{
+	static constexpr bool c_compact= true;
+	static constexpr char c_indent_symbol= ' ';
+	static constexpr size_t c_indent_size= 0u;
+	static constexpr size_t c_max_line_width= 0u;
+};
+
+// Each element of object or array is written at new line with indent.
+// If "max_line_width" is not zero, arrays and objects, which fit into line, are written in compact form in one line.
+// Indent symbol may be tab or space.
+template<char indent_symbol, size_t indent_size, size_t max_line_width= 0u>
+struct IndentFormatting final
+{
+	static_assert( indent_symbol == '\t' || indent_symbol == ' ', "only tabs and spaces are supported" );
+
+	static constexpr bool c_compact= false;
+	static constexpr char c_indent_symbol= indent_symbol;
+	static constexpr size_t c_indent_size= indent_size;
+	static constexpr size_t c_max_line_width= max_line_width;
+};
+
+template<size_t max_line_width= 0u>
+using TabsFormatting= IndentFormatting<'\t', 1u, max_line_width>;
+
+template<size_t spaces, size_t max_line_width= 0u>
+using SpacesFormatting= IndentFormatting<' ', spaces, max_line_width>;
+
+// Simple serializer.
+// Writes into output buffer. Stl-like streams (with "write" method) are supported via intermediate buffer.
 class Serializer final
 {
 public:
+	// Escape '/' as "\/". It is not required by json standard, so, it is disabled by default.
+	void SetEscapeSlash( bool escape_slash ) noexcept;
+
+	// Use cache of serialized values. Values (objects and arrays), passed into serializer, are taken from cache or added into it.
+	// Null - cache is not used (default). Documents of serialized values must live as long, as cache, or cache must be cleared after their freeing.
+	void SetCache( SerializationCache* cache ) noexcept;
+
+	void Serialize( Value value, OutputBuffer& out );
+
 	template<class Stream>
 	void Serialize( Value value, Stream& stream );
 
+	// Serialization with formatting policy, like "SpacesFormatting<4>".
+	// Compact policy is same as "Serialize" and has no overhead.
+	template<class Formatting>
+	void SerializeFormatted( Value value, OutputBuffer& out );
+	template<class Formatting, class Stream>
+	void SerializeFormatted( Value value, Stream& stream );
+
+	// Zero-copy serialization. Strings of document without escape sequences are referenced by output chunks.
+	// Result may be written with "WriteChunks".
+	void Serialize( Value value, ChunkedOutput& out );
+
+	// Two-phase serialization into preallocated memory, like network buffers.
+	// First, get exact size of result. It is cheap, because string lengths are known.
+	size_t GetSerializedSize( Value value );
+	// Than, write result into buffer with at least this size. No bounds checks are performed. Returns written size.
+	size_t SerializeToBuffer( Value value, char* buffer );
+
+	// Parallel version of "Serialize" for big values. Result is same.
+	// With cache set, value is serialized in one thread, since cached result needs no serialization at all.
+	// Large arrays and objects are split into chunks, which are serialized in "thread_count" threads.
+	// Exact sizes of chunks are calculated first, than chunks are written directly into their places in output.
+	void SerializeParallel( Value value, OutputBuffer& out, unsigned int thread_count );
+
 private:
-	template<class Stream>
-	void Serialize_r( Stream& stream, const ValueBase& value );
+	struct Chunk;
+
+	void SplitIntoChunks( Value value, size_t depth, size_t thread_count, std::vector<Chunk>& chunks ) const;
+	template<class Writer>
+	void SerializeChunk( Writer& out, const Chunk& chunk );
 
-	void GenNumberValueString( const NumberValue& number_value );
+	// "Writer" is class with methods "Write( char )" and "Write( const char*, size_t )".
+	template<class Writer>
+	void SerializeValue( Writer& out, Value value );
+	template<class Writer>
+	void SerializeCached( Writer& out, const ValueBase& value );
+	template<class Writer>
+	void Serialize_r( Writer& out, const ValueBase& value );
+	template<class Writer>
+	void SerializeElement( Writer& out, const ValueBase* value ); // Value may be inline number.
+	// Write range of members/elements, separated by commas. Comma is written before first member, if it is not first member of object.
+	template<class Writer>
+	void SerializeObjectMembers( Writer& out, const ObjectValue& object, size_t begin, size_t end );
+	template<class Writer>
+	void SerializeArrayElements( Writer& out, const ArrayValue& array, size_t begin, size_t end );
+
+	void SerializeIndented( OutputBuffer& out, Value value, char indent_symbol, size_t indent_size, size_t max_line_width );
+	void SerializeIndented_r( OutputBuffer& out, Value value, size_t depth, size_t column );
+	// Returns size of compact form, or some size greater, than limit, if limit is exceeded.
+	size_t GetCompactSizeLimited( Value value, size_t limit );
+
+	size_t GenNumberValueString( const NumberValue& number_value );
+
+	template<class Stream>
+	static void WriteToStream( void* stream, const char* data, size_t size );
 
 private:
+	static constexpr size_t c_stream_buffer_size= 4096u;
+
 	NumberStringStorage num_str_;
+	bool escape_slash_= false;
+	SerializationCache* cache_= nullptr;
+
+	// Parameters of current indented serialization.
+	char indent_symbol_= '\t';
+	size_t indent_size_= 0u;
+	size_t max_line_width_= 0u;
 };
 
 } // namespace PanzerJson
@@ -4,77 +4,37 @@ namespace PanzerJson
 {
 
 template<class Stream>
-void Serializer::Serialize_r( Stream& stream, const ValueBase& value )
+void Serializer::Serialize( const Value value, Stream& stream )
 {
-	switch(value.type)
-	{
-	case ValueBase::Type::Null:
-		stream << "null";
-		break;
-
-	case ValueBase::Type::Object:
-	{
-		const ObjectValue& object= static_cast<const ObjectValue&>(value);
-
-		stream << "{";
-
-		for( size_t i= 0u; i < object.object_count; i++ )
-		{
-			SerializeString( stream, object.GetEntries()[i].key );
-			stream << ":";
-			Serialize_r( stream, *object.GetEntries()[i].value );
-			if( i < object.object_count - 1u )
-				stream << ",";
-		}
-
-		stream << "}";
-	}
-	break;
-
-	case ValueBase::Type::Array:
-		{
-			const ArrayValue& array= static_cast<const ArrayValue&>(value);
-
-			stream << "[";
-
-			for( size_t i= 0u; i < array.object_count; i++ )
-			{
-				Serialize_r( stream, *array.GetElements()[i] );
-				if( i < array.object_count - 1u )
-					stream << ",";
-			}
-
-			stream << "]";
-		}
-		break;
-
-	case ValueBase::Type::String:
-		SerializeString( stream, static_cast<const StringValue&>(value).GetString() );
-		break;
+	// Serialize into fixed buffer on stack, flush it into stream, when it is full.
+	char buffer[ c_stream_buffer_size ];
+	OutputBuffer out( buffer, sizeof(buffer), &WriteToStream<Stream>, &stream );
+	Serialize( value, out );
+	out.Flush();
+}
 
-	case ValueBase::Type::Number:
-		{
-			const NumberValue& number_value= static_cast<const NumberValue&>(value);
-			if( number_value.has_string )
-				stream << number_value.GetString();
-			else
-			{
-				GenNumberValueString( number_value );
-				stream << num_str_.data();
-			}
-		}
-		break;
+template<class Formatting>
+void Serializer::SerializeFormatted( const Value value, OutputBuffer& out )
+{
+	if( Formatting::c_compact )
+		Serialize( value, out );
+	else
+		SerializeIndented( out, value, Formatting::c_indent_symbol, Formatting::c_indent_size, Formatting::c_max_line_width );
+}
 
-	case ValueBase::Type::Bool:
-		stream << ( static_cast<const BoolValue&>(value).value ? "true" : "false" );
-		break;
-	};
+template<class Formatting, class Stream>
+void Serializer::SerializeFormatted( const Value value, Stream& stream )
+{
+	char buffer[ c_stream_buffer_size ];
+	OutputBuffer out( buffer, sizeof(buffer), &WriteToStream<Stream>, &stream );
+	SerializeFormatted<Formatting>( value, out );
+	out.Flush();
 }
 
 template<class Stream>
-void Serializer::Serialize( const Value value, Stream& stream )
+void Serializer::WriteToStream( void* const stream, const char* const data, const size_t size )
 {
-	Serialize_r( stream, *value.GetInternalValue() );
+	static_cast<Stream*>(stream)->write( data, size );
 }
 
 } // namespace PanzerJson
@@ -0,0 +1,28 @@
+#pragma once
+#include "output_buffer.hpp"
+#include "parser.hpp"
+
+namespace PanzerJson
+{
+
+// Binary snapshots of parse results.
+// Snapshot is image of result storage, where pointers are replaced with offsets, plus list of these offsets (relocations).
+// Loading of snapshot is copying of storage and adding of its address to relocated pointers - without any parsing.
+// Snapshot has header with format version, endianness tag, pointer size and sizes of value structures,
+// and checksum of its content. Snapshots are loaded only on platforms with same data layout.
+// Checksum detects corruption, but not malicious modification - load only trusted snapshots.
+class Snapshot final
+{
+public:
+	// Result must be successful.
+	// Do not save result, when other threads read its lazily unescaped strings or lazy numbers.
+	static void Save( const Parser::Result& result, OutputBuffer& out );
+	static bool SaveFile( const Parser::Result& result, const char* file_name );
+
+	// Returns null, if snapshot is invalid or was written on platform with other data layout.
+	static Parser::ResultPtr Load( const void* data, size_t size );
+	// Maps file into memory on POSIX systems, reads it on other systems.
+	static Parser::ResultPtr LoadFile( const char* file_name );
+};
+
+} // namespace PanzerJson
@@ -1,4 +1,6 @@
 #pragma once
+#include "output_buffer.hpp"
+#include "serializer.hpp"
 #include "value.hpp"
 
 namespace PanzerJson
@@ -11,7 +13,8 @@ enum class SerializationFormatting
 };
 
 // Serializer, that generate json structure "on-fly".
-// Input sream class must supports operator<<(const char*).
+// Output class must supports operator<<(char) and operator<<(const char*).
+// Fastest output is OutputBuffer - it is used by default.
 
 // Usage:
 // Create object with stream. Call, call "AddObject" or "AddArray" method and
@@ -21,10 +24,13 @@ enum class SerializationFormatting
 // ObjectSerializer/ArraySerializer.
 // Note - when child object/array is alive, addition of elements to parent
  // (and parent of parent, etc.) object/array is forbidden.
+// Existing values may be added with "AddValue", already serialized json fragments - with "AddRaw".
+// For these methods stl-like streams must have "write" method. Such elements are written without indents.
 
 // Example:
 /*
-	StreamedSerializer<std::istringstream> serializer(stream);
+	OutputBuffer out;
+	StreamedSerializer<> serializer(out);
 	{
 		auto object= serializer.AddObject();
 		object.AddNumber( "one", 1 );
@@ -43,8 +49,30 @@ enum class SerializationFormatting
 	}
 */
 
+// Object key, quoted and escaped at compile time. Writing of such key is just copying.
+// Create it with macro "PJ_PREPARED_KEY", like PJ_PREPARED_KEY( "name" ).
+// Key literal must not contain symbols, which need escaping.
+struct PreparedKey final
+{
+	const char* quoted; // "key": , null-terminated.
+	size_t size;
+};
+
+// Returns true, if string does not contain symbols, which need escaping.
+constexpr bool IsPlainKeyString( const char* const s ) noexcept
+{
+	return *s == '\0' ||
+		( *s != '"' && *s != '\\' && static_cast<unsigned char>(*s) >= 0x20u && IsPlainKeyString( s + 1 ) );
+}
+
+template<bool is_plain> struct PreparedKeyCheck;
+template<> struct PreparedKeyCheck<true> { static constexpr size_t size= 0u; };
+
+#define PJ_PREPARED_KEY( key ) \
+	( ::PanzerJson::PreparedKey{ "\"" key "\":", sizeof(key) + 2u + ::PanzerJson::PreparedKeyCheck< ::PanzerJson::IsPlainKeyString( key ) >::size } )
+
 template<
-	class StreamT,
+	class StreamT= OutputBuffer,
 	SerializationFormatting formatting= SerializationFormatting::Compact>
 class StreamedSerializer final
 {
@@ -64,8 +92,12 @@ public:
 		void AddNull();
 		ObjectSerializer AddObject();
 		ArraySerializer AddArray();
-		void AddString( const StringType& string );
+		void AddString( const StringView& string );
 		void AddBool( bool val );
+		// Value is written by Serializer, optionally with cache of serialized values.
+		void AddValue( Value value, SerializationCache* cache= nullptr );
+		// Fragment must be valid json value. It is checked in debug builds.
+		void AddRaw( const StringView& fragment );
 
 		template<class T>
 		typename std::enable_if< std::is_integral<T>::value && std::is_signed<T>::value, void >::type
@@ -79,13 +111,20 @@ public:
 		typename std::enable_if< std::is_floating_point<T>::value, void >::type
 		AddNumber( T number );
 
+		// Bulk addition of elements. Faster, than addition of elements one by one.
+		// Numbers are formatted by blocks and written into stream with one call per block.
+		template<class T>
+		typename std::enable_if< std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, void >::type
+		AddNumbers( const T* numbers, size_t count );
+		void AddStrings( const StringView* strings, size_t count );
+		void AddBools( const bool* values, size_t count );
+
 	private:
 		void AddNumberInternal(   double number );
 		void AddNumberInternal(  int64_t number );
 		void AddNumberInternal( uint64_t number );
 
-		void StartNewElement( bool new_element_is_composite= false );
-		void PrintIndents();
+		void StartNewElement();
 
 	private:
 		explicit ArraySerializer( StreamT& stream, size_t parent_indent );
@@ -95,11 +134,30 @@ public:
 	private:
 		StreamT* stream_; // null means moved
 		size_t element_count_= 0u;
-		size_t indent_;
+		size_t indent_; // Indent of elements.
 	};
 
 	class ObjectSerializer final
 	{
+	public:
+		// Key argument - plain or prepared key.
+		class KeyArg final
+		{
+		public:
+			KeyArg( const StringType key ) noexcept
+				: str_(key), prepared_size_(0u)
+			{}
+
+			KeyArg( const PreparedKey& prepared ) noexcept
+				: str_(prepared.quoted), prepared_size_(prepared.size)
+			{}
+
+		private:
+			friend class ObjectSerializer;
+			const char* const str_;
+			const size_t prepared_size_; // Zero for plain keys.
+		};
+
 	public:
 		ObjectSerializer( const ArraySerializer& )= delete;
 		ObjectSerializer& operator=( const ArraySerializer& )= delete;
@@ -107,32 +165,33 @@ public:
 		ObjectSerializer( ObjectSerializer&& other ) noexcept;
 		~ObjectSerializer();
 
-		void AddNull( const StringType& key );
-		ObjectSerializer AddObject( const StringType& key );
-		ArraySerializer AddArray( const StringType& key );
-		void AddString( const StringType& key, const StringType& string );
-		void AddBool( const StringType& key, bool val );
+		void AddNull( const KeyArg& key );
+		ObjectSerializer AddObject( const KeyArg& key );
+		ArraySerializer AddArray( const KeyArg& key );
+		void AddString( const KeyArg& key, const StringView& string );
+		void AddBool( const KeyArg& key, bool val );
+		void AddValue( const KeyArg& key, Value value, SerializationCache* cache= nullptr );
+		void AddRaw( const KeyArg& key, const StringView& fragment );
 
 		template<class T>
 		typename std::enable_if< std::is_integral<T>::value && std::is_signed<T>::value, void >::type
-		AddNumber( const StringType& key, T number );
+		AddNumber( const KeyArg& key, T number );
 
 		template<class T>
 		typename std::enable_if< std::is_integral<T>::value && std::is_unsigned<T>::value, void >::type
-		AddNumber( const StringType& key, T number );
+		AddNumber( const KeyArg& key, T number );
 
 		template<class T>
 		typename std::enable_if< std::is_floating_point<T>::value, void >::type
-		AddNumber( const StringType& key, T number );
+		AddNumber( const KeyArg& key, T number );
 
 	private:
-		void AddNumberInternal( const StringType& key,   double number );
-		void AddNumberInternal( const StringType& key,  int64_t number );
-		void AddNumberInternal( const StringType& key, uint64_t number );
+		void AddNumberInternal( const KeyArg& key,   double number );
+		void AddNumberInternal( const KeyArg& key,  int64_t number );
+		void AddNumberInternal( const KeyArg& key, uint64_t number );
 
-		void WriteKey( const StringType& key );
+		void WriteKey( const KeyArg& key );
 		void StartNewElement();
-		void PrintIndents();
 
 	private:
 		explicit ObjectSerializer( StreamT& stream, size_t parent_indent );
@@ -142,7 +201,7 @@ public:
 	private:
 		StreamT* stream_; // null means moved
 		size_t element_count_= 0u;
-		size_t indent_;
+		size_t indent_; // Indent of elements.
 	};
 
 public:
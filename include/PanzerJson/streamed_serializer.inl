@@ -1,5 +1,8 @@
-#include "../src/serializers_common.hpp"
-#include "../src/panzer_json_assert.hpp"
+#include <algorithm>
+#include <cstring>
+#include "../../src/numbers_formatting.hpp"
+#include "../../src/serializers_common.hpp"
+#include "../../src/panzer_json_assert.hpp"
 
 namespace PanzerJson
 {
@@ -30,18 +33,9 @@ StreamedSerializer<StreamT, formatting>::AddArray()
 template<class StreamT, SerializationFormatting formatting>
 StreamedSerializer<StreamT, formatting>::ArraySerializer::ArraySerializer( StreamT& stream, const size_t parent_indent )
 	: stream_( &stream )
-	, indent_( parent_indent )
+	, indent_( parent_indent + 1u )
 {
-	if( formatting == SerializationFormatting::TabIndents )
-	{
-		PrintIndents();
-		stream << '[';
-		PrintIndents();
-		stream << '\n';
-		indent_++;
-	}
-	else
-		stream << '[';
+	stream << '[';
 }
 
 template<class StreamT, SerializationFormatting formatting>
@@ -59,13 +53,9 @@ StreamedSerializer<StreamT, formatting>::ArraySerializer::~ArraySerializer()
 {
 	if( stream_ != nullptr )
 	{
-		if( formatting == SerializationFormatting::TabIndents )
-		{
-			indent_--;
-			if( element_count_ > 0u )
-				*stream_ << '\n';
-			PrintIndents();
-		}
+		// Empty containers are written in one line.
+		if( formatting == SerializationFormatting::TabIndents && element_count_ > 0u )
+			WriteNewLine( *stream_, '\t', indent_ - 1u );
 		*stream_ << ']';
 	}
 }
@@ -83,9 +73,7 @@ typename StreamedSerializer<StreamT, formatting>::ObjectSerializer
 StreamedSerializer<StreamT, formatting>::ArraySerializer::AddObject()
 {
 	PJ_ASSERT( stream_ != nullptr );
-	StartNewElement( true );
-	if( formatting == SerializationFormatting::TabIndents )
-		*stream_ << '\n';
+	StartNewElement();
 	return ObjectSerializer( *stream_, indent_ );
 }
 
@@ -94,14 +82,12 @@ typename StreamedSerializer<StreamT, formatting>::ArraySerializer
 StreamedSerializer<StreamT, formatting>::ArraySerializer::AddArray()
 {
 	PJ_ASSERT( stream_ != nullptr );
-	StartNewElement( true );
-	if( formatting == SerializationFormatting::TabIndents )
-		*stream_ << '\n';
+	StartNewElement();
 	return ArraySerializer( *stream_, indent_ );
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddString( const StringType& string )
+void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddString( const StringView& string )
 {
 	PJ_ASSERT( stream_ != nullptr );
 	StartNewElement();
@@ -113,7 +99,26 @@ void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddBool( const bo
 {
 	PJ_ASSERT( stream_ != nullptr );
 	StartNewElement();
-	*stream_ << val ? "true" : "false";
+	*stream_ << ( val ? "true" : "false" );
+}
+
+template<class StreamT, SerializationFormatting formatting>
+void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddValue( const Value value, SerializationCache* const cache )
+{
+	PJ_ASSERT( stream_ != nullptr );
+	StartNewElement();
+	Serializer serializer;
+	serializer.SetCache( cache );
+	serializer.Serialize( value, *stream_ );
+}
+
+template<class StreamT, SerializationFormatting formatting>
+void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddRaw( const StringView& fragment )
+{
+	PJ_ASSERT( stream_ != nullptr );
+	PJ_ASSERT( IsValidJsonFragment( fragment ) );
+	StartNewElement();
+	WriteStringView( *stream_, fragment );
 }
 
 template<class StreamT, SerializationFormatting formatting>
@@ -147,8 +152,7 @@ void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddNumberInternal
 	StartNewElement();
 
 	NumberStringStorage num_str;
-	GenDoubleValueString( number, num_str );
-	*stream_ << num_str.data();
+	WriteNumberString( *stream_, num_str, GenDoubleValueString( number, num_str ) );
 }
 
 template<class StreamT, SerializationFormatting formatting>
@@ -158,8 +162,7 @@ void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddNumberInternal
 	StartNewElement();
 
 	NumberStringStorage num_str;
-	GenIntValueString( number, num_str );
-	*stream_ << num_str.data();
+	WriteNumberString( *stream_, num_str, GenIntValueString( number, num_str ) );
 }
 
 template<class StreamT, SerializationFormatting formatting>
@@ -169,35 +172,106 @@ void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddNumberInternal
 	StartNewElement();
 
 	NumberStringStorage num_str;
-	GenUintValueString( number, num_str );
-	*stream_ << num_str.data();
+	WriteNumberString( *stream_, num_str, GenUintValueString( number, num_str ) );
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ArraySerializer::StartNewElement( const bool new_element_is_composite )
+template<class T>
+typename std::enable_if< std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, void >::type
+StreamedSerializer<StreamT, formatting>::ArraySerializer::AddNumbers( const T* const numbers, const size_t count )
 {
+	typedef typename std::conditional<
+		std::is_floating_point<T>::value,
+		double,
+		typename std::conditional< std::is_signed<T>::value, int64_t, uint64_t >::type >::type NumberType;
+
 	PJ_ASSERT( stream_ != nullptr );
 
-	if( element_count_ != 0u )
+	if( formatting == SerializationFormatting::TabIndents )
 	{
-		if( formatting == SerializationFormatting::TabIndents && !new_element_is_composite )
-			*stream_ << ",\n";
-		else
-			*stream_ << ',';
+		for( size_t i= 0u; i < count; i++ )
+			AddNumberInternal( static_cast<NumberType>( numbers[i] ) );
+		return;
+	}
+
+	const size_t c_block_size= 16u;
+	char block[ c_block_size * ( c_max_formatted_number_length + 1u ) + 1u ];
+	for( size_t i= 0u; i < count; i+= c_block_size )
+	{
+		const size_t block_end= std::min( i + c_block_size, count );
+		char* cur= block;
+		for( size_t j= i; j < block_end; j++ )
+		{
+			if( element_count_ + j != 0u )
+			{
+				*cur= ',';
+				++cur;
+			}
+			cur+= FormatNumber( static_cast<NumberType>( numbers[j] ), cur );
+		}
+		*cur= '\0';
+		WriteKnownLengthString( *stream_, block, static_cast<size_t>( cur - block ) );
+	}
+	element_count_+= count;
+}
+
+template<class StreamT, SerializationFormatting formatting>
+void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddStrings( const StringView* const strings, const size_t count )
+{
+	PJ_ASSERT( stream_ != nullptr );
+	for( size_t i= 0u; i < count; i++ )
+	{
+		StartNewElement();
+		SerializeString( *stream_, strings[i] );
+	}
+}
+
+template<class StreamT, SerializationFormatting formatting>
+void StreamedSerializer<StreamT, formatting>::ArraySerializer::AddBools( const bool* const values, const size_t count )
+{
+	PJ_ASSERT( stream_ != nullptr );
+
+	if( formatting == SerializationFormatting::TabIndents )
+	{
+		for( size_t i= 0u; i < count; i++ )
+			AddBool( values[i] );
+		return;
 	}
-	element_count_++;
 
-	PrintIndents();
+	const size_t c_block_size= 64u;
+	char block[ c_block_size * 6u + 1u ];
+	for( size_t i= 0u; i < count; i+= c_block_size )
+	{
+		const size_t block_end= std::min( i + c_block_size, count );
+		char* cur= block;
+		for( size_t j= i; j < block_end; j++ )
+		{
+			if( element_count_ + j != 0u )
+			{
+				*cur= ',';
+				++cur;
+			}
+			// Copy 5 bytes for both values, but advance only by actual length.
+			std::memcpy( cur, values[j] ? "true," : "false", 5u );
+			cur+= values[j] ? 4u : 5u;
+		}
+		*cur= '\0';
+		WriteKnownLengthString( *stream_, block, static_cast<size_t>( cur - block ) );
+	}
+	element_count_+= count;
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ArraySerializer::PrintIndents()
+void StreamedSerializer<StreamT, formatting>::ArraySerializer::StartNewElement()
 {
 	PJ_ASSERT( stream_ != nullptr );
 
+	if( element_count_ != 0u )
+		*stream_ << ',';
+	element_count_++;
+
 	if( formatting == SerializationFormatting::TabIndents )
-		for( size_t i= 0u; i < indent_; i++ )
-			*stream_ << '\t';
+		WriteNewLine( *stream_, '\t', indent_ );
 }
 
 // ObjectSerializer
@@ -205,18 +279,9 @@ void StreamedSerializer<StreamT, formatting>::ArraySerializer::PrintIndents()
 template<class StreamT, SerializationFormatting formatting>
 StreamedSerializer<StreamT, formatting>::ObjectSerializer::ObjectSerializer( StreamT& stream, const size_t parent_indent )
 	: stream_( &stream )
-	, indent_( parent_indent )
+	, indent_( parent_indent + 1u )
 {
-	if( formatting == SerializationFormatting::TabIndents )
-	{
-		PrintIndents();
-		stream << '{';
-		PrintIndents();
-		stream << '\n';
-		indent_++;
-	}
-	else
-		stream << '{';
+	stream << '{';
 }
 
 template<class StreamT, SerializationFormatting formatting>
@@ -234,19 +299,15 @@ StreamedSerializer<StreamT, formatting>::ObjectSerializer::~ObjectSerializer()
 {
 	if( stream_ != nullptr )
 	{
-		if( formatting == SerializationFormatting::TabIndents )
-		{
-			indent_--;
-			if( element_count_ > 0u )
-				*stream_ << '\n';
-			PrintIndents();
-		}
+		// Empty containers are written in one line.
+		if( formatting == SerializationFormatting::TabIndents && element_count_ > 0u )
+			WriteNewLine( *stream_, '\t', indent_ - 1u );
 		*stream_ << '}';
 	}
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNull( const StringType& key )
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNull( const KeyArg& key )
 {
 	PJ_ASSERT( stream_ != nullptr );
 	WriteKey( key );
@@ -255,28 +316,24 @@ void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNull( const S
 
 template<class StreamT, SerializationFormatting formatting>
 typename StreamedSerializer<StreamT, formatting>::ObjectSerializer
-StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddObject( const StringType& key )
+StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddObject( const KeyArg& key )
 {
 	PJ_ASSERT( stream_ != nullptr );
 	WriteKey( key );
-	if( formatting == SerializationFormatting::TabIndents )
-		*stream_ << '\n';
 	return ObjectSerializer( *stream_, indent_ );
 }
 
 template<class StreamT, SerializationFormatting formatting>
 typename StreamedSerializer<StreamT, formatting>::ArraySerializer
-StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddArray( const StringType& key )
+StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddArray( const KeyArg& key )
 {
 	PJ_ASSERT( stream_ != nullptr );
 	WriteKey( key );
-	if( formatting == SerializationFormatting::TabIndents )
-		*stream_ << '\n';
 	return ArraySerializer( *stream_, indent_ );
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddString( const StringType& key, const StringType& string )
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddString( const KeyArg& key, const StringView& string )
 {
 	PJ_ASSERT( stream_ != nullptr );
 	WriteKey(key);
@@ -284,17 +341,36 @@ void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddString( const
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddBool( const StringType& key, const bool val )
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddBool( const KeyArg& key, const bool val )
+{
+	PJ_ASSERT( stream_ != nullptr );
+	WriteKey(key);
+	*stream_ << ( val ? "true" : "false" );
+}
+
+template<class StreamT, SerializationFormatting formatting>
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddValue( const KeyArg& key, const Value value, SerializationCache* const cache )
 {
 	PJ_ASSERT( stream_ != nullptr );
 	WriteKey(key);
-	*stream_ << val ? "true" : "false";
+	Serializer serializer;
+	serializer.SetCache( cache );
+	serializer.Serialize( value, *stream_ );
+}
+
+template<class StreamT, SerializationFormatting formatting>
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddRaw( const KeyArg& key, const StringView& fragment )
+{
+	PJ_ASSERT( stream_ != nullptr );
+	PJ_ASSERT( IsValidJsonFragment( fragment ) );
+	WriteKey(key);
+	WriteStringView( *stream_, fragment );
 }
 
 template<class StreamT, SerializationFormatting formatting>
 template<class T>
 typename std::enable_if< std::is_integral<T>::value && std::is_signed<T>::value, void >::type
-StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumber( const StringType& key, const T number )
+StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumber( const KeyArg& key, const T number )
 {
 	AddNumberInternal( key, static_cast<int64_t>( number ) );
 }
@@ -302,7 +378,7 @@ StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumber( const Stri
 template<class StreamT, SerializationFormatting formatting>
 template<class T>
 typename std::enable_if< std::is_integral<T>::value && std::is_unsigned<T>::value, void >::type
-StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumber( const StringType& key, const T number )
+StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumber( const KeyArg& key, const T number )
 {
 	AddNumberInternal( key, static_cast<uint64_t>( number ) );
 }
@@ -310,80 +386,72 @@ StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumber( const Stri
 template<class StreamT, SerializationFormatting formatting>
 template<class T>
 typename std::enable_if< std::is_floating_point<T>::value, void >::type
-StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumber( const StringType& key, const T number )
+StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumber( const KeyArg& key, const T number )
 {
 	AddNumberInternal( key, static_cast<double>( number ) );
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumberInternal( const StringType& key, const double number )
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumberInternal( const KeyArg& key, const double number )
 {
 	PJ_ASSERT( stream_ != nullptr );
 	WriteKey(key);
 
 	NumberStringStorage num_str;
-	GenDoubleValueString( number, num_str );
-	*stream_ << num_str.data();
+	WriteNumberString( *stream_, num_str, GenDoubleValueString( number, num_str ) );
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumberInternal( const StringType& key, const int64_t number )
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumberInternal( const KeyArg& key, const int64_t number )
 {
 	PJ_ASSERT( stream_ != nullptr );
 	WriteKey(key);
 
 	NumberStringStorage num_str;
-	GenIntValueString( number, num_str );
-	*stream_ << num_str.data();
+	WriteNumberString( *stream_, num_str, GenIntValueString( number, num_str ) );
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumberInternal( const StringType& key, const uint64_t number )
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::AddNumberInternal( const KeyArg& key, const uint64_t number )
 {
 	PJ_ASSERT( stream_ != nullptr );
 	WriteKey(key);
 
 	NumberStringStorage num_str;
-	GenUintValueString( number, num_str );
-	*stream_ << num_str.data();
+	WriteNumberString( *stream_, num_str, GenUintValueString( number, num_str ) );
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ObjectSerializer::WriteKey( const StringType& key )
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::WriteKey( const KeyArg& key )
 {
 	StartNewElement();
-	SerializeString( *stream_, key );
-	if( formatting == SerializationFormatting::TabIndents )
-		*stream_ << ": ";
+	if( key.prepared_size_ != 0u )
+	{
+		WriteKnownLengthString( *stream_, key.str_, key.prepared_size_ );
+		if( formatting == SerializationFormatting::TabIndents )
+			*stream_ << ' ';
+	}
 	else
-		*stream_ << ':';
-}
-
-template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ObjectSerializer::StartNewElement()
-{
-	PJ_ASSERT( stream_ != nullptr );
-
-	if( element_count_ != 0u )
 	{
+		SerializeString( *stream_, key.str_ );
 		if( formatting == SerializationFormatting::TabIndents )
-			*stream_ << ",\n";
+			*stream_ << ": ";
 		else
-			*stream_ << ',';
+			*stream_ << ':';
 	}
-	element_count_++;
-
-	PrintIndents();
 }
 
 template<class StreamT, SerializationFormatting formatting>
-void StreamedSerializer<StreamT, formatting>::ObjectSerializer::PrintIndents()
+void StreamedSerializer<StreamT, formatting>::ObjectSerializer::StartNewElement()
 {
 	PJ_ASSERT( stream_ != nullptr );
 
+	if( element_count_ != 0u )
+		*stream_ << ',';
+	element_count_++;
+
 	if( formatting == SerializationFormatting::TabIndents )
-		for( size_t i= 0u; i < indent_; i++ )
-			*stream_ << '\t';
+		WriteNewLine( *stream_, '\t', indent_ );
 }
 
 } // namespace PanzerJson
@@ -1,6 +1,9 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <type_traits>
 #include <utility>
 
 #include "fwd.hpp"
@@ -10,11 +13,47 @@ namespace PanzerJson
 
 // String type is null-terminated UTF-8.
 // TODO - maybe add support for width encodings?
-// TODO - maybe support string views?
 using StringType= const char*;
-int StringCompare( const StringType& l, const StringType& r ) noexcept;
 
-struct ValueBase
+// UTF-8 string with explicit length. May contain null symbols and may be not null-terminated.
+struct StringView final
+{
+	const char* data;
+	size_t size;
+
+	StringView() noexcept
+		: data(""), size(0u)
+	{}
+
+	StringView( const char* const in_data, const size_t in_size ) noexcept
+		: data(in_data), size(in_size)
+	{}
+
+	StringView( const StringType str ) noexcept
+		: data(str), size( std::strlen(str) )
+	{}
+
+	// Construction from any string class with "data()" and "size()" methods, like "std::string" or "std::string_view".
+	template<
+		class S,
+		class= typename std::enable_if< std::is_convertible< decltype( std::declval<const S&>().data() ), const char* >::value >::type>
+	StringView( const S& str ) noexcept
+		: data( str.data() ), size( str.size() )
+	{}
+
+	const char* begin() const noexcept { return data; }
+	const char* end() const noexcept { return data + size; }
+};
+
+int StringCompare( const StringType& l, const StringType& r ) noexcept;
+// Result is same as for "StringCompare" for strings without null symbols. String with null symbols is greater, than its prefix.
+int StringCompare( const StringView& l, const StringType& r ) noexcept;
+size_t StringHash( const char* str, size_t length ) noexcept;
+
+// All values are at least 2-byte aligned, so, lowest bit of pointers to values is always zero.
+// Small integer numbers may be stored directly in pointers to values (elements of arrays, members of objects).
+// Such pointers have lowest bit set.
+struct alignas(2) ValueBase
 {
 	enum class Type : unsigned char
 	{
@@ -32,6 +71,13 @@ struct ValueBase
 	{}
 };
 
+constexpr int64_t c_min_inline_number= -( int64_t(1) << 30 );
+constexpr int64_t c_max_inline_number= +( int64_t(1) << 30 ) - 1;
+
+bool IsInlineNumber( const ValueBase* value ) noexcept;
+int64_t GetInlineNumber( const ValueBase* value ) noexcept; // Valid only for inline numbers.
+const ValueBase* MakeInlineNumber( int64_t number ) noexcept; // Number must be in inline numbers range.
+
 struct NullValue final : public ValueBase
 {
 	constexpr NullValue() noexcept
@@ -39,26 +85,85 @@ struct NullValue final : public ValueBase
 	{}
 };
 
+// Shape of object - sorted list of its keys.
+// Objects with same keys may share one shape, so, they need to store only values.
+struct ObjectShape final
+{
+	// Pointer-sized, because keys are placed just after it.
+	size_t key_count;
+
+	explicit constexpr ObjectShape( const size_t in_key_count ) noexcept
+		: key_count(in_key_count)
+	{}
+
+	const StringType* GetKeys() const noexcept
+	{
+		// Shapes stores their keys just after it.
+		return reinterpret_cast<const StringType*>(this + 1u);
+	}
+};
+
+template<size_t N>
+struct ObjectShapeWithKeysStorage final
+{
+	ObjectShape shape;
+	// WARNING! Keys must be sorted!
+	StringType keys[N];
+};
+
 struct ObjectValue final : public ValueBase
 {
+	enum class Layout : unsigned char
+	{
+		Entries, // Key-value pairs are stored just after object.
+		Shaped, // Pointer to shape and values are stored just after object.
+	};
+
 	struct ObjectEntry final
 	{
 		StringType key;
 		const ValueBase* value;
 	};
 
+	Layout layout;
 	uint32_t object_count;
 
-	explicit constexpr ObjectValue( const uint32_t in_object_count ) noexcept
+	explicit constexpr ObjectValue( const uint32_t in_object_count, const Layout in_layout= Layout::Entries ) noexcept
 		: ValueBase(Type::Object)
+		, layout(in_layout)
 		, object_count(in_object_count)
 	{}
 
+	// Valid only for "Entries" layout.
 	const ObjectEntry* GetEntries() const noexcept
 	{
 		// Objects stores their members just after it.
 		return reinterpret_cast<const ObjectEntry*>(this + 1u);
 	}
+
+	// Valid only for "Shaped" layout.
+	const ObjectShape* GetShape() const noexcept
+	{
+		return *reinterpret_cast<const ObjectShape* const*>(this + 1u);
+	}
+
+	// Valid only for "Shaped" layout.
+	const ValueBase* const* GetShapedValues() const noexcept
+	{
+		// Values are stored just after shape pointer.
+		return reinterpret_cast<const ValueBase* const*>(this + 1u) + 1u;
+	}
+
+	// Access for any layout. Slower, than layout-specific methods.
+	StringType GetKey( const size_t index ) const noexcept
+	{
+		return layout == Layout::Shaped ? GetShape()->GetKeys()[index] : GetEntries()[index].key;
+	}
+
+	const ValueBase* GetValue( const size_t index ) const noexcept
+	{
+		return layout == Layout::Shaped ? GetShapedValues()[index] : GetEntries()[index].value;
+	}
 };
 
 template<size_t N>
@@ -69,20 +174,50 @@ struct ObjectValueWithEntriesStorage final
 	ObjectValue::ObjectEntry entries[N];
 };
 
+template<size_t N>
+struct ShapedObjectValueWithValuesStorage final
+{
+	ObjectValue value; // Must have "Shaped" layout.
+	const ObjectShape* shape; // Shape must have N keys.
+	const ValueBase* values[N];
+};
+
 struct ArrayValue final : public ValueBase
 {
+	enum class Layout : unsigned char
+	{
+		Elements, // Pointers to elements are stored just after array.
+		PackedDoubles, // Array of numbers, doubles are stored just after array.
+		PackedInt64s, // Array of integer numbers, int64 values are stored just after array.
+	};
+
+	Layout layout;
 	uint32_t object_count;
 
-	explicit constexpr ArrayValue( const uint32_t in_object_count ) noexcept
+	explicit constexpr ArrayValue( const uint32_t in_object_count, const Layout in_layout= Layout::Elements ) noexcept
 		: ValueBase(Type::Array)
+		, layout(in_layout)
 		, object_count(in_object_count)
 	{}
 
+	// Valid only for "Elements" layout.
 	const ValueBase* const* GetElements() const noexcept
 	{
 		// Arrays stores their elements just after it.
 		return reinterpret_cast<const ValueBase* const*>(this + 1u);
 	}
+
+	// Valid only for "PackedDoubles" layout.
+	const double* GetPackedDoubles() const noexcept
+	{
+		return reinterpret_cast<const double*>(this + 1u);
+	}
+
+	// Valid only for "PackedInt64s" layout.
+	const int64_t* GetPackedInt64s() const noexcept
+	{
+		return reinterpret_cast<const int64_t*>(this + 1u);
+	}
 };
 
 template<size_t N>
@@ -92,45 +227,189 @@ struct ArrayValueWithElementsStorage final
 	const ValueBase* elements[N];
 };
 
+template<size_t N>
+struct PackedDoubleArrayValueWithStorage final
+{
+	ArrayValue value; // Must have "PackedDoubles" layout.
+	double elements[N];
+};
+
+template<size_t N>
+struct PackedInt64ArrayValueWithStorage final
+{
+	ArrayValue value; // Must have "PackedInt64s" layout.
+	int64_t elements[N];
+};
+
 struct StringValue final : public ValueBase
 {
+	enum class State : unsigned char
+	{
+		Plain, // String storage contains string itself.
+		Escaped, // String storage contains escaped string, followed by space for unescaped string.
+		Unescaping, // Some thread unescapes string now.
+		Unescaped, // Unescaped string is ready.
+	};
+
+	static constexpr uint32_t c_unknown_length= ~uint32_t(0u);
+
+	// Only parser creates escaped strings. Mutable, because strings are unescaped on first access.
+	mutable std::atomic<State> state;
+
+	// Length of string without terminating null. String may contain null symbols.
+	// If length is unknown, it is calculated with "strlen".
+	// For escaped strings it is written on unescaping.
+	mutable uint32_t length;
+
 	constexpr StringValue() noexcept
 		: ValueBase(Type::String)
+		, state(State::Plain)
+		, length(c_unknown_length)
+	{}
+
+	explicit constexpr StringValue( const uint32_t in_length ) noexcept
+		: ValueBase(Type::String)
+		, state(State::Plain)
+		, length(in_length)
+	{}
+
+	// Copying is needed only for initialization of constexpr strings storage, which contains only plain strings.
+	constexpr StringValue( const StringValue& other ) noexcept
+		: ValueBase(Type::String)
+		, state(State::Plain)
+		, length(other.length)
 	{}
 
 	const char* GetString() const noexcept
 	{
 		// String storage placed just after StringValue.
+		if( state.load( std::memory_order_acquire ) == State::Plain )
+			return reinterpret_cast<const char*>(this + 1u);
+		return GetUnescapedString();
+	}
+
+	StringView GetStringView() const noexcept
+	{
+		// Get string first, because unescaping sets length.
+		const char* const str= GetString();
+		return StringView( str, length == c_unknown_length ? std::strlen(str) : size_t(length) );
+	}
+
+	bool HasEscapes() const noexcept
+	{
+		return state.load( std::memory_order_relaxed ) != State::Plain;
+	}
+
+	// Returns string with escape sequences, as it was in source json. Valid only if string has escapes.
+	const char* GetEscapedString() const noexcept
+	{
 		return reinterpret_cast<const char*>(this + 1u);
 	}
+
+private:
+	const char* GetUnescapedString() const noexcept;
 };
 
 template<size_t N>
 struct StringValueWithStorage final
 {
 	StringValue value;
-	char string[N]; // Null-terminated
+	char string[N]; // Null-terminated. Length must be passed into StringValue constructor, if string contains null symbols.
 };
 
 struct NumberValue final : public ValueBase
 {
+	// Kind of stored number. Creator (script or parser) must choose integer kinds for exact integers.
+	enum class Kind : unsigned char
+	{
+		Int64,
+		Uint64, // Only for values, bigger, than max int64.
+		Double,
+		Lazy, // Number is converted on first access. Number has string. Payload contains converted value, if it is ready.
+	};
+
+	// State of conversion of lazy number.
+	enum class LazyState : unsigned char
+	{
+		NotConverted,
+		Converting, // Some thread writes converted value now.
+		Converted, // Payload and "converted_kind" contain converted value.
+	};
+
+	union Payload
+	{
+		int64_t int_value;
+		uint64_t uint_value;
+		double double_value;
+
+		constexpr Payload( const int64_t in_int_value ) noexcept : int_value(in_int_value) {}
+		constexpr Payload( const uint64_t in_uint_value ) noexcept : uint_value(in_uint_value) {}
+		constexpr Payload( const double in_double_value ) noexcept : double_value(in_double_value) {}
+	};
+
 	bool has_string;
-	int64_t int_value;
-	double double_value;
+	Kind kind;
+	// Only for lazy numbers. Mutable, because numbers are converted on first access.
+	mutable std::atomic<LazyState> lazy_state;
+	mutable Kind converted_kind;
+	Payload payload;
+
+	// Creator (script or parser) must store original str.
+	static constexpr NumberValue FromInt64( const int64_t value, const bool in_has_string= false ) noexcept
+	{
+		return NumberValue( Kind::Int64, Payload(value), in_has_string );
+	}
 
-	// Creator (script or parser) must store original str, and correctly convert to int/double values.
-	constexpr NumberValue( const int64_t in_int_value, const double in_double_value, const bool in_has_string= false ) noexcept
-		: ValueBase(Type::Number)
-		, has_string(in_has_string)
-		, int_value(in_int_value)
-		, double_value(in_double_value)
-	{}
+	static constexpr NumberValue FromUint64( const uint64_t value, const bool in_has_string= false ) noexcept
+	{
+		return NumberValue( Kind::Uint64, Payload(value), in_has_string );
+	}
+
+	static constexpr NumberValue FromDouble( const double value, const bool in_has_string= false ) noexcept
+	{
+		return NumberValue( Kind::Double, Payload(value), in_has_string );
+	}
 
 	const char* GetString() const noexcept
 	{
 		// String storage placed just after StringValue.
 		return has_string ? reinterpret_cast<const char*>(this + 1u) : "";
 	}
+
+	bool IsInteger() const noexcept;
+
+	// Integer value. Doubles are converted with "IntFromDouble".
+	int64_t GetInt64() const noexcept;
+	double GetDouble() const noexcept;
+
+	// Returns converted copy of lazy number. Converted value is saved in number, so, next calls are cheap.
+	// Thread-safe: threads, which access number during conversion, convert it themselves.
+	// For other numbers returns copy.
+	NumberValue GetConverted() const noexcept;
+
+	// Copying is needed for initialization of constexpr numbers. Lazy numbers are never copied - they have string after them.
+	constexpr NumberValue( const NumberValue& other ) noexcept
+		: ValueBase(Type::Number)
+		, has_string(other.has_string)
+		, kind(other.kind)
+		, lazy_state(LazyState::NotConverted)
+		, converted_kind(other.kind)
+		, payload(other.payload)
+	{}
+
+	// Converts double to integer, like parser and script do it - with truncation and saturation.
+	// Big positive values saturated to max uint64 value.
+	static int64_t IntFromDouble( double d ) noexcept;
+
+private:
+	constexpr NumberValue( const Kind in_kind, const Payload in_payload, const bool in_has_string ) noexcept
+		: ValueBase(Type::Number)
+		, has_string(in_has_string)
+		, kind(in_kind)
+		, lazy_state(LazyState::NotConverted)
+		, converted_kind(in_kind)
+		, payload(in_payload)
+	{}
 };
 
 template<size_t N>
@@ -150,9 +429,63 @@ struct BoolValue final : public ValueBase
 	{}
 };
 
+// Precompiled object key.
+// Create it once and use it for lookups in many objects.
+// Key stores length and first bytes of string, and also remembers position of last found member.
+// So, lookups in objects with same keys (records in arrays) are much cheaper, than lookups by plain string.
+// Key also remembers pointer of found object key string. Parser interns keys, so, objects of one document share key strings,
+// and if object key at remembered position has remembered pointer, only first bytes and length of strings are compared.
+// Key is not thread-safe, because it caches search result.
+// Key must live no longer, than its string.
+class Key final
+{
+public:
+	explicit Key( StringType key ) noexcept;
+	explicit Key( const StringView& key ) noexcept;
+
+	StringType GetString() const noexcept; // Not null-terminated, if key was created from string view.
+	size_t GetLength() const noexcept;
+
+	// Result is same as for "StringCompare( key, str )".
+	int Compare( StringType str ) const noexcept;
+	bool IsEqual( StringType str ) const noexcept;
+
+	void ResetCache() const noexcept;
+
+private:
+	friend class Value;
+
+private:
+	StringType str_;
+	size_t length_;
+	uint64_t prefix_; // First bytes of key, packed in big-endian order, so integer comparison is same as string comparison.
+	mutable size_t cached_index_= 0u; // Index of member, found last time.
+	mutable StringType cached_key_ptr_= nullptr; // Pointer to object key string, found last time.
+};
+
+// Pointer to contiguous elements with size.
+template<class T>
+struct Span final
+{
+	const T* data;
+	size_t size;
+
+	const T* begin() const noexcept { return data; }
+	const T* end() const noexcept { return data + size; }
+};
+
+// Result of bulk numbers extraction.
+struct NumbersExtractionResult final
+{
+	size_t count; // Number of written elements.
+	size_t non_number_count; // Number of written elements, which are not numbers.
+	size_t first_non_number_index; // Equal to "count", if all written elements are numbers.
+};
+
 // Class for hight-level json access.
-// Note, that this class is pointer-like. It is lightweight and does not contains
-// any data. Instead, it only usues data from some storage.
+// Note, that this class is pointer-like. It is lightweight and uses data from some storage.
+// The only own data is number for elements of packed arrays and inline numbers, which have no NumberValue in storage.
+// So, Value is two words in size - pointer to value and 8-byte number. Copy it by value.
 class Value final
 {
 public:
@@ -171,8 +504,15 @@ public:
 	// Returns element count for object/array types. Returns 0 for others.
 	size_t ElementCount() const noexcept;
 
+	// Direct access to elements of packed numbers arrays.
+	// Returns empty span, if value is not array or it have other layout.
+	Span<double> AsDoubleSpan() const noexcept;
+	Span<int64_t> AsInt64Span() const noexcept;
+
 	// Returns true if type is object and it have member.
 	bool IsMember( const StringType& key ) const noexcept;
+	bool IsMember( const StringView& key ) const noexcept;
+	bool IsMember( const Key& key ) const noexcept;
 
 	// Member access for arrays.
 	// Returns NullValue, if value is not array or if index out of bounds.
@@ -181,7 +521,7 @@ public:
 	// Special overload for operator[], when "size_t" and "unsigned int" are different types.
 	template<
 		class IndexType= unsigned int>
-		typename std::enable_if< !std::is_same< IndexType, size_t >::value, Value >::type
+		typename std::enable_if< std::is_integral< IndexType >::value && !std::is_same< IndexType, size_t >::value, Value >::type
 	operator[]( IndexType array_index ) const noexcept
 	{
 		return (*this)[ static_cast<size_t>(array_index) ];
@@ -189,6 +529,11 @@ public:
 
 	// Member access for objects. Returns NullValue, if value does not containt key,
 	Value operator[]( const StringType& key ) const noexcept;
+	// Member access by string with length, for example by "std::string" or by part of other string.
+	// Object keys are null-terminated, so, keys with null symbols are never found.
+	Value operator[]( const StringView& key ) const noexcept;
+	// Faster member access for objects, using precompiled key.
+	Value operator[]( const Key& key ) const noexcept;
 
 	// Convertions to numbers.
 	// For boolnean values returns "0" or "1".
@@ -200,12 +545,22 @@ public:
 	int32_t AsInt() const noexcept;
 	uint32_t AsUint() const noexcept;
 
+	// Bulk conversion of array elements, like As* methods for each element.
+	// Writes min( ElementCount(), dst_size ) elements. Non-number elements are converted too, but they are counted in result.
+	// Returns zero count for non-array values.
+	NumbersExtractionResult ExtractNumbers( float * dst, size_t dst_size ) const noexcept;
+	NumbersExtractionResult ExtractNumbers( double* dst, size_t dst_size ) const noexcept;
+	NumbersExtractionResult ExtractNumbers( int32_t* dst, size_t dst_size ) const noexcept;
+	NumbersExtractionResult ExtractNumbers( int64_t* dst, size_t dst_size ) const noexcept;
+
 	// Returns original string for string values.
 	// Returns empty string for object and array values.
 	// Returns empty string for null values.
 	// Returns string representation for numbers. If parser didn`t save original value, empty string returned.
 	// Returns "true" or "false" for bool values.
 	StringType AsString() const noexcept;
+	// Same as AsString, but with length. Strings with "\u0000" are not truncated.
+	StringView AsStringView() const noexcept;
 
 	// Equality operations.
 	// Methods can be slow for big values, especially for arrays.
@@ -233,13 +588,23 @@ public:
 	private:
 		friend class Value;
 
+		enum class Kind : unsigned char
+		{
+			ArrayElements, // Also used for values of shaped objects.
+			PackedDoubles,
+			PackedInt64s,
+			ObjectEntries,
+		};
+
 		union Ptr
 		{
 			const ValueBase* const* array_value;
+			const double* packed_double;
+			const int64_t* packed_int;
 			const ObjectValue::ObjectEntry* object_entry;
 		};
 
-		UniversalIterator( ValueBase::Type type, Ptr ptr ) noexcept;
+		UniversalIterator( Kind kind, Ptr ptr ) noexcept;
 
 	public:
 		UniversalIterator() noexcept {}
@@ -257,7 +622,7 @@ public:
 		// TODO - maybe add operator-> for Value class?
 
 	private:
-		ValueBase::Type type_; // Must be array or object.
+		Kind kind_;
 		Ptr ptr_;
 	};
 
@@ -266,7 +631,15 @@ public:
 	{
 	private:
 		friend class Value;
-		explicit ArrayIterator( const ValueBase* const* ptr ) noexcept;
+
+		union Ptr
+		{
+			const ValueBase* const* element;
+			const double* packed_double;
+			const int64_t* packed_int;
+		};
+
+		ArrayIterator( ArrayValue::Layout layout, const void* ptr ) noexcept;
 
 	public:
 		ArrayIterator() noexcept {}
@@ -284,7 +657,8 @@ public:
 		// TODO - maybe add operator-> for Value class?
 
 	private:
-		const ValueBase* const* ptr_;
+		Ptr ptr_;
+		ArrayValue::Layout layout_;
 	};
 
 	// Iterator for objects.
@@ -294,7 +668,15 @@ public:
 	{
 	private:
 		friend class Value;
+
+		union Ptr
+		{
+			const ObjectValue::ObjectEntry* object_entry;
+			const StringType* shape_key;
+		};
+
 		explicit ObjectIterator( const ObjectValue::ObjectEntry* ptr ) noexcept;
+		ObjectIterator( const StringType* shape_key, const ValueBase* const* shaped_value ) noexcept;
 
 	public:
 		ObjectIterator() noexcept {}
@@ -312,7 +694,8 @@ public:
 		// TODO - maybe add operator-> for Value class?
 
 	private:
-		const ObjectValue::ObjectEntry* ptr_;
+		Ptr ptr_;
+		const ValueBase* const* shaped_value_; // Null for objects with entries.
 	};
 
 	// Helper class for iteration over array/object values.
@@ -360,13 +743,34 @@ public:
 
 	// Get internal value.
 	// Do it, if you know, what you did.
+	// Elements of packed arrays have no own value, for them special number value returned, which does not contain actual number.
 	const ValueBase* GetInternalValue() const noexcept;
 
 private:
+	// Numbers without own NumberValue, for example, elements of packed arrays.
+	static Value InlineDouble( double d ) noexcept;
+	static Value InlineInt64( int64_t i ) noexcept;
+	static Value GetArrayElement( const ArrayValue& array_value, size_t index ) noexcept;
+
 	const ValueBase* SearchObject( const ObjectValue& object, const StringType& key ) const noexcept;
+	const ValueBase* SearchObject( const ObjectValue& object, const StringView& key ) const noexcept;
+	const ValueBase* SearchObject( const ObjectValue& object, const Key& key ) const noexcept;
+
+private:
+	// Special values for numbers without own NumberValue.
+	static const NumberValue inline_double_number_;
+	static const NumberValue inline_int_number_;
 
 private:
 	const ValueBase* value_;
+
+	// Number for values, pointing to special inline number values.
+	union InlineNumber
+	{
+		int64_t int_value;
+		double double_value;
+	};
+	InlineNumber inline_number_;
 };
 
 } // namespace PanzerJson
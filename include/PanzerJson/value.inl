@@ -1,11 +1,100 @@
 #pragma once
 #include <cstring>
+#include <limits>
 
 namespace PanzerJson
 {
 
 // Add some inline methods for builds without link-time optimization.
 
+// Key
+
+inline StringType Key::GetString() const noexcept
+{
+	return str_;
+}
+
+inline size_t Key::GetLength() const noexcept
+{
+	return length_;
+}
+
+inline bool IsInlineNumber( const ValueBase* const value ) noexcept
+{
+	return ( reinterpret_cast<uintptr_t>(value) & 1u ) != 0u;
+}
+
+inline int64_t GetInlineNumber( const ValueBase* const value ) noexcept
+{
+	// Use arithmetic shift for restoring of sign.
+	return static_cast<int64_t>( static_cast<intptr_t>( reinterpret_cast<uintptr_t>(value) ) >> 1 );
+}
+
+inline const ValueBase* MakeInlineNumber( const int64_t number ) noexcept
+{
+	return reinterpret_cast<const ValueBase*>( ( static_cast<uintptr_t>( static_cast<intptr_t>(number) ) << 1u ) | 1u );
+}
+
+// NumberValue
+
+inline bool NumberValue::IsInteger() const noexcept
+{
+	switch( kind )
+	{
+	case Kind::Int64:
+	case Kind::Uint64:
+		return true;
+	case Kind::Double:
+		return false;
+	case Kind::Lazy:
+		break;
+	};
+	return GetConverted().IsInteger();
+}
+
+inline int64_t NumberValue::GetInt64() const noexcept
+{
+	switch( kind )
+	{
+	case Kind::Int64: return payload.int_value;
+	case Kind::Uint64: return static_cast<int64_t>( payload.uint_value );
+	case Kind::Double: return IntFromDouble( payload.double_value );
+	case Kind::Lazy: break;
+	};
+	return GetConverted().GetInt64();
+}
+
+inline double NumberValue::GetDouble() const noexcept
+{
+	switch( kind )
+	{
+	case Kind::Int64: return static_cast<double>( payload.int_value );
+	case Kind::Uint64: return static_cast<double>( payload.uint_value );
+	case Kind::Double: return payload.double_value;
+	case Kind::Lazy: break;
+	};
+	return GetConverted().GetDouble();
+}
+
+inline int64_t NumberValue::IntFromDouble( const double d ) noexcept
+{
+	if( d >= 0.0 )
+	{
+		if( d >= 18446744073709551616.0 ) // 2^64
+			return static_cast<int64_t>( ~uint64_t(0u) );
+		return static_cast<int64_t>( static_cast<uint64_t>(d) );
+	}
+	if( d < 0.0 )
+	{
+		if( d <= -9223372036854775808.0 ) // -2^63
+			return std::numeric_limits<int64_t>::min();
+		return static_cast<int64_t>(d);
+	}
+	return 0; // NaN
+}
+
+// Value
+
 inline ValueBase::Type Value::GetType() const noexcept
 {
 	return value_->type;
@@ -76,18 +165,44 @@ inline const ValueBase* Value::GetInternalValue() const noexcept
 	return value_;
 }
 
-// UniversalIterator
+inline Value Value::InlineDouble( const double d ) noexcept
+{
+	Value result( &inline_double_number_ );
+	result.inline_number_.double_value= d;
+	return result;
+}
 
-inline Value::UniversalIterator::UniversalIterator( const ValueBase::Type type, const Ptr ptr ) noexcept
-	: type_(type)
-	, ptr_(ptr)
+inline Value Value::InlineInt64( const int64_t i ) noexcept
+{
+	Value result( &inline_int_number_ );
+	result.inline_number_.int_value= i;
+	return result;
+}
+
+inline Value Value::GetArrayElement( const ArrayValue& array_value, const size_t index ) noexcept
 {
-	// TODO - assert, if type is not array or object.
+	switch( array_value.layout )
+	{
+	case ArrayValue::Layout::Elements:
+		break;
+	case ArrayValue::Layout::PackedDoubles:
+		return InlineDouble( array_value.GetPackedDoubles()[index] );
+	case ArrayValue::Layout::PackedInt64s:
+		return InlineInt64( array_value.GetPackedInt64s()[index] );
+	};
+	return Value( array_value.GetElements()[index] );
 }
 
+// UniversalIterator
+
+inline Value::UniversalIterator::UniversalIterator( const Kind kind, const Ptr ptr ) noexcept
+	: kind_(kind)
+	, ptr_(ptr)
+{}
+
 inline bool Value::UniversalIterator::operator==( const UniversalIterator& other ) const noexcept
 {
-	return type_ == other.type_ && std::memcmp( &ptr_, &other.ptr_, sizeof(Ptr) ) == 0;
+	return kind_ == other.kind_ && std::memcmp( &ptr_, &other.ptr_, sizeof(Ptr) ) == 0;
 }
 
 inline bool Value::UniversalIterator::operator!=( const UniversalIterator& other ) const noexcept
@@ -97,19 +212,25 @@ inline bool Value::UniversalIterator::operator!=( const UniversalIterator& other
 
 inline Value::UniversalIterator& Value::UniversalIterator::operator++() noexcept
 {
-	if( type_ == ValueBase::Type::Array )
-		++ptr_.array_value;
-	else
-		++ptr_.object_entry;
+	switch( kind_ )
+	{
+	case Kind::ArrayElements: ++ptr_.array_value; break;
+	case Kind::PackedDoubles: ++ptr_.packed_double; break;
+	case Kind::PackedInt64s: ++ptr_.packed_int; break;
+	case Kind::ObjectEntries: ++ptr_.object_entry; break;
+	};
 	return *this;
 }
 
 inline Value::UniversalIterator& Value::UniversalIterator::operator--() noexcept
 {
-	if( type_ == ValueBase::Type::Array )
-		--ptr_.array_value;
-	else
-		--ptr_.object_entry;
+	switch( kind_ )
+	{
+	case Kind::ArrayElements: --ptr_.array_value; break;
+	case Kind::PackedDoubles: --ptr_.packed_double; break;
+	case Kind::PackedInt64s: --ptr_.packed_int; break;
+	case Kind::ObjectEntries: --ptr_.object_entry; break;
+	};
 	return *this;
 }
 
@@ -129,21 +250,32 @@ inline Value::UniversalIterator Value::UniversalIterator::operator--(int) noexce
 
 inline Value Value::UniversalIterator::operator*() const noexcept
 {
-	if( type_ == ValueBase::Type::Array )
-		return Value( *ptr_.array_value );
-	else
-		return Value( ptr_.object_entry->value );
+	switch( kind_ )
+	{
+	case Kind::ArrayElements: return Value( *ptr_.array_value );
+	case Kind::PackedDoubles: return InlineDouble( *ptr_.packed_double );
+	case Kind::PackedInt64s: return InlineInt64( *ptr_.packed_int );
+	case Kind::ObjectEntries: break;
+	};
+	return Value( ptr_.object_entry->value );
 }
 
 // ArrayIterator
 
-inline Value::ArrayIterator::ArrayIterator( const ValueBase* const* const ptr ) noexcept
-	: ptr_(ptr)
-{}
+inline Value::ArrayIterator::ArrayIterator( const ArrayValue::Layout layout, const void* const ptr ) noexcept
+	: layout_(layout)
+{
+	switch( layout_ )
+	{
+	case ArrayValue::Layout::Elements: ptr_.element= static_cast<const ValueBase* const*>(ptr); break;
+	case ArrayValue::Layout::PackedDoubles: ptr_.packed_double= static_cast<const double*>(ptr); break;
+	case ArrayValue::Layout::PackedInt64s: ptr_.packed_int= static_cast<const int64_t*>(ptr); break;
+	};
+}
 
 inline bool Value::ArrayIterator::operator==( const ArrayIterator& other ) const noexcept
 {
-	return ptr_ == other.ptr_;
+	return layout_ == other.layout_ && std::memcmp( &ptr_, &other.ptr_, sizeof(Ptr) ) == 0;
 }
 
 inline bool Value::ArrayIterator::operator!=( const ArrayIterator& other ) const noexcept
@@ -153,13 +285,23 @@ inline bool Value::ArrayIterator::operator!=( const ArrayIterator& other ) const
 
 inline Value::ArrayIterator& Value::ArrayIterator::operator++() noexcept
 {
-	++ptr_;
+	switch( layout_ )
+	{
+	case ArrayValue::Layout::Elements: ++ptr_.element; break;
+	case ArrayValue::Layout::PackedDoubles: ++ptr_.packed_double; break;
+	case ArrayValue::Layout::PackedInt64s: ++ptr_.packed_int; break;
+	};
 	return *this;
 }
 
 inline Value::ArrayIterator& Value::ArrayIterator::operator--() noexcept
 {
-	--ptr_;
+	switch( layout_ )
+	{
+	case ArrayValue::Layout::Elements: --ptr_.element; break;
+	case ArrayValue::Layout::PackedDoubles: --ptr_.packed_double; break;
+	case ArrayValue::Layout::PackedInt64s: --ptr_.packed_int; break;
+	};
 	return *this;
 }
 
@@ -179,18 +321,32 @@ inline Value::ArrayIterator Value::ArrayIterator::operator--(int) noexcept
 
 inline Value Value::ArrayIterator::operator*() const noexcept
 {
-	return Value( *ptr_ );
+	switch( layout_ )
+	{
+	case ArrayValue::Layout::Elements: break;
+	case ArrayValue::Layout::PackedDoubles: return InlineDouble( *ptr_.packed_double );
+	case ArrayValue::Layout::PackedInt64s: return InlineInt64( *ptr_.packed_int );
+	};
+	return Value( *ptr_.element );
 }
 
 // ObjectIterator
 
 inline Value::ObjectIterator::ObjectIterator( const ObjectValue::ObjectEntry* const ptr ) noexcept
-	: ptr_(ptr)
-{}
+	: shaped_value_(nullptr)
+{
+	ptr_.object_entry= ptr;
+}
+
+inline Value::ObjectIterator::ObjectIterator( const StringType* const shape_key, const ValueBase* const* const shaped_value ) noexcept
+	: shaped_value_(shaped_value)
+{
+	ptr_.shape_key= shape_key;
+}
 
 inline bool Value::ObjectIterator::operator==( const ObjectIterator& other ) const noexcept
 {
-	return ptr_ == other.ptr_;
+	return shaped_value_ == other.shaped_value_ && std::memcmp( &ptr_, &other.ptr_, sizeof(Ptr) ) == 0;
 }
 
 inline bool Value::ObjectIterator::operator!=( const ObjectIterator& other ) const noexcept
@@ -200,13 +356,25 @@ inline bool Value::ObjectIterator::operator!=( const ObjectIterator& other ) con
 
 inline Value::ObjectIterator& Value::ObjectIterator::operator++() noexcept
 {
-	++ptr_;
+	if( shaped_value_ != nullptr )
+	{
+		++ptr_.shape_key;
+		++shaped_value_;
+	}
+	else
+		++ptr_.object_entry;
 	return *this;
 }
 
 inline Value::ObjectIterator& Value::ObjectIterator::operator--() noexcept
 {
-	--ptr_;
+	if( shaped_value_ != nullptr )
+	{
+		--ptr_.shape_key;
+		--shaped_value_;
+	}
+	else
+		--ptr_.object_entry;
 	return *this;
 }
 
@@ -226,7 +394,9 @@ inline Value::ObjectIterator Value::ObjectIterator::operator--(int) noexcept
 
 inline Value::ObjectIterator::value_type Value::ObjectIterator::operator*() const noexcept
 {
-	return value_type( ptr_->key, Value( ptr_->value ) );
+	if( shaped_value_ != nullptr )
+		return value_type( *ptr_.shape_key, Value( *shaped_value_ ) );
+	return value_type( ptr_.object_entry->key, Value( ptr_.object_entry->value ) );
 }
 
 // IteratorRange
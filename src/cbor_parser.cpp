@@ -0,0 +1,349 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "panzer_json_assert.hpp"
+
+#include "../include/PanzerJson/parser.hpp"
+
+namespace PanzerJson
+{
+
+namespace
+{
+
+enum CborMajorType : unsigned int
+{
+	c_cbor_unsigned_int= 0u,
+	c_cbor_negative_int= 1u,
+	c_cbor_byte_string= 2u,
+	c_cbor_text_string= 3u,
+	c_cbor_array= 4u,
+	c_cbor_map= 5u,
+	c_cbor_tag= 6u,
+	c_cbor_simple= 7u,
+};
+
+const unsigned int c_cbor_indefinite_length= 31u;
+const unsigned char c_cbor_break= 0xFF;
+
+double HalfToDouble( const uint16_t half ) noexcept
+{
+	const int exponent= ( half >> 10 ) & 31;
+	const double mantissa= double( half & 1023 );
+	double result;
+	if( exponent == 0 )
+		result= std::ldexp( mantissa, -24 );
+	else if( exponent == 31 )
+		result= mantissa == 0.0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+	else
+		result= std::ldexp( mantissa + 1024.0, exponent - 25 );
+	return ( half & 0x8000u ) != 0u ? -result : result;
+}
+
+} // namespace
+
+Parser::ResultPtr Parser::ParseCbor( const void* const data, const size_t data_size )
+{
+	bool all_ok= false;
+
+	if( data == nullptr || data_size == 0u )
+	{
+		result_.error= Result::Error::EmptyInput;
+		result_.error_pos= 0u;
+	}
+	else
+	{
+		StartParsing( static_cast<const char*>(data), data_size );
+		const ValueBase* const root= ParseCbor_r();
+
+		if( result_.error == Result::Error::NoError )
+		{
+			if( cur_ != end_ )
+				result_.error= Result::Error::ExtraCharactersAfterJsonRoot;
+			else
+				all_ok= FinishParsing( root );
+		}
+	}
+
+	return MakeResult( all_ok );
+}
+
+const ValueBase* Parser::ParseCbor_r()
+{
+	if( cur_ == end_ )
+	{
+		result_.error= Result::Error::UnexpectedEndOfFile;
+		return nullptr;
+	}
+
+	const char* const item_start= cur_;
+	const unsigned char initial_byte= static_cast<unsigned char>(*cur_);
+	const unsigned int major_type= initial_byte >> 5u;
+	const unsigned int additional_info= initial_byte & 31u;
+	++cur_;
+
+	if( major_type == c_cbor_simple )
+	{
+		const auto read_bytes=
+		[&]( const size_t size, void* const dst ) -> bool
+		{
+			if( static_cast<size_t>( end_ - cur_ ) < size )
+			{
+				result_.error= Result::Error::UnexpectedEndOfFile;
+				return false;
+			}
+			// Big-endian to native.
+			unsigned char* const dst_bytes= static_cast<unsigned char*>(dst);
+			for( size_t i= 0u; i < size; i++ )
+				dst_bytes[ size - 1u - i ]= static_cast<unsigned char>( cur_[i] );
+			cur_+= size;
+			return true;
+		};
+
+		switch( additional_info )
+		{
+		case 20u: return GetBoolValue( false );
+		case 21u: return GetBoolValue( true );
+		case 22u:
+		case 23u: // Undefined is converted to null.
+			return GetNullValue();
+
+		case 25u:
+			{
+				uint16_t half;
+				if( !read_bytes( sizeof(uint16_t), &half ) )
+					return nullptr;
+				return CreateNumber( NumberValue::Kind::Double, NumberValue::Payload( HalfToDouble( half ) ), nullptr, 0u );
+			}
+		case 26u:
+			{
+				float f;
+				static_assert( sizeof(float) == 4u, "unexpected float size" );
+				if( !read_bytes( sizeof(float), &f ) )
+					return nullptr;
+				return CreateNumber( NumberValue::Kind::Double, NumberValue::Payload( double(f) ), nullptr, 0u );
+			}
+		case 27u:
+			{
+				double d;
+				if( !read_bytes( sizeof(double), &d ) )
+					return nullptr;
+				return CreateNumber( NumberValue::Kind::Double, NumberValue::Payload( d ), nullptr, 0u );
+			}
+
+		default:
+			// Other simple values and "break" outside of indefinite length item.
+			--cur_;
+			result_.error= Result::Error::UnexpectedLexem;
+			return nullptr;
+		};
+	}
+
+	const bool indefinite= additional_info == c_cbor_indefinite_length;
+	uint64_t argument= 0u;
+	if( indefinite )
+	{
+		if( !( major_type == c_cbor_text_string || major_type == c_cbor_array || major_type == c_cbor_map ) )
+		{
+			--cur_;
+			result_.error= Result::Error::UnexpectedLexem;
+			return nullptr;
+		}
+	}
+	else if( !ReadCborArgument( additional_info, argument ) )
+		return nullptr;
+
+	switch( major_type )
+	{
+	case c_cbor_unsigned_int:
+		if( argument <= uint64_t( std::numeric_limits<int64_t>::max() ) )
+			return CreateNumber( NumberValue::Kind::Int64, NumberValue::Payload( int64_t(argument) ), nullptr, 0u );
+		return CreateNumber( NumberValue::Kind::Uint64, NumberValue::Payload( argument ), nullptr, 0u );
+
+	case c_cbor_negative_int:
+		// Value is "-1 - argument". Values, less, than min int64, are converted to double.
+		if( argument <= uint64_t( std::numeric_limits<int64_t>::max() ) )
+			return CreateNumber( NumberValue::Kind::Int64, NumberValue::Payload( -1 - int64_t(argument) ), nullptr, 0u );
+		return CreateNumber( NumberValue::Kind::Double, NumberValue::Payload( -1.0 - double(argument) ), nullptr, 0u );
+
+	case c_cbor_text_string:
+		{
+			// Allocate StringValue, then read string. String storage will be exactly after StringValue.
+			const size_t offset= result_.storage.size();
+			result_.storage.resize( result_.storage.size() + sizeof(StringValue) );
+
+			size_t length= 0u;
+			ParseCborString( argument, indefinite, &length );
+			if( result_.error != Result::Error::NoError )
+				return nullptr;
+
+			StringValue* const string_value= reinterpret_cast<StringValue*>( result_.storage.data() + offset );
+			string_value->type= ValueBase::Type::String;
+			string_value->state.store( StringValue::State::Plain, std::memory_order_relaxed );
+			string_value->length= length < StringValue::c_unknown_length ? uint32_t(length) : StringValue::c_unknown_length;
+
+			return reinterpret_cast<StringValue*>( static_cast<char*>(nullptr) + offset );
+		}
+
+	case c_cbor_array:
+		{
+			const size_t array_elements_stack_pos= array_elements_stack_.size();
+			for( uint64_t i= 0u; indefinite || i < argument; i++ )
+			{
+				if( indefinite && cur_ != end_ && static_cast<unsigned char>(*cur_) == c_cbor_break )
+				{
+					++cur_;
+					break;
+				}
+
+				const ValueBase* const value= ParseCbor_r();
+				if( result_.error != Result::Error::NoError )
+					return nullptr;
+				array_elements_stack_.push_back( value );
+			}
+			return CreateArray( array_elements_stack_pos );
+		}
+
+	case c_cbor_map:
+		{
+			const size_t object_entries_stack_pos= object_entries_stack_.size();
+			for( uint64_t i= 0u; indefinite || i < argument; i++ )
+			{
+				if( cur_ == end_ )
+				{
+					result_.error= Result::Error::UnexpectedEndOfFile;
+					return nullptr;
+				}
+				const unsigned char key_initial_byte= static_cast<unsigned char>(*cur_);
+				if( indefinite && key_initial_byte == c_cbor_break )
+				{
+					++cur_;
+					break;
+				}
+
+				// Only text keys are supported.
+				if( ( key_initial_byte >> 5u ) != c_cbor_text_string )
+				{
+					result_.error= Result::Error::UnexpectedLexem;
+					return nullptr;
+				}
+				++cur_;
+				uint64_t key_length= 0u;
+				const bool key_indefinite= ( key_initial_byte & 31u ) == c_cbor_indefinite_length;
+				if( !key_indefinite && !ReadCborArgument( key_initial_byte & 31u, key_length ) )
+					return nullptr;
+
+				StringType key= ParseCborString( key_length, key_indefinite, nullptr );
+				if( result_.error != Result::Error::NoError )
+					return nullptr;
+				if( intern_keys_ )
+					key= InternKey( key );
+
+				const ValueBase* const value= ParseCbor_r();
+				if( result_.error != Result::Error::NoError )
+					return nullptr;
+
+				object_entries_stack_.emplace_back( ObjectValue::ObjectEntry{ key, value } );
+			}
+			return CreateObject( object_entries_stack_pos );
+		}
+
+	case c_cbor_tag:
+		// Tags are ignored, tagged item is used as is.
+		return ParseCbor_r();
+
+	case c_cbor_byte_string:
+	default:
+		cur_= item_start;
+		result_.error= Result::Error::UnexpectedLexem;
+		return nullptr;
+	};
+}
+
+bool Parser::ReadCborArgument( const unsigned int additional_info, uint64_t& out_argument )
+{
+	if( additional_info < 24u )
+	{
+		out_argument= additional_info;
+		return true;
+	}
+	if( additional_info > 27u )
+	{
+		--cur_;
+		result_.error= Result::Error::UnexpectedLexem;
+		return false;
+	}
+
+	const size_t size= size_t(1u) << ( additional_info - 24u );
+	if( static_cast<size_t>( end_ - cur_ ) < size )
+	{
+		result_.error= Result::Error::UnexpectedEndOfFile;
+		return false;
+	}
+
+	out_argument= 0u;
+	for( size_t i= 0u; i < size; i++ )
+		out_argument= ( out_argument << 8u ) | static_cast<unsigned char>( cur_[i] );
+	cur_+= size;
+	return true;
+}
+
+StringType Parser::ParseCborString( const uint64_t length, const bool indefinite, size_t* const out_length )
+{
+	const size_t offset= result_.storage.size();
+
+	if( indefinite )
+	{
+		// Sequence of definite length text strings, terminated by "break".
+		while( true )
+		{
+			if( cur_ == end_ )
+			{
+				result_.error= Result::Error::UnexpectedEndOfFile;
+				return nullptr;
+			}
+			const unsigned char initial_byte= static_cast<unsigned char>(*cur_);
+			++cur_;
+			if( initial_byte == c_cbor_break )
+				break;
+
+			uint64_t chunk_length= 0u;
+			if( ( initial_byte >> 5u ) != c_cbor_text_string || ( initial_byte & 31u ) == c_cbor_indefinite_length )
+			{
+				--cur_;
+				result_.error= Result::Error::UnexpectedLexem;
+				return nullptr;
+			}
+			if( !ReadCborArgument( initial_byte & 31u, chunk_length ) )
+				return nullptr;
+			if( chunk_length > static_cast<uint64_t>( end_ - cur_ ) )
+			{
+				result_.error= Result::Error::UnexpectedEndOfFile;
+				return nullptr;
+			}
+			result_.storage.insert( result_.storage.end(), cur_, cur_ + chunk_length );
+			cur_+= chunk_length;
+		}
+	}
+	else
+	{
+		if( length > static_cast<uint64_t>( end_ - cur_ ) )
+		{
+			result_.error= Result::Error::UnexpectedEndOfFile;
+			return nullptr;
+		}
+		result_.storage.insert( result_.storage.end(), cur_, cur_ + length );
+		cur_+= length;
+	}
+
+	if( out_length != nullptr )
+		*out_length= result_.storage.size() - offset;
+	result_.storage.push_back( '\0' );
+	// Reconstruct alignment.
+	result_.storage.resize( ( result_.storage.size() + ( sizeof(void*) - 1u ) ) & ~( sizeof(void*) - 1u ) );
+
+	return static_cast<StringType>(nullptr) + offset;
+}
+
+} // namespace PanzerJson
@@ -0,0 +1,249 @@
+#include <cmath>
+#include <cstring>
+
+#include "../include/PanzerJson/cbor_serializer.hpp"
+
+namespace PanzerJson
+{
+
+namespace
+{
+
+enum CborMajorType : unsigned char
+{
+	c_cbor_unsigned_int= 0u,
+	c_cbor_negative_int= 1u,
+	c_cbor_text_string= 3u,
+	c_cbor_array= 4u,
+	c_cbor_map= 5u,
+	c_cbor_simple= 7u,
+};
+
+// Writes initial byte and argument in shortest form.
+void WriteHead( OutputBuffer& out, const unsigned char major_type, const uint64_t argument )
+{
+	unsigned char bytes[9];
+	size_t argument_size;
+	unsigned char additional_info;
+	if( argument < 24u )
+	{
+		additional_info= static_cast<unsigned char>(argument);
+		argument_size= 0u;
+	}
+	else if( argument <= 0xFFu )
+	{
+		additional_info= 24u;
+		argument_size= 1u;
+	}
+	else if( argument <= 0xFFFFu )
+	{
+		additional_info= 25u;
+		argument_size= 2u;
+	}
+	else if( argument <= 0xFFFFFFFFu )
+	{
+		additional_info= 26u;
+		argument_size= 4u;
+	}
+	else
+	{
+		additional_info= 27u;
+		argument_size= 8u;
+	}
+
+	bytes[0]= static_cast<unsigned char>( major_type << 5u | additional_info );
+	for( size_t i= 0u; i < argument_size; i++ )
+		bytes[ 1u + i ]= static_cast<unsigned char>( argument >> ( 8u * ( argument_size - 1u - i ) ) );
+	out.Write( reinterpret_cast<const char*>(bytes), 1u + argument_size );
+}
+
+void WriteInt( OutputBuffer& out, const int64_t value )
+{
+	if( value >= 0 )
+		WriteHead( out, c_cbor_unsigned_int, uint64_t(value) );
+	else
+		WriteHead( out, c_cbor_negative_int, uint64_t( -1 - value ) );
+}
+
+void WriteString( OutputBuffer& out, const StringView& str )
+{
+	WriteHead( out, c_cbor_text_string, str.size );
+	out.Write( str.data, str.size );
+}
+
+// Writes initial byte and big-endian bits of float value.
+template<class Bits>
+void WriteFloatBits( OutputBuffer& out, const unsigned char additional_info, const Bits bits )
+{
+	unsigned char bytes[ 1u + sizeof(Bits) ];
+	bytes[0]= static_cast<unsigned char>( c_cbor_simple << 5u | additional_info );
+	for( size_t i= 0u; i < sizeof(Bits); i++ )
+		bytes[ 1u + i ]= static_cast<unsigned char>( bits >> ( 8u * ( sizeof(Bits) - 1u - i ) ) );
+	out.Write( reinterpret_cast<const char*>(bytes), sizeof(bytes) );
+}
+
+// Returns true, if double is exactly representable as half float (without subnormals).
+bool DoubleToHalf( const double d, uint16_t& out_half ) noexcept
+{
+	if( std::isnan(d) )
+	{
+		out_half= 0x7E00u;
+		return true;
+	}
+
+	const float f= static_cast<float>(d);
+	if( static_cast<double>(f) != d )
+		return false;
+
+	uint32_t bits;
+	std::memcpy( &bits, &f, sizeof(float) );
+	const uint16_t sign= static_cast<uint16_t>( ( bits >> 16u ) & 0x8000u );
+	const int exponent= int( ( bits >> 23u ) & 0xFFu );
+	const uint32_t mantissa= bits & 0x7FFFFFu;
+
+	if( exponent == 0 && mantissa == 0u )
+	{
+		out_half= sign; // Zero.
+		return true;
+	}
+	if( exponent == 0xFF )
+	{
+		out_half= static_cast<uint16_t>( sign | 0x7C00u ); // Infinity.
+		return true;
+	}
+
+	const int half_exponent= exponent - 127 + 15;
+	if( half_exponent <= 0 || half_exponent >= 31 || ( mantissa & 0x1FFFu ) != 0u )
+		return false;
+
+	out_half= static_cast<uint16_t>( sign | half_exponent << 10u | mantissa >> 13u );
+	return true;
+}
+
+void WriteDouble( OutputBuffer& out, const double value )
+{
+	uint16_t half;
+	if( DoubleToHalf( value, half ) )
+	{
+		WriteFloatBits( out, 25u, half );
+		return;
+	}
+
+	const float f= static_cast<float>(value);
+	if( static_cast<double>(f) == value )
+	{
+		uint32_t bits;
+		std::memcpy( &bits, &f, sizeof(float) );
+		WriteFloatBits( out, 26u, bits );
+	}
+	else
+	{
+		uint64_t bits;
+		std::memcpy( &bits, &value, sizeof(double) );
+		WriteFloatBits( out, 27u, bits );
+	}
+}
+
+} // namespace
+
+void CborSerializer::Serialize( const Value value, OutputBuffer& out )
+{
+	const ValueBase& internal_value= *value.GetInternalValue();
+	if( internal_value.type == ValueBase::Type::Number )
+	{
+		// Value may be inline number, without own number value, so, use only value methods.
+		switch( static_cast<const NumberValue&>(internal_value).kind )
+		{
+		case NumberValue::Kind::Int64: WriteInt( out, value.AsInt64() ); return;
+		case NumberValue::Kind::Uint64: WriteHead( out, c_cbor_unsigned_int, value.AsUint64() ); return;
+		case NumberValue::Kind::Double: WriteDouble( out, value.AsDouble() ); return;
+		case NumberValue::Kind::Lazy: break;
+		};
+	}
+	Serialize_r( out, internal_value );
+}
+
+void CborSerializer::Serialize_r( OutputBuffer& out, const ValueBase& internal_value )
+{
+	switch( internal_value.type )
+	{
+	case ValueBase::Type::Null:
+		out.Write( char( 0xF6 ) );
+		break;
+
+	case ValueBase::Type::Bool:
+		out.Write( static_cast<const BoolValue&>(internal_value).value ? char( 0xF5 ) : char( 0xF4 ) );
+		break;
+
+	case ValueBase::Type::Number:
+		SerializeNumber( out, static_cast<const NumberValue&>(internal_value) );
+		break;
+
+	case ValueBase::Type::String:
+		WriteString( out, static_cast<const StringValue&>(internal_value).GetStringView() );
+		break;
+
+	case ValueBase::Type::Object:
+		{
+			const ObjectValue& object= static_cast<const ObjectValue&>(internal_value);
+			WriteHead( out, c_cbor_map, object.object_count );
+			for( size_t i= 0u; i < object.object_count; i++ )
+			{
+				WriteString( out, StringView( object.GetKey(i) ) );
+				SerializeElement( out, object.GetValue(i) );
+			}
+		}
+		break;
+
+	case ValueBase::Type::Array:
+		{
+			const ArrayValue& array= static_cast<const ArrayValue&>(internal_value);
+			WriteHead( out, c_cbor_array, array.object_count );
+			switch( array.layout )
+			{
+			case ArrayValue::Layout::Elements:
+				for( size_t i= 0u; i < array.object_count; i++ )
+					SerializeElement( out, array.GetElements()[i] );
+				break;
+			case ArrayValue::Layout::PackedDoubles:
+				for( size_t i= 0u; i < array.object_count; i++ )
+					WriteDouble( out, array.GetPackedDoubles()[i] );
+				break;
+			case ArrayValue::Layout::PackedInt64s:
+				for( size_t i= 0u; i < array.object_count; i++ )
+					WriteInt( out, array.GetPackedInt64s()[i] );
+				break;
+			};
+		}
+		break;
+	};
+}
+
+void CborSerializer::SerializeElement( OutputBuffer& out, const ValueBase* const value )
+{
+	if( IsInlineNumber( value ) )
+		WriteInt( out, GetInlineNumber( value ) );
+	else
+		Serialize_r( out, *value );
+}
+
+void CborSerializer::SerializeNumber( OutputBuffer& out, const NumberValue& number )
+{
+	const NumberValue converted= number.GetConverted();
+	switch( converted.kind )
+	{
+	case NumberValue::Kind::Int64:
+		WriteInt( out, converted.payload.int_value );
+		break;
+	case NumberValue::Kind::Uint64:
+		WriteHead( out, c_cbor_unsigned_int, converted.payload.uint_value );
+		break;
+	case NumberValue::Kind::Double:
+		WriteDouble( out, converted.payload.double_value );
+		break;
+	case NumberValue::Kind::Lazy:
+		break; // Converted number is never lazy.
+	};
+}
+
+} // namespace PanzerJson
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "../include/PanzerJson/chunked_output.hpp"
+
+namespace PanzerJson
+{
+
+static const size_t g_scratch_block_size= 4096u;
+
+ChunkedOutput::ChunkedOutput( const size_t min_reference_size )
+	: min_reference_size_(min_reference_size)
+{}
+
+void ChunkedOutput::Write( const char c )
+{
+	Write( &c, 1u );
+}
+
+void ChunkedOutput::Write( const char* const data, const size_t size )
+{
+	if( size == 0u )
+		return;
+
+	if( size > static_cast<size_t>( scratch_end_ - scratch_cur_ ) )
+	{
+		// Previous blocks are not reallocated, because chunks point to them.
+		const size_t block_size= std::max( size, g_scratch_block_size );
+		scratch_blocks_.emplace_back( new char[ block_size ] );
+		scratch_cur_= scratch_blocks_.back().get();
+		scratch_end_= scratch_cur_ + block_size;
+		last_chunk_is_scratch_= false;
+	}
+
+	std::memcpy( scratch_cur_, data, size );
+	if( last_chunk_is_scratch_ )
+		chunks_.back().size+= size;
+	else
+		chunks_.push_back( OutputChunk{ scratch_cur_, size } );
+	scratch_cur_+= size;
+	last_chunk_is_scratch_= true;
+	size_+= size;
+}
+
+void ChunkedOutput::WriteReference( const char* const data, const size_t size )
+{
+	if( size < min_reference_size_ )
+	{
+		Write( data, size );
+		return;
+	}
+
+	chunks_.push_back( OutputChunk{ data, size } );
+	last_chunk_is_scratch_= false;
+	size_+= size;
+}
+
+const OutputChunk* ChunkedOutput::GetChunks() const noexcept
+{
+	return chunks_.data();
+}
+
+size_t ChunkedOutput::GetChunkCount() const noexcept
+{
+	return chunks_.size();
+}
+
+size_t ChunkedOutput::GetSize() const noexcept
+{
+	return size_;
+}
+
+void ChunkedOutput::Clear() noexcept
+{
+	chunks_.clear();
+	scratch_blocks_.clear();
+	scratch_cur_= nullptr;
+	scratch_end_= nullptr;
+	last_chunk_is_scratch_= false;
+	size_= 0u;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+static_assert(
+	sizeof(OutputChunk) == sizeof(iovec) &&
+	offsetof(OutputChunk, data) == offsetof(iovec, iov_base) &&
+	offsetof(OutputChunk, size) == offsetof(iovec, iov_len),
+	"OutputChunk must have same layout as iovec" );
+
+bool WriteChunks( const int fd, const OutputChunk* chunks, size_t chunk_count )
+{
+#ifdef IOV_MAX
+	const size_t max_chunks_per_call= IOV_MAX;
+#else
+	const size_t max_chunks_per_call= 1024u;
+#endif
+
+	// Copy of first chunk, which may be partially written.
+	OutputChunk first_chunk{ nullptr, 0u };
+	if( chunk_count > 0u )
+		first_chunk= chunks[0];
+
+	while( chunk_count > 0u )
+	{
+		const size_t count= std::min( chunk_count, max_chunks_per_call );
+
+		ssize_t written;
+		if( first_chunk.data == chunks[0].data )
+			written= writev( fd, reinterpret_cast<const iovec*>(chunks), static_cast<int>(count) );
+		else
+		{
+			// Write rest of partially written chunk separately.
+			written= write( fd, first_chunk.data, first_chunk.size );
+		}
+		if( written < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			return false;
+		}
+
+		// Skip written chunks.
+		size_t remaining= static_cast<size_t>(written);
+		while( chunk_count > 0u && remaining >= first_chunk.size )
+		{
+			remaining-= first_chunk.size;
+			++chunks;
+			--chunk_count;
+			if( chunk_count > 0u )
+				first_chunk= chunks[0];
+		}
+		if( chunk_count > 0u && remaining > 0u )
+		{
+			first_chunk.data= static_cast<const char*>(first_chunk.data) + remaining;
+			first_chunk.size-= remaining;
+		}
+	}
+
+	return true;
+}
+
+#endif
+
+} // namespace PanzerJson
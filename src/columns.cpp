@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <thread>
+
+#include "panzer_json_assert.hpp"
+
+#include "../include/PanzerJson/columns.hpp"
+
+namespace PanzerJson
+{
+
+static constexpr size_t g_bitmap_word_bits= 64u;
+
+static size_t PopCount( uint64_t x ) noexcept
+{
+	size_t result= 0u;
+	while( x != 0u )
+	{
+		x&= x - 1u;
+		++result;
+	}
+	return result;
+}
+
+ColumnType Column::GetType() const noexcept
+{
+	return type_;
+}
+
+size_t Column::GetSize() const noexcept
+{
+	return size_;
+}
+
+const double* Column::GetDoubles() const noexcept
+{
+	return type_ == ColumnType::Double ? doubles_.data() : nullptr;
+}
+
+const int64_t* Column::GetInts() const noexcept
+{
+	return type_ == ColumnType::Int64 ? ints_.data() : nullptr;
+}
+
+const StringType* Column::GetStrings() const noexcept
+{
+	return type_ == ColumnType::String ? strings_.data() : nullptr;
+}
+
+const uint64_t* Column::GetValidityBitmap() const noexcept
+{
+	return validity_.data();
+}
+
+bool Column::IsValid( const size_t row ) const noexcept
+{
+	PJ_ASSERT( row < size_ );
+	return ( validity_[ row / g_bitmap_word_bits ] & ( uint64_t(1u) << ( row % g_bitmap_word_bits ) ) ) != 0u;
+}
+
+size_t Column::GetValidCount() const noexcept
+{
+	size_t result= 0u;
+	for( const uint64_t word : validity_ )
+		result+= PopCount( word );
+	return result;
+}
+
+// Fills rows in range [begin, end). Begin must be multiple of bitmap word size, so, different threads write different bitmap words.
+static void ExtractColumnsRows(
+	const Value array,
+	const ColumnDescription* const descriptions,
+	double** const doubles,
+	int64_t** const ints,
+	StringType** const strings,
+	uint64_t** const validity,
+	const size_t column_count,
+	const size_t begin,
+	const size_t end )
+{
+	PJ_ASSERT( begin % g_bitmap_word_bits == 0u );
+
+	// Keys are not thread-safe, so, create own keys for each thread.
+	std::vector<Key> keys;
+	keys.reserve( column_count );
+	for( size_t c= 0u; c < column_count; c++ )
+		keys.emplace_back( descriptions[c].name );
+
+	Value::ArrayIterator it= array.array_begin();
+	std::advance( it, begin );
+	for( size_t row= begin; row < end; ++row, ++it )
+	{
+		const Value row_value= *it;
+		if( !row_value.IsObject() )
+			continue;
+
+		const size_t word= row / g_bitmap_word_bits;
+		const uint64_t bit= uint64_t(1u) << ( row % g_bitmap_word_bits );
+		for( size_t c= 0u; c < column_count; c++ )
+		{
+			const Value member= row_value[ keys[c] ];
+			switch( descriptions[c].type )
+			{
+			case ColumnType::Double:
+				if( member.IsNumber() )
+				{
+					doubles[c][row]= member.AsDouble();
+					validity[c][word]|= bit;
+				}
+				break;
+			case ColumnType::Int64:
+				if( member.IsNumber() )
+				{
+					ints[c][row]= member.AsInt64();
+					validity[c][word]|= bit;
+				}
+				break;
+			case ColumnType::String:
+				if( member.IsString() )
+				{
+					strings[c][row]= member.AsString();
+					validity[c][word]|= bit;
+				}
+				break;
+			};
+		}
+	}
+}
+
+std::vector<Column> ExtractColumns(
+	const Value array,
+	const ColumnDescription* const descriptions,
+	const size_t column_count,
+	const unsigned int thread_count )
+{
+	std::vector<Column> result( column_count );
+
+	const size_t row_count= array.IsArray() ? array.ElementCount() : 0u;
+	const size_t word_count= ( row_count + g_bitmap_word_bits - 1u ) / g_bitmap_word_bits;
+
+	std::vector<double*> doubles( column_count, nullptr );
+	std::vector<int64_t*> ints( column_count, nullptr );
+	std::vector<StringType*> strings( column_count, nullptr );
+	std::vector<uint64_t*> validity( column_count );
+	for( size_t c= 0u; c < column_count; c++ )
+	{
+		Column& column= result[c];
+		column.type_= descriptions[c].type;
+		column.size_= row_count;
+		column.validity_.resize( word_count, 0u );
+		switch( column.type_ )
+		{
+		case ColumnType::Double:
+			column.doubles_.resize( row_count, 0.0 );
+			doubles[c]= column.doubles_.data();
+			break;
+		case ColumnType::Int64:
+			column.ints_.resize( row_count, 0 );
+			ints[c]= column.ints_.data();
+			break;
+		case ColumnType::String:
+			column.strings_.resize( row_count, "" );
+			strings[c]= column.strings_.data();
+			break;
+		};
+		validity[c]= column.validity_.data();
+	}
+
+	// Do not create threads for small arrays.
+	const size_t max_threads= std::max( word_count / 4u, size_t(1u) );
+	const size_t actual_thread_count= std::min( std::max( size_t(thread_count), size_t(1u) ), max_threads );
+	if( actual_thread_count <= 1u )
+	{
+		ExtractColumnsRows(
+			array, descriptions,
+			doubles.data(), ints.data(), strings.data(), validity.data(), column_count,
+			0u, row_count );
+		return result;
+	}
+
+	const size_t words_per_thread= ( word_count + actual_thread_count - 1u ) / actual_thread_count;
+	std::vector<std::thread> threads;
+	threads.reserve( actual_thread_count );
+	for( size_t t= 0u; t < actual_thread_count; t++ )
+	{
+		const size_t begin= std::min( t * words_per_thread * g_bitmap_word_bits, row_count );
+		const size_t end= std::min( begin + words_per_thread * g_bitmap_word_bits, row_count );
+		if( begin == end )
+			break;
+		threads.emplace_back(
+			ExtractColumnsRows,
+			array, descriptions,
+			doubles.data(), ints.data(), strings.data(), validity.data(), column_count,
+			begin, end );
+	}
+	for( std::thread& thread : threads )
+		thread.join();
+
+	return result;
+}
+
+// Aggregation is made for blocks of rows, corresponding to validity words.
+// For fully valid blocks simple loops with independent accumulators are used, which compiler can vectorize.
+// Invalid values are zeros, so, they do not affect sum and masked only for min/max.
+// "SumT" is used for sum, because signed integers overflow is undefined.
+template<class T, class SumT>
+static ColumnAggregates<T> AggregateValues( const T* const values, const uint64_t* const validity, const size_t size ) noexcept
+{
+	constexpr size_t c_lanes= 4u;
+
+	ColumnAggregates<T> result{ 0u, T(0), T(0), T(0) };
+
+	SumT sum[c_lanes]= { SumT(0), SumT(0), SumT(0), SumT(0) };
+	T min[c_lanes];
+	T max[c_lanes];
+	bool have_value= false;
+
+	for( size_t block_start= 0u; block_start < size; block_start+= g_bitmap_word_bits )
+	{
+		const uint64_t word= validity[ block_start / g_bitmap_word_bits ];
+		if( word == 0u )
+			continue;
+
+		const T* const block= values + block_start;
+		const size_t block_size= std::min( size - block_start, g_bitmap_word_bits );
+
+		if( !have_value )
+		{
+			// Initialize min/max with any valid value.
+			size_t first= 0u;
+			while( ( word & ( uint64_t(1u) << first ) ) == 0u )
+				++first;
+			for( size_t l= 0u; l < c_lanes; l++ )
+				min[l]= max[l]= block[first];
+			have_value= true;
+		}
+
+		result.count+= PopCount( word );
+
+		if( word == ~uint64_t(0u) )
+		{
+			for( size_t i= 0u; i < g_bitmap_word_bits; i+= c_lanes )
+			{
+				for( size_t l= 0u; l < c_lanes; l++ )
+				{
+					const T v= block[ i + l ];
+					sum[l]+= SumT(v);
+					min[l]= v < min[l] ? v : min[l];
+					max[l]= v > max[l] ? v : max[l];
+				}
+			}
+		}
+		else
+		{
+			for( size_t i= 0u; i < block_size; i++ )
+			{
+				const T v= block[i];
+				sum[0]+= SumT(v);
+				if( ( word & ( uint64_t(1u) << i ) ) != 0u )
+				{
+					min[0]= v < min[0] ? v : min[0];
+					max[0]= v > max[0] ? v : max[0];
+				}
+			}
+		}
+	}
+
+	if( have_value )
+	{
+		result.sum= T( ( sum[0] + sum[1] ) + ( sum[2] + sum[3] ) );
+		result.min= min[0];
+		result.max= max[0];
+		for( size_t l= 1u; l < c_lanes; l++ )
+		{
+			result.min= min[l] < result.min ? min[l] : result.min;
+			result.max= max[l] > result.max ? max[l] : result.max;
+		}
+	}
+
+	return result;
+}
+
+ColumnAggregates<double> AggregateDoubles( const Column& column ) noexcept
+{
+	if( column.GetType() != ColumnType::Double )
+		return ColumnAggregates<double>{ 0u, 0.0, 0.0, 0.0 };
+	return AggregateValues<double, double>( column.GetDoubles(), column.GetValidityBitmap(), column.GetSize() );
+}
+
+ColumnAggregates<int64_t> AggregateInts( const Column& column ) noexcept
+{
+	if( column.GetType() != ColumnType::Int64 )
+		return ColumnAggregates<int64_t>{ 0u, 0, 0, 0 };
+	return AggregateValues<int64_t, uint64_t>( column.GetInts(), column.GetValidityBitmap(), column.GetSize() );
+}
+
+} // namespace PanzerJson
@@ -0,0 +1,305 @@
+#include <cstring>
+#include <limits>
+
+#include "panzer_json_assert.hpp"
+
+#include "../include/PanzerJson/parser.hpp"
+
+namespace PanzerJson
+{
+
+namespace
+{
+
+// Format bytes, except fixed ranges.
+enum MessagePackFormat : unsigned char
+{
+	c_msgpack_nil= 0xC0,
+	c_msgpack_false= 0xC2,
+	c_msgpack_true= 0xC3,
+	c_msgpack_float32= 0xCA,
+	c_msgpack_float64= 0xCB,
+	c_msgpack_uint8= 0xCC,
+	c_msgpack_uint16= 0xCD,
+	c_msgpack_uint32= 0xCE,
+	c_msgpack_uint64= 0xCF,
+	c_msgpack_int8= 0xD0,
+	c_msgpack_int16= 0xD1,
+	c_msgpack_int32= 0xD2,
+	c_msgpack_int64= 0xD3,
+	c_msgpack_str8= 0xD9,
+	c_msgpack_str16= 0xDA,
+	c_msgpack_str32= 0xDB,
+	c_msgpack_array16= 0xDC,
+	c_msgpack_array32= 0xDD,
+	c_msgpack_map16= 0xDE,
+	c_msgpack_map32= 0xDF,
+};
+
+} // namespace
+
+Parser::ResultPtr Parser::ParseMessagePack( const void* const data, const size_t data_size )
+{
+	bool all_ok= false;
+
+	if( data == nullptr || data_size == 0u )
+	{
+		result_.error= Result::Error::EmptyInput;
+		result_.error_pos= 0u;
+	}
+	else
+	{
+		StartParsing( static_cast<const char*>(data), data_size );
+		const ValueBase* const root= ParseMessagePack_r();
+
+		if( result_.error == Result::Error::NoError )
+		{
+			if( cur_ != end_ )
+				result_.error= Result::Error::ExtraCharactersAfterJsonRoot;
+			else
+				all_ok= FinishParsing( root );
+		}
+	}
+
+	return MakeResult( all_ok );
+}
+
+const ValueBase* Parser::ParseMessagePack_r()
+{
+	if( cur_ == end_ )
+	{
+		result_.error= Result::Error::UnexpectedEndOfFile;
+		return nullptr;
+	}
+
+	const char* const item_start= cur_;
+	const unsigned char format= static_cast<unsigned char>(*cur_);
+	++cur_;
+
+	// Fixed ranges.
+	if( format <= 0x7Fu ) // Positive fixint.
+		return CreateNumber( NumberValue::Kind::Int64, NumberValue::Payload( int64_t(format) ), nullptr, 0u );
+	if( format >= 0xE0u ) // Negative fixint.
+		return CreateNumber( NumberValue::Kind::Int64, NumberValue::Payload( int64_t(format) - 256 ), nullptr, 0u );
+
+	uint64_t length= 0u;
+	enum class Container{ None, String, Array, Map, } container= Container::None;
+	if( format >= 0xA0u && format <= 0xBFu )
+	{
+		container= Container::String;
+		length= format & 0x1Fu;
+	}
+	else if( format >= 0x90u && format <= 0x9Fu )
+	{
+		container= Container::Array;
+		length= format & 0x0Fu;
+	}
+	else if( format >= 0x80u && format <= 0x8Fu )
+	{
+		container= Container::Map;
+		length= format & 0x0Fu;
+	}
+	else
+	{
+		uint64_t bits= 0u;
+		switch( format )
+		{
+		case c_msgpack_nil: return GetNullValue();
+		case c_msgpack_false: return GetBoolValue( false );
+		case c_msgpack_true: return GetBoolValue( true );
+
+		case c_msgpack_float32:
+			{
+				if( !ReadMessagePackUint( sizeof(float), bits ) )
+					return nullptr;
+				const uint32_t bits32= uint32_t(bits);
+				float f;
+				static_assert( sizeof(float) == sizeof(uint32_t), "unexpected float size" );
+				std::memcpy( &f, &bits32, sizeof(float) );
+				return CreateNumber( NumberValue::Kind::Double, NumberValue::Payload( double(f) ), nullptr, 0u );
+			}
+		case c_msgpack_float64:
+			{
+				if( !ReadMessagePackUint( sizeof(double), bits ) )
+					return nullptr;
+				double d;
+				std::memcpy( &d, &bits, sizeof(double) );
+				return CreateNumber( NumberValue::Kind::Double, NumberValue::Payload( d ), nullptr, 0u );
+			}
+
+		case c_msgpack_uint8:
+		case c_msgpack_uint16:
+		case c_msgpack_uint32:
+		case c_msgpack_uint64:
+			if( !ReadMessagePackUint( size_t(1u) << ( format - c_msgpack_uint8 ), bits ) )
+				return nullptr;
+			if( bits <= uint64_t( std::numeric_limits<int64_t>::max() ) )
+				return CreateNumber( NumberValue::Kind::Int64, NumberValue::Payload( int64_t(bits) ), nullptr, 0u );
+			return CreateNumber( NumberValue::Kind::Uint64, NumberValue::Payload( bits ), nullptr, 0u );
+
+		case c_msgpack_int8:
+		case c_msgpack_int16:
+		case c_msgpack_int32:
+		case c_msgpack_int64:
+			{
+				const size_t size= size_t(1u) << ( format - c_msgpack_int8 );
+				if( !ReadMessagePackUint( size, bits ) )
+					return nullptr;
+				// Sign extension.
+				const unsigned int shift= 64u - 8u * unsigned(size);
+				const int64_t value= int64_t( bits << shift ) >> shift;
+				return CreateNumber( NumberValue::Kind::Int64, NumberValue::Payload( value ), nullptr, 0u );
+			}
+
+		case c_msgpack_str8:
+		case c_msgpack_str16:
+		case c_msgpack_str32:
+			container= Container::String;
+			if( !ReadMessagePackUint( size_t(1u) << ( format - c_msgpack_str8 ), length ) )
+				return nullptr;
+			break;
+
+		case c_msgpack_array16:
+		case c_msgpack_array32:
+			container= Container::Array;
+			if( !ReadMessagePackUint( format == c_msgpack_array16 ? 2u : 4u, length ) )
+				return nullptr;
+			break;
+
+		case c_msgpack_map16:
+		case c_msgpack_map32:
+			container= Container::Map;
+			if( !ReadMessagePackUint( format == c_msgpack_map16 ? 2u : 4u, length ) )
+				return nullptr;
+			break;
+
+		default:
+			// Bin, ext and never used format.
+			cur_= item_start;
+			result_.error= Result::Error::UnexpectedLexem;
+			return nullptr;
+		};
+	}
+
+	switch( container )
+	{
+	case Container::String:
+		{
+			// Allocate StringValue, then read string. String storage will be exactly after StringValue.
+			const size_t offset= result_.storage.size();
+			result_.storage.resize( result_.storage.size() + sizeof(StringValue) );
+
+			ParseMessagePackString( length );
+			if( result_.error != Result::Error::NoError )
+				return nullptr;
+
+			StringValue* const string_value= reinterpret_cast<StringValue*>( result_.storage.data() + offset );
+			string_value->type= ValueBase::Type::String;
+			string_value->state.store( StringValue::State::Plain, std::memory_order_relaxed );
+			string_value->length= length < StringValue::c_unknown_length ? uint32_t(length) : StringValue::c_unknown_length;
+
+			return reinterpret_cast<StringValue*>( static_cast<char*>(nullptr) + offset );
+		}
+
+	case Container::Array:
+		{
+			const size_t array_elements_stack_pos= array_elements_stack_.size();
+			for( uint64_t i= 0u; i < length; i++ )
+			{
+				const ValueBase* const value= ParseMessagePack_r();
+				if( result_.error != Result::Error::NoError )
+					return nullptr;
+				array_elements_stack_.push_back( value );
+			}
+			return CreateArray( array_elements_stack_pos );
+		}
+
+	case Container::Map:
+		{
+			const size_t object_entries_stack_pos= object_entries_stack_.size();
+			for( uint64_t i= 0u; i < length; i++ )
+			{
+				if( cur_ == end_ )
+				{
+					result_.error= Result::Error::UnexpectedEndOfFile;
+					return nullptr;
+				}
+
+				// Only str keys are supported.
+				const unsigned char key_format= static_cast<unsigned char>(*cur_);
+				uint64_t key_length= 0u;
+				if( key_format >= 0xA0u && key_format <= 0xBFu )
+				{
+					++cur_;
+					key_length= key_format & 0x1Fu;
+				}
+				else if( key_format >= c_msgpack_str8 && key_format <= c_msgpack_str32 )
+				{
+					++cur_;
+					if( !ReadMessagePackUint( size_t(1u) << ( key_format - c_msgpack_str8 ), key_length ) )
+						return nullptr;
+				}
+				else
+				{
+					result_.error= Result::Error::UnexpectedLexem;
+					return nullptr;
+				}
+
+				StringType key= ParseMessagePackString( key_length );
+				if( result_.error != Result::Error::NoError )
+					return nullptr;
+				if( intern_keys_ )
+					key= InternKey( key );
+
+				const ValueBase* const value= ParseMessagePack_r();
+				if( result_.error != Result::Error::NoError )
+					return nullptr;
+
+				object_entries_stack_.emplace_back( ObjectValue::ObjectEntry{ key, value } );
+			}
+			return CreateObject( object_entries_stack_pos );
+		}
+
+	case Container::None:
+		break;
+	};
+
+	PJ_ASSERT( false ); // Scalar values are returned above.
+	return nullptr;
+}
+
+bool Parser::ReadMessagePackUint( const size_t size, uint64_t& out_value )
+{
+	if( static_cast<size_t>( end_ - cur_ ) < size )
+	{
+		result_.error= Result::Error::UnexpectedEndOfFile;
+		return false;
+	}
+
+	out_value= 0u;
+	for( size_t i= 0u; i < size; i++ )
+		out_value= ( out_value << 8u ) | static_cast<unsigned char>( cur_[i] );
+	cur_+= size;
+	return true;
+}
+
+StringType Parser::ParseMessagePackString( const uint64_t length )
+{
+	if( length > static_cast<uint64_t>( end_ - cur_ ) )
+	{
+		result_.error= Result::Error::UnexpectedEndOfFile;
+		return nullptr;
+	}
+
+	const size_t offset= result_.storage.size();
+	result_.storage.insert( result_.storage.end(), cur_, cur_ + length );
+	cur_+= length;
+
+	result_.storage.push_back( '\0' );
+	// Reconstruct alignment.
+	result_.storage.resize( ( result_.storage.size() + ( sizeof(void*) - 1u ) ) & ~( sizeof(void*) - 1u ) );
+
+	return static_cast<StringType>(nullptr) + offset;
+}
+
+} // namespace PanzerJson
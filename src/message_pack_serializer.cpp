@@ -0,0 +1,226 @@
+#include <cmath>
+#include <cstring>
+
+#include "../include/PanzerJson/message_pack_serializer.hpp"
+
+namespace PanzerJson
+{
+
+MessagePackSerializer::MessagePackSerializer( OutputBuffer& out ) noexcept
+	: out_(out)
+{}
+
+bool MessagePackSerializer::AddValue( const Value value )
+{
+	const ValueBase& internal_value= *value.GetInternalValue();
+	if( internal_value.type == ValueBase::Type::Number )
+	{
+		// Value may be inline number, without own number value, so, use only value methods.
+		switch( static_cast<const NumberValue&>(internal_value).kind )
+		{
+		case NumberValue::Kind::Int64: AddNumber( value.AsInt64() ); return true;
+		case NumberValue::Kind::Uint64: AddNumber( value.AsUint64() ); return true;
+		case NumberValue::Kind::Double: AddNumber( value.AsDouble() ); return true;
+		case NumberValue::Kind::Lazy: break;
+		};
+	}
+	return SerializeValue( internal_value );
+}
+
+void MessagePackSerializer::AddNull()
+{
+	out_.Write( char(0xC0) );
+}
+
+void MessagePackSerializer::AddBool( const bool value )
+{
+	out_.Write( value ? char(0xC3) : char(0xC2) );
+}
+
+void MessagePackSerializer::AddNumberInternal( const int64_t value )
+{
+	if( value >= 0 )
+		AddNumberInternal( uint64_t(value) );
+	else if( value >= -32 )
+		out_.Write( char( value ) ); // Negative fixint.
+	else if( value >= INT8_MIN )
+		WriteHead( 0xD0u, uint64_t(value), 1u );
+	else if( value >= INT16_MIN )
+		WriteHead( 0xD1u, uint64_t(value), 2u );
+	else if( value >= INT32_MIN )
+		WriteHead( 0xD2u, uint64_t(value), 4u );
+	else
+		WriteHead( 0xD3u, uint64_t(value), 8u );
+}
+
+void MessagePackSerializer::AddNumberInternal( const uint64_t value )
+{
+	if( value <= 0x7Fu )
+		out_.Write( char( value ) ); // Positive fixint.
+	else if( value <= 0xFFu )
+		WriteHead( 0xCCu, value, 1u );
+	else if( value <= 0xFFFFu )
+		WriteHead( 0xCDu, value, 2u );
+	else if( value <= 0xFFFFFFFFu )
+		WriteHead( 0xCEu, value, 4u );
+	else
+		WriteHead( 0xCFu, value, 8u );
+}
+
+void MessagePackSerializer::AddNumberInternal( const double value )
+{
+	const float f= static_cast<float>(value);
+	if( static_cast<double>(f) == value || std::isnan(value) )
+	{
+		uint32_t bits;
+		std::memcpy( &bits, &f, sizeof(float) );
+		WriteHead( 0xCAu, bits, 4u );
+	}
+	else
+	{
+		uint64_t bits;
+		std::memcpy( &bits, &value, sizeof(double) );
+		WriteHead( 0xCBu, bits, 8u );
+	}
+}
+
+bool MessagePackSerializer::AddString( const StringView& str )
+{
+	if( uint64_t(str.size) > 0xFFFFFFFFu )
+		return false;
+
+	if( str.size <= 31u )
+		out_.Write( char( 0xA0u | str.size ) ); // Fixstr.
+	else if( str.size <= 0xFFu )
+		WriteHead( 0xD9u, str.size, 1u );
+	else if( str.size <= 0xFFFFu )
+		WriteHead( 0xDAu, str.size, 2u );
+	else
+		WriteHead( 0xDBu, str.size, 4u );
+	out_.Write( str.data, str.size );
+	return true;
+}
+
+bool MessagePackSerializer::AddArray( const size_t element_count )
+{
+	if( uint64_t(element_count) > 0xFFFFFFFFu )
+		return false;
+
+	if( element_count <= 15u )
+		out_.Write( char( 0x90u | element_count ) ); // Fixarray.
+	else if( element_count <= 0xFFFFu )
+		WriteHead( 0xDCu, element_count, 2u );
+	else
+		WriteHead( 0xDDu, element_count, 4u );
+	return true;
+}
+
+bool MessagePackSerializer::AddMap( const size_t member_count )
+{
+	if( uint64_t(member_count) > 0xFFFFFFFFu )
+		return false;
+
+	if( member_count <= 15u )
+		out_.Write( char( 0x80u | member_count ) ); // Fixmap.
+	else if( member_count <= 0xFFFFu )
+		WriteHead( 0xDEu, member_count, 2u );
+	else
+		WriteHead( 0xDFu, member_count, 4u );
+	return true;
+}
+
+bool MessagePackSerializer::SerializeValue( const ValueBase& value )
+{
+	switch( value.type )
+	{
+	case ValueBase::Type::Null:
+		AddNull();
+		break;
+
+	case ValueBase::Type::Bool:
+		AddBool( static_cast<const BoolValue&>(value).value );
+		break;
+
+	case ValueBase::Type::Number:
+		SerializeNumber( static_cast<const NumberValue&>(value) );
+		break;
+
+	case ValueBase::Type::String:
+		return AddString( static_cast<const StringValue&>(value).GetStringView() );
+
+	case ValueBase::Type::Object:
+		{
+			const ObjectValue& object= static_cast<const ObjectValue&>(value);
+			if( !AddMap( object.object_count ) )
+				return false;
+			for( size_t i= 0u; i < object.object_count; i++ )
+			{
+				if( !AddString( StringView( object.GetKey(i) ) ) || !SerializeElement( object.GetValue(i) ) )
+					return false;
+			}
+		}
+		break;
+
+	case ValueBase::Type::Array:
+		{
+			const ArrayValue& array= static_cast<const ArrayValue&>(value);
+			if( !AddArray( array.object_count ) )
+				return false;
+			switch( array.layout )
+			{
+			case ArrayValue::Layout::Elements:
+				for( size_t i= 0u; i < array.object_count; i++ )
+				{
+					if( !SerializeElement( array.GetElements()[i] ) )
+						return false;
+				}
+				break;
+			case ArrayValue::Layout::PackedDoubles:
+				for( size_t i= 0u; i < array.object_count; i++ )
+					AddNumber( array.GetPackedDoubles()[i] );
+				break;
+			case ArrayValue::Layout::PackedInt64s:
+				for( size_t i= 0u; i < array.object_count; i++ )
+					AddNumber( array.GetPackedInt64s()[i] );
+				break;
+			};
+		}
+		break;
+	};
+
+	return true;
+}
+
+bool MessagePackSerializer::SerializeElement( const ValueBase* const value )
+{
+	if( IsInlineNumber( value ) )
+	{
+		AddNumber( GetInlineNumber( value ) );
+		return true;
+	}
+	return SerializeValue( *value );
+}
+
+void MessagePackSerializer::SerializeNumber( const NumberValue& number )
+{
+	const NumberValue converted= number.GetConverted();
+	switch( converted.kind )
+	{
+	case NumberValue::Kind::Int64: AddNumber( converted.payload.int_value ); break;
+	case NumberValue::Kind::Uint64: AddNumber( converted.payload.uint_value ); break;
+	case NumberValue::Kind::Double: AddNumber( converted.payload.double_value ); break;
+	case NumberValue::Kind::Lazy: break; // Converted number is never lazy.
+	};
+}
+
+void MessagePackSerializer::WriteHead( const unsigned char format, const uint64_t argument, const size_t argument_size )
+{
+	// Format byte and big-endian argument.
+	char bytes[9];
+	bytes[0]= char(format);
+	for( size_t i= 0u; i < argument_size; i++ )
+		bytes[ 1u + i ]= char( argument >> ( 8u * ( argument_size - 1u - i ) ) );
+	out_.Write( bytes, 1u + argument_size );
+}
+
+} // namespace PanzerJson
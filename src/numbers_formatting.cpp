@@ -0,0 +1,422 @@
+#include <cstring>
+
+#include "numbers_formatting.hpp"
+
+namespace PanzerJson
+{
+
+// Pairs of decimal digits for numbers 0-99.
+static const char g_two_digits[201]=
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+size_t FormatUint64( uint64_t value, char* const out ) noexcept
+{
+	// Write digits from end of temp buffer, two digits per step.
+	char buffer[20];
+	char* p= buffer + sizeof(buffer);
+	while( value >= 100u )
+	{
+		const size_t index= static_cast<size_t>( value % 100u ) * 2u;
+		value/= 100u;
+		p-= 2;
+		std::memcpy( p, g_two_digits + index, 2u );
+	}
+	if( value >= 10u )
+	{
+		p-= 2;
+		std::memcpy( p, g_two_digits + value * 2u, 2u );
+	}
+	else
+	{
+		--p;
+		*p= static_cast<char>( '0' + value );
+	}
+
+	const size_t length= static_cast<size_t>( buffer + sizeof(buffer) - p );
+	std::memcpy( out, p, length );
+	return length;
+}
+
+size_t FormatInt64( const int64_t value, char* const out ) noexcept
+{
+	if( value >= 0 )
+		return FormatUint64( static_cast<uint64_t>(value), out );
+
+	out[0]= '-';
+	// Negate in unsigned type, because min int64 can not be negated in signed type.
+	return 1u + FormatUint64( uint64_t(0u) - static_cast<uint64_t>(value), out + 1u );
+}
+
+namespace
+{
+
+// Floating point number "f * 2^e" with 64-bit significand.
+struct DiyFp final
+{
+	uint64_t f;
+	int e;
+};
+
+const uint64_t c_double_significand_mask= 0x000FFFFFFFFFFFFFull;
+const uint64_t c_double_exponent_mask= 0x7FF0000000000000ull;
+const uint64_t c_double_hidden_bit= 0x0010000000000000ull;
+const int c_double_significand_size= 52;
+const int c_double_exponent_bias= 0x3FF + c_double_significand_size;
+const int c_double_min_exponent= -c_double_exponent_bias;
+
+DiyFp DoubleToDiyFp( const double d ) noexcept
+{
+	uint64_t bits;
+	std::memcpy( &bits, &d, sizeof(double) );
+
+	const int biased_exponent= static_cast<int>( ( bits & c_double_exponent_mask ) >> c_double_significand_size );
+	const uint64_t significand= bits & c_double_significand_mask;
+	if( biased_exponent != 0 )
+		return DiyFp{ significand + c_double_hidden_bit, biased_exponent - c_double_exponent_bias };
+	else // Denormalized number.
+		return DiyFp{ significand, c_double_min_exponent + 1 };
+}
+
+DiyFp Multiply( const DiyFp& l, const DiyFp& r ) noexcept
+{
+	// Take upper 64 bits of 128-bit product with rounding.
+	const uint64_t mask32= 0xFFFFFFFFu;
+	const uint64_t a= l.f >> 32u;
+	const uint64_t b= l.f & mask32;
+	const uint64_t c= r.f >> 32u;
+	const uint64_t d= r.f & mask32;
+	const uint64_t ac= a * c;
+	const uint64_t bc= b * c;
+	const uint64_t ad= a * d;
+	const uint64_t bd= b * d;
+	uint64_t tmp= ( bd >> 32u ) + ( ad & mask32 ) + ( bc & mask32 );
+	tmp+= uint64_t(1u) << 31u; // Round.
+	return DiyFp{ ac + ( ad >> 32u ) + ( bc >> 32u ) + ( tmp >> 32u ), l.e + r.e + 64 };
+}
+
+DiyFp Normalize( DiyFp x ) noexcept
+{
+	while( ( x.f & ( uint64_t(1u) << 63u ) ) == 0u )
+	{
+		x.f<<= 1u;
+		--x.e;
+	}
+	return x;
+}
+
+// Calculates normalized boundaries "m-" and "m+" of interval of values, which are rounded to "v".
+void GetNormalizedBoundaries( const DiyFp& v, DiyFp& out_minus, DiyFp& out_plus ) noexcept
+{
+	DiyFp plus{ ( v.f << 1u ) + 1u, v.e - 1 };
+	while( ( plus.f & ( c_double_hidden_bit << 1u ) ) == 0u )
+	{
+		plus.f<<= 1u;
+		--plus.e;
+	}
+	const int shift= 64 - c_double_significand_size - 2;
+	plus.f<<= shift;
+	plus.e-= shift;
+
+	// Lower boundary is closer, if significand is power of two.
+	DiyFp minus= v.f == c_double_hidden_bit ? DiyFp{ ( v.f << 2u ) - 1u, v.e - 2 } : DiyFp{ ( v.f << 1u ) - 1u, v.e - 1 };
+	minus.f<<= minus.e - plus.e;
+	minus.e= plus.e;
+
+	out_minus= minus;
+	out_plus= plus;
+}
+
+struct CachedPower final
+{
+	uint64_t f;
+	int e;
+};
+
+// Normalized powers 1e-348, 1e-340, ... 1e340.
+const CachedPower g_cached_powers[]
+{
+	{ 0xfa8fd5a0081c0288ull, -1220 }, // 1e-348
+	{ 0xbaaee17fa23ebf76ull, -1193 }, // 1e-340
+	{ 0x8b16fb203055ac76ull, -1166 }, // 1e-332
+	{ 0xcf42894a5dce35eaull, -1140 }, // 1e-324
+	{ 0x9a6bb0aa55653b2dull, -1113 }, // 1e-316
+	{ 0xe61acf033d1a45dfull, -1087 }, // 1e-308
+	{ 0xab70fe17c79ac6caull, -1060 }, // 1e-300
+	{ 0xff77b1fcbebcdc4full, -1034 }, // 1e-292
+	{ 0xbe5691ef416bd60cull, -1007 }, // 1e-284
+	{ 0x8dd01fad907ffc3cull,  -980 }, // 1e-276
+	{ 0xd3515c2831559a83ull,  -954 }, // 1e-268
+	{ 0x9d71ac8fada6c9b5ull,  -927 }, // 1e-260
+	{ 0xea9c227723ee8bcbull,  -901 }, // 1e-252
+	{ 0xaecc49914078536dull,  -874 }, // 1e-244
+	{ 0x823c12795db6ce57ull,  -847 }, // 1e-236
+	{ 0xc21094364dfb5637ull,  -821 }, // 1e-228
+	{ 0x9096ea6f3848984full,  -794 }, // 1e-220
+	{ 0xd77485cb25823ac7ull,  -768 }, // 1e-212
+	{ 0xa086cfcd97bf97f4ull,  -741 }, // 1e-204
+	{ 0xef340a98172aace5ull,  -715 }, // 1e-196
+	{ 0xb23867fb2a35b28eull,  -688 }, // 1e-188
+	{ 0x84c8d4dfd2c63f3bull,  -661 }, // 1e-180
+	{ 0xc5dd44271ad3cdbaull,  -635 }, // 1e-172
+	{ 0x936b9fcebb25c996ull,  -608 }, // 1e-164
+	{ 0xdbac6c247d62a584ull,  -582 }, // 1e-156
+	{ 0xa3ab66580d5fdaf6ull,  -555 }, // 1e-148
+	{ 0xf3e2f893dec3f126ull,  -529 }, // 1e-140
+	{ 0xb5b5ada8aaff80b8ull,  -502 }, // 1e-132
+	{ 0x87625f056c7c4a8bull,  -475 }, // 1e-124
+	{ 0xc9bcff6034c13053ull,  -449 }, // 1e-116
+	{ 0x964e858c91ba2655ull,  -422 }, // 1e-108
+	{ 0xdff9772470297ebdull,  -396 }, // 1e-100
+	{ 0xa6dfbd9fb8e5b88full,  -369 }, // 1e-92
+	{ 0xf8a95fcf88747d94ull,  -343 }, // 1e-84
+	{ 0xb94470938fa89bcfull,  -316 }, // 1e-76
+	{ 0x8a08f0f8bf0f156bull,  -289 }, // 1e-68
+	{ 0xcdb02555653131b6ull,  -263 }, // 1e-60
+	{ 0x993fe2c6d07b7facull,  -236 }, // 1e-52
+	{ 0xe45c10c42a2b3b06ull,  -210 }, // 1e-44
+	{ 0xaa242499697392d3ull,  -183 }, // 1e-36
+	{ 0xfd87b5f28300ca0eull,  -157 }, // 1e-28
+	{ 0xbce5086492111aebull,  -130 }, // 1e-20
+	{ 0x8cbccc096f5088ccull,  -103 }, // 1e-12
+	{ 0xd1b71758e219652cull,   -77 }, // 1e-4
+	{ 0x9c40000000000000ull,   -50 }, // 1e4
+	{ 0xe8d4a51000000000ull,   -24 }, // 1e12
+	{ 0xad78ebc5ac620000ull,     3 }, // 1e20
+	{ 0x813f3978f8940984ull,    30 }, // 1e28
+	{ 0xc097ce7bc90715b3ull,    56 }, // 1e36
+	{ 0x8f7e32ce7bea5c70ull,    83 }, // 1e44
+	{ 0xd5d238a4abe98068ull,   109 }, // 1e52
+	{ 0x9f4f2726179a2245ull,   136 }, // 1e60
+	{ 0xed63a231d4c4fb27ull,   162 }, // 1e68
+	{ 0xb0de65388cc8ada8ull,   189 }, // 1e76
+	{ 0x83c7088e1aab65dbull,   216 }, // 1e84
+	{ 0xc45d1df942711d9aull,   242 }, // 1e92
+	{ 0x924d692ca61be758ull,   269 }, // 1e100
+	{ 0xda01ee641a708deaull,   295 }, // 1e108
+	{ 0xa26da3999aef774aull,   322 }, // 1e116
+	{ 0xf209787bb47d6b85ull,   348 }, // 1e124
+	{ 0xb454e4a179dd1877ull,   375 }, // 1e132
+	{ 0x865b86925b9bc5c2ull,   402 }, // 1e140
+	{ 0xc83553c5c8965d3dull,   428 }, // 1e148
+	{ 0x952ab45cfa97a0b3ull,   455 }, // 1e156
+	{ 0xde469fbd99a05fe3ull,   481 }, // 1e164
+	{ 0xa59bc234db398c25ull,   508 }, // 1e172
+	{ 0xf6c69a72a3989f5cull,   534 }, // 1e180
+	{ 0xb7dcbf5354e9beceull,   561 }, // 1e188
+	{ 0x88fcf317f22241e2ull,   588 }, // 1e196
+	{ 0xcc20ce9bd35c78a5ull,   614 }, // 1e204
+	{ 0x98165af37b2153dfull,   641 }, // 1e212
+	{ 0xe2a0b5dc971f303aull,   667 }, // 1e220
+	{ 0xa8d9d1535ce3b396ull,   694 }, // 1e228
+	{ 0xfb9b7cd9a4a7443cull,   720 }, // 1e236
+	{ 0xbb764c4ca7a44410ull,   747 }, // 1e244
+	{ 0x8bab8eefb6409c1aull,   774 }, // 1e252
+	{ 0xd01fef10a657842cull,   800 }, // 1e260
+	{ 0x9b10a4e5e9913129ull,   827 }, // 1e268
+	{ 0xe7109bfba19c0c9dull,   853 }, // 1e276
+	{ 0xac2820d9623bf429ull,   880 }, // 1e284
+	{ 0x80444b5e7aa7cf85ull,   907 }, // 1e292
+	{ 0xbf21e44003acdd2dull,   933 }, // 1e300
+	{ 0x8e679c2f5e44ff8full,   960 }, // 1e308
+	{ 0xd433179d9c8cb841ull,   986 }, // 1e316
+	{ 0x9e19db92b4e31ba9ull,  1013 }, // 1e324
+	{ 0xeb96bf6ebadf77d9ull,  1039 }, // 1e332
+	{ 0xaf87023b9bf0ee6bull,  1066 }, // 1e340
+};
+
+// Returns power of ten "c", for which exponent of "c * 2^e" is in range [-60, -32]. Writes decimal exponent of "1/c" into "out_k".
+DiyFp GetCachedPower( const int e, int& out_k ) noexcept
+{
+	const double dk= ( -61 - e ) * 0.30102999566398114 + 347.0; // Multiplier is log10(2).
+	int k= static_cast<int>(dk);
+	if( dk - k > 0.0 )
+		++k;
+
+	const size_t index= static_cast<size_t>( ( k >> 3 ) + 1 );
+	out_k= -( -348 + static_cast<int>( index << 3u ) );
+	return DiyFp{ g_cached_powers[index].f, g_cached_powers[index].e };
+}
+
+const uint64_t g_pow10[]
+{
+	1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+	10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+	1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+};
+
+int CountDecimalDigits32( const uint32_t n ) noexcept
+{
+	// Number of digits in "DigitGen" never exceeds 9.
+	int count= 1;
+	while( count < 9 && n >= g_pow10[count] )
+		++count;
+	return count;
+}
+
+// Moves last digit closer to exact value.
+void GrisuRound( char* const buffer, const size_t length, const uint64_t delta, uint64_t rest, const uint64_t ten_kappa, const uint64_t wp_w ) noexcept
+{
+	while(
+		rest < wp_w && delta - rest >= ten_kappa &&
+		( rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w ) )
+	{
+		--buffer[ length - 1u ];
+		rest+= ten_kappa;
+	}
+}
+
+// Generates digits of "mp" until they are inside interval [mp - delta, mp].
+void DigitGen( const DiyFp& w, const DiyFp& mp, uint64_t delta, char* const buffer, size_t& length, int& k ) noexcept
+{
+	const int one_e= mp.e;
+	const uint64_t one_f= uint64_t(1u) << static_cast<unsigned int>(-one_e);
+	const uint64_t wp_w= mp.f - w.f;
+	uint32_t p1= static_cast<uint32_t>( mp.f >> static_cast<unsigned int>(-one_e) );
+	uint64_t p2= mp.f & ( one_f - 1u );
+	int kappa= CountDecimalDigits32( p1 );
+	length= 0u;
+
+	// Integer part.
+	while( kappa > 0 )
+	{
+		const uint32_t divider= static_cast<uint32_t>( g_pow10[ kappa - 1 ] );
+		const uint32_t d= p1 / divider;
+		p1%= divider;
+		if( d != 0u || length != 0u )
+			buffer[ length++ ]= static_cast<char>( '0' + d );
+		--kappa;
+
+		const uint64_t rest= ( static_cast<uint64_t>(p1) << static_cast<unsigned int>(-one_e) ) + p2;
+		if( rest <= delta )
+		{
+			k+= kappa;
+			GrisuRound( buffer, length, delta, rest, g_pow10[kappa] << static_cast<unsigned int>(-one_e), wp_w );
+			return;
+		}
+	}
+
+	// Fractional part.
+	while(true)
+	{
+		p2*= 10u;
+		delta*= 10u;
+		const char d= static_cast<char>( p2 >> static_cast<unsigned int>(-one_e) );
+		if( d != 0 || length != 0u )
+			buffer[ length++ ]= static_cast<char>( '0' + d );
+		p2&= one_f - 1u;
+		--kappa;
+		if( p2 < delta )
+		{
+			k+= kappa;
+			const int index= -kappa;
+			GrisuRound( buffer, length, delta, p2, one_f, wp_w * ( index < 20 ? g_pow10[index] : 0u ) );
+			return;
+		}
+	}
+}
+
+// Writes digits of positive finite double into "buffer". Value is equal to "digits * 10^k".
+void Grisu2( const double value, char* const buffer, size_t& length, int& k ) noexcept
+{
+	const DiyFp v= DoubleToDiyFp( value );
+	DiyFp w_minus, w_plus;
+	GetNormalizedBoundaries( v, w_minus, w_plus );
+
+	const DiyFp c_mk= GetCachedPower( w_plus.e, k );
+	const DiyFp w= Multiply( Normalize( v ), c_mk );
+	DiyFp wp= Multiply( w_plus, c_mk );
+	DiyFp wm= Multiply( w_minus, c_mk );
+	// Make interval narrower, because multiplication result is not exact.
+	++wm.f;
+	--wp.f;
+	DigitGen( w, wp, wp.f - wm.f, buffer, length, k );
+}
+
+// Writes digits with decimal point or exponent.
+size_t Prettify( char* const buffer, const size_t length, const int k ) noexcept
+{
+	const int decimal_point_pos= static_cast<int>(length) + k; // 10^(decimal_point_pos - 1) <= v < 10^decimal_point_pos
+
+	if( k >= 0 && decimal_point_pos <= 21 )
+	{
+		// 1234e7 -> 12340000000.0
+		std::memset( buffer + length, '0', static_cast<size_t>(k) );
+		buffer[ decimal_point_pos ]= '.';
+		buffer[ decimal_point_pos + 1 ]= '0';
+		return static_cast<size_t>( decimal_point_pos + 2 );
+	}
+	if( decimal_point_pos > 0 && decimal_point_pos <= 21 )
+	{
+		// 1234e-2 -> 12.34
+		std::memmove( buffer + decimal_point_pos + 1, buffer + decimal_point_pos, length - static_cast<size_t>(decimal_point_pos) );
+		buffer[ decimal_point_pos ]= '.';
+		return length + 1u;
+	}
+	if( decimal_point_pos > -6 && decimal_point_pos <= 0 )
+	{
+		// 1234e-6 -> 0.001234
+		const size_t offset= static_cast<size_t>( 2 - decimal_point_pos );
+		std::memmove( buffer + offset, buffer, length );
+		buffer[0]= '0';
+		buffer[1]= '.';
+		std::memset( buffer + 2, '0', offset - 2u );
+		return length + offset;
+	}
+
+	// Exponential format: 1e30, 1.234e-30.
+	size_t result_length= length;
+	if( length > 1u )
+	{
+		std::memmove( buffer + 2, buffer + 1, length - 1u );
+		buffer[1]= '.';
+		++result_length;
+	}
+	buffer[ result_length++ ]= 'e';
+	return result_length + FormatInt64( decimal_point_pos - 1, buffer + result_length );
+}
+
+} // namespace
+
+size_t FormatDouble( const double value, char* const out ) noexcept
+{
+	// Json has no representation for infinities and NaN. Write them like "printf" does.
+	if( value != value )
+	{
+		std::memcpy( out, "nan", 3u );
+		return 3u;
+	}
+
+	uint64_t bits;
+	std::memcpy( &bits, &value, sizeof(double) );
+	const bool negative= ( bits >> 63u ) != 0u;
+	char* const digits= out + ( negative ? 1u : 0u );
+	if( negative )
+		out[0]= '-';
+
+	if( ( bits & c_double_exponent_mask ) == c_double_exponent_mask )
+	{
+		std::memcpy( digits, "inf", 3u );
+		return ( negative ? 1u : 0u ) + 3u;
+	}
+	if( ( bits & ~( uint64_t(1u) << 63u ) ) == 0u )
+	{
+		std::memcpy( digits, "0.0", 3u );
+		return ( negative ? 1u : 0u ) + 3u;
+	}
+
+	size_t length= 0u;
+	int k= 0;
+	Grisu2( negative ? -value : value, digits, length, k );
+	return ( negative ? 1u : 0u ) + Prettify( digits, length, k );
+}
+
+} // namespace PanzerJson
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace PanzerJson
+{
+
+// Maximum length of result of numbers formatting functions.
+constexpr size_t c_max_formatted_number_length= 32u;
+
+// Functions write number string into "out" without terminating null and return its length.
+
+// Writes shortest (in most cases) string, which is converted back exactly to same double.
+// Uses Grisu2 algorithm.
+// Integer values are written with ".0", big and small values - with exponent.
+size_t FormatDouble( double value, char* out ) noexcept;
+
+size_t FormatInt64( int64_t value, char* out ) noexcept;
+size_t FormatUint64( uint64_t value, char* out ) noexcept;
+
+// Overloaded wrappers for generic code.
+inline size_t FormatNumber( const double value, char* const out ) noexcept { return FormatDouble( value, out ); }
+inline size_t FormatNumber( const int64_t value, char* const out ) noexcept { return FormatInt64( value, out ); }
+inline size_t FormatNumber( const uint64_t value, char* const out ) noexcept { return FormatUint64( value, out ); }
+
+} // namespace PanzerJson
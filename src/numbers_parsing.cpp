@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <limits>
+
+#include "numbers_parsing.hpp"
+
+namespace PanzerJson
+{
+
+// For big powers.
+// Method is faster for big powers - complexity is about O(log2(power)).
+static double TenPowerDouble( const unsigned int power ) noexcept
+{
+	if( power == 0u )
+		return 1.0;
+	if( power == 1u )
+		return 10.0;
+
+	const double half_power= TenPowerDouble( power / 2u );
+	double result= half_power * half_power;
+	if( ( power & 1u ) != 0u )
+		result*= 10.0;
+
+	return result;
+}
+
+static bool IsDigit( const char c ) noexcept
+{
+	return c >= '0' && c <= '9';
+}
+
+void ParseNumber( const char* str, const char* const str_end, NumberValue::Kind& out_kind, NumberValue::Payload& out_payload ) noexcept
+{
+	constexpr uint64_t c_max_uint64= std::numeric_limits<uint64_t>::max();
+	constexpr uint64_t c_max_abs_int64= c_max_uint64 / 2u + 1u;
+	constexpr unsigned int c_max_exponent= 65536u; // Max reasonable exponent.
+
+	bool is_negative= false;
+	if( str < str_end && *str == '-' )
+	{
+		is_negative= true;
+		++str;
+	}
+
+	// Digits of number are digits of integer part and digits of fractional part.
+	const char* const int_digits= str;
+	while( str < str_end && IsDigit(*str) )
+		++str;
+	const int int_digit_count= static_cast<int>( str - int_digits );
+
+	const char* frac_digits= str;
+	int frac_digit_count= 0;
+	if( str < str_end && *str == '.' )
+	{
+		++str;
+		frac_digits= str;
+		while( str < str_end && IsDigit(*str) )
+			++str;
+		frac_digit_count= static_cast<int>( str - frac_digits );
+	}
+
+	int exponent= 0;
+	if( str < str_end && ( *str == 'e' || *str == 'E' ) )
+	{
+		++str;
+		bool exponent_is_negative= false;
+		if( str < str_end && ( *str == '+' || *str == '-' ) )
+		{
+			exponent_is_negative= *str == '-';
+			++str;
+		}
+
+		unsigned int exponent_abs= 0u;
+		while( str < str_end && IsDigit(*str) )
+		{
+			exponent_abs= std::min( exponent_abs * 10u + static_cast<unsigned int>( *str - '0' ), c_max_exponent );
+			++str;
+		}
+		exponent= exponent_is_negative ? -static_cast<int>(exponent_abs) : static_cast<int>(exponent_abs);
+	}
+
+	const int digit_count= int_digit_count + frac_digit_count;
+	const auto get_digit=
+	[&]( const int i ) -> unsigned int
+	{
+		return static_cast<unsigned int>( ( i < int_digit_count ? int_digits[i] : frac_digits[ i - int_digit_count ] ) - '0' );
+	};
+	const int decimal_point_pos= int_digit_count + exponent;
+
+	// Extract integer value. It is exact, if number has no fractional part and there is no overflow.
+	uint64_t result_uint_val= 0u;
+	bool is_exact_integer= true;
+	for( int i= 0; i < std::min( decimal_point_pos, digit_count ); i++ )
+	{
+		const uint64_t mul10= result_uint_val * 10u;
+		if( mul10 / 10u != result_uint_val ) // Detect overflow.
+		{
+			is_exact_integer= false;
+			break;
+		}
+
+		const uint64_t add_digit= mul10 + get_digit(i);
+		if( add_digit < mul10 ) // Detect overflow.
+		{
+			is_exact_integer= false;
+			break;
+		}
+
+		result_uint_val= add_digit;
+	}
+	for( int i= digit_count; i < decimal_point_pos && is_exact_integer && result_uint_val != 0u; i++ )
+	{
+		const uint64_t mul10= result_uint_val * 10u;
+		if( mul10 / 10u != result_uint_val ) // Detect overflow.
+		{
+			is_exact_integer= false;
+			break;
+		}
+		result_uint_val= mul10;
+	}
+	for( int i= std::max( decimal_point_pos, 0 ); i < digit_count && is_exact_integer; i++ )
+	{
+		if( get_digit(i) != 0u )
+			is_exact_integer= false;
+	}
+
+	if( is_exact_integer )
+	{
+		if( !is_negative )
+		{
+			if( result_uint_val <= c_max_abs_int64 - 1u )
+			{
+				out_kind= NumberValue::Kind::Int64;
+				out_payload.int_value= static_cast<int64_t>( result_uint_val );
+			}
+			else
+			{
+				out_kind= NumberValue::Kind::Uint64;
+				out_payload.uint_value= result_uint_val;
+			}
+			return;
+		}
+
+		// Negative zero stored as double, for preserving of sign.
+		if( result_uint_val != 0u && result_uint_val <= c_max_abs_int64 )
+		{
+			out_kind= NumberValue::Kind::Int64;
+			// Negate in unsigned arithmetic, for avoiding overflow for min int64.
+			out_payload.int_value= static_cast<int64_t>( 0u - result_uint_val );
+			return;
+		}
+	}
+
+	double result_double_val= 0.0;
+	for( int i= 0; i < digit_count; i++ )
+		result_double_val= result_double_val * 10.0 + double( get_digit(i) );
+
+	const int double_exponent= decimal_point_pos - digit_count;
+	if( double_exponent >= 0 )
+		result_double_val*= TenPowerDouble( static_cast<unsigned int>(+double_exponent) );
+	else
+		result_double_val/= TenPowerDouble( static_cast<unsigned int>(-double_exponent) );
+
+	if( is_negative )
+		result_double_val*= -1.0;
+
+	out_kind= NumberValue::Kind::Double;
+	out_payload.double_value= result_double_val;
+}
+
+} // namespace PanzerJson
@@ -0,0 +1,12 @@
+#pragma once
+#include "../include/PanzerJson/value.hpp"
+
+namespace PanzerJson
+{
+
+// Converts json number string to number kind and payload.
+// String must be valid json number, without any other symbols.
+// Exact integers are converted to integer kinds, other numbers - to doubles.
+void ParseNumber( const char* str, const char* str_end, NumberValue::Kind& out_kind, NumberValue::Payload& out_payload ) noexcept;
+
+} // namespace PanzerJson
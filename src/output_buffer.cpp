@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include "../include/PanzerJson/output_buffer.hpp"
+#include "panzer_json_assert.hpp"
+
+namespace PanzerJson
+{
+
+static const size_t g_min_growable_buffer_size= 256u;
+
+OutputBuffer::OutputBuffer() noexcept
+	: begin_(nullptr), cur_(nullptr), end_(nullptr)
+	, flush_function_(nullptr), user_data_(nullptr)
+{}
+
+OutputBuffer::OutputBuffer( char* const buffer, const size_t buffer_size, const FlushFunction flush_function, void* const user_data ) noexcept
+	: begin_(buffer), cur_(buffer), end_(buffer + buffer_size)
+	, flush_function_(flush_function), user_data_(user_data)
+{
+	PJ_ASSERT( buffer != nullptr && buffer_size > 0u );
+	PJ_ASSERT( flush_function != nullptr );
+}
+
+void OutputBuffer::Flush()
+{
+	if( flush_function_ != nullptr && cur_ != begin_ )
+	{
+		flush_function_( user_data_, begin_, GetSize() );
+		cur_= begin_;
+	}
+}
+
+void OutputBuffer::Overflow( const size_t size )
+{
+	if( flush_function_ != nullptr )
+	{
+		PJ_ASSERT( size <= static_cast<size_t>( end_ - begin_ ) );
+		Flush();
+		return;
+	}
+
+	const size_t used_size= GetSize();
+	const size_t capacity= static_cast<size_t>( end_ - begin_ );
+	const size_t new_capacity= std::max( std::max( capacity * 2u, used_size + size ), g_min_growable_buffer_size );
+
+	std::unique_ptr<char[]> new_storage( new char[ new_capacity ] );
+	if( used_size > 0u )
+		std::memcpy( new_storage.get(), begin_, used_size );
+	storage_= std::move(new_storage);
+
+	begin_= storage_.get();
+	cur_= begin_ + used_size;
+	end_= begin_ + new_capacity;
+}
+
+void OutputBuffer::WriteSlow( const char* const data, const size_t size )
+{
+	if( flush_function_ != nullptr && size > static_cast<size_t>( end_ - begin_ ) )
+	{
+		// Data is bigger, than whole buffer - pass it into flush function directly.
+		Flush();
+		flush_function_( user_data_, data, size );
+		return;
+	}
+
+	Overflow( size );
+	std::memcpy( cur_, data, size );
+	cur_+= size;
+}
+
+} // namespace PanzerJson
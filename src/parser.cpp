@@ -1,7 +1,10 @@
 #include <algorithm>
 #include <cstring>
+#include <limits>
 
+#include "numbers_parsing.hpp"
 #include "panzer_json_assert.hpp"
+#include "strings_parsing.hpp"
 
 #include "../include/PanzerJson/parser.hpp"
 
@@ -17,7 +20,7 @@ struct FrequentValues final
 	NullValue null_value;
 	BoolValue true_value;
 	BoolValue false_value;
-	char padding[3u];
+	char padding[2u];
 	// TODO - maybe reuse zero too?
 	// TODO - maybe reuse empty strings, arrays objects?
 };
@@ -32,30 +35,13 @@ static constexpr FrequentValues g_frequent_values
 	{ 0 },
 };
 
-static constexpr size_t g_null_value_offset=
+static const size_t g_null_value_offset=
 	reinterpret_cast<const char*>( &g_frequent_values.null_value ) - reinterpret_cast<const char*>( &g_frequent_values );
-static constexpr size_t g_true_value_offset=
+static const size_t g_true_value_offset=
 	reinterpret_cast<const char*>( &g_frequent_values.true_value ) - reinterpret_cast<const char*>( &g_frequent_values );
-static constexpr size_t g_false_value_offset=
+static const size_t g_false_value_offset=
 	reinterpret_cast<const char*>( &g_frequent_values.false_value ) - reinterpret_cast<const char*>( &g_frequent_values );
 
-// For big powers.
-// Method is faster for big powers - complexity is about O(log2(power)).
-static double TenPowerDouble( const unsigned int power ) noexcept
-{
-	if( power == 0u )
-		return 1.0;
-	if( power == 1u )
-		return 10.0;
-
-	const double half_power= TenPowerDouble( power / 2u );
-	double result= half_power * half_power;
-	if( ( power & 1u ) != 0u )
-		result*= 10.0;
-
-	return result;
-}
-
 static constexpr size_t PtrAlignedSize( const size_t size ) noexcept
 {
 	return ( size + ( sizeof(void*) - 1u ) ) & ~( sizeof(void*) - 1u );
@@ -90,6 +76,16 @@ void Parser::PrepareFrequentValues()
 	std::memcpy( result_.storage.data(), &g_frequent_values, sizeof(FrequentValues) );
 }
 
+const ValueBase* Parser::GetNullValue() noexcept
+{
+	return reinterpret_cast<const NullValue*>( static_cast<const char*>(nullptr) + g_null_value_offset );
+}
+
+const ValueBase* Parser::GetBoolValue( const bool value ) noexcept
+{
+	return reinterpret_cast<const BoolValue*>( static_cast<const char*>(nullptr) + ( value ? g_true_value_offset : g_false_value_offset ) );
+}
+
 const ValueBase* Parser::Parse_r()
 {
 	SkipWhitespaces();
@@ -126,9 +122,11 @@ const ValueBase* Parser::Parse_r()
 					result_.error= Result::Error::UnexpectedLexem;
 					return nullptr;
 				}
-				const StringType key= ParseString();
+				StringType key= ParseString();
 				if( result_.error != Result::Error::NoError )
 					return nullptr;
+				if( intern_keys_ )
+					key= InternKey( key );
 
 				SkipWhitespaces();
 				if( result_.error != Result::Error::NoError )
@@ -173,26 +171,7 @@ const ValueBase* Parser::Parse_r()
 			}
 		}
 
-		const size_t entries_count= object_entries_stack_.size() - object_entries_stack_pos;
-		const size_t offset= result_.storage.size();
-		ASSERT_PTR_ALIGNED( offset );
-		result_.storage.resize(
-			result_.storage.size() +
-			sizeof(ObjectValue) +
-			sizeof(ObjectValue::ObjectEntry) * entries_count );
-
-		ObjectValue* const object_value= reinterpret_cast<ObjectValue*>( result_.storage.data() + offset );
-		object_value->type= ValueBase::Type::Object;
-		object_value->object_count= static_cast<uint32_t>(entries_count);
-
-		std::memcpy(
-			result_.storage.data() + offset + sizeof(ObjectValue),
-			object_entries_stack_.data() + object_entries_stack_pos,
-			sizeof(ObjectValue::ObjectEntry) * entries_count );
-
-		object_entries_stack_.resize(object_entries_stack_pos);
-
-		return reinterpret_cast<ObjectValue*>( static_cast<char*>(nullptr) + offset );
+		return CreateObject( object_entries_stack_pos );
 	}
 	break;
 
@@ -246,26 +225,7 @@ const ValueBase* Parser::Parse_r()
 			} // while true
 		}
 
-		const size_t element_count= array_elements_stack_.size() - array_elements_stack_pos;
-		const size_t offset= result_.storage.size();
-		ASSERT_PTR_ALIGNED( offset );
-		result_.storage.resize(
-			result_.storage.size() +
-			sizeof(ArrayValue) +
-			sizeof(const ValueBase*) * element_count );
-
-		ArrayValue* const array_value= reinterpret_cast<ArrayValue*>( result_.storage.data() + offset );
-		array_value->type= ValueBase::Type::Array;
-		array_value->object_count= static_cast<uint32_t>(element_count);
-
-		std::memcpy(
-			result_.storage.data() + offset + sizeof(ArrayValue),
-			array_elements_stack_.data() + array_elements_stack_pos,
-			sizeof(const ValueBase*) * element_count );
-
-		array_elements_stack_.resize(array_elements_stack_pos);
-
-		return reinterpret_cast<ArrayValue*>( static_cast<char*>(nullptr) + offset );
+		return CreateArray( array_elements_stack_pos );
 	}
 	break;
 
@@ -277,13 +237,20 @@ const ValueBase* Parser::Parse_r()
 			const size_t offset= result_.storage.size();
 			result_.storage.resize( result_.storage.size() + sizeof(StringValue) );
 
-			ParseString();
+			bool has_escapes= false;
+			size_t length= 0u;
+			ParseString( lazy_strings_unescaping_, &has_escapes, &length );
 			if( result_.error != Result::Error::NoError )
 				return nullptr;
 
 			StringValue* const string_value=
 				reinterpret_cast<StringValue*>( result_.storage.data() + offset );
 			string_value->type= ValueBase::Type::String;
+			string_value->state.store(
+				has_escapes && lazy_strings_unescaping_ ? StringValue::State::Escaped : StringValue::State::Plain,
+				std::memory_order_relaxed );
+			// For escaped strings length will be rewritten on unescaping.
+			string_value->length= length < StringValue::c_unknown_length ? uint32_t(length) : StringValue::c_unknown_length;
 
 			return reinterpret_cast<StringValue*>( static_cast<char*>(nullptr) + offset );
 
@@ -294,23 +261,12 @@ const ValueBase* Parser::Parse_r()
 		// Numbers.
 		if( ( *cur_ >= '0' && *cur_ <= '9' ) || *cur_ == '-' )
 		{
-			bool is_negative= false;
-
-			constexpr uint64_t c_max_uint64= std::numeric_limits<uint64_t>::max();
-			constexpr uint64_t c_max_abs_int64= c_max_uint64 / 2u + 1u;
-			constexpr unsigned int c_max_exponent= 65536u; // Max reasonable exponent.
-
-			number_digits_.clear();
-			number_digits_.reserve(64u);
-
-			const auto extract_digits=
+			// Validate number and find its end. Conversion is performed later, for whole number string.
+			const auto skip_digits=
 			[&]()
 			{
 				while( cur_ < end_ && *cur_ >= '0' && *cur_ <= '9' )
-				{
-					number_digits_.push_back( static_cast<unsigned char>( *cur_ - '0' ) );
 					++cur_;
-				}
 			};
 
 			const char* const num_start= cur_;
@@ -327,8 +283,6 @@ const ValueBase* Parser::Parse_r()
 					result_.error= Result::Error::UnexpectedLexem;
 					return nullptr;
 				}
-
-				is_negative= true;
 			}
 
 			// Integer part.
@@ -338,8 +292,7 @@ const ValueBase* Parser::Parse_r()
 				++cur_;
 			}
 			else
-				extract_digits();
-			int decimal_point_pos= static_cast<int>(number_digits_.size());
+				skip_digits();
 
 			if( cur_ == end_ )
 				goto num_parse_end;
@@ -357,14 +310,12 @@ const ValueBase* Parser::Parse_r()
 					return nullptr;
 				}
 
-				extract_digits();
+				skip_digits();
 			}
 			if( cur_ == end_ )
 				goto num_parse_end;
 			if( *cur_ == 'e' || *cur_ == 'E' )
 			{
-				bool exponent_is_negative= false;
-
 				++cur_;
 				if( cur_ == end_ )
 				{
@@ -373,10 +324,7 @@ const ValueBase* Parser::Parse_r()
 				}
 
 				if( *cur_ == '+' || *cur_ == '-' )
-				{
-					if( *cur_ == '-' ) exponent_is_negative= true;
 					++cur_;
-				}
 
 				if( cur_ == end_ )
 				{
@@ -389,114 +337,21 @@ const ValueBase* Parser::Parse_r()
 					return nullptr;
 				}
 
-				unsigned int exponent= 0u;
-				while( cur_ < end_ && *cur_ >= '0' && *cur_ <= '9' )
-				{
-					const unsigned int mul10= exponent * 10u;
-					if( mul10 / 10u != exponent || mul10 < exponent ) // Detect overflow.
-					{
-						exponent= c_max_exponent;
-						break;
-					}
-
-					const unsigned int add_digit= mul10 + static_cast<unsigned int>( *cur_ - '0' );
-					if( add_digit < mul10 ) // Detect overflow.
-					{
-						exponent= c_max_exponent;
-						break;
-					}
-
-					exponent= add_digit;
-					++cur_;
-				}
-
-				const int final_expoent= static_cast<int>( std::min( exponent, c_max_exponent ) );
-				if( exponent_is_negative )
-					decimal_point_pos-= final_expoent;
-				else
-					decimal_point_pos+= final_expoent;
+				skip_digits();
 			}
 
 			num_parse_end:
 
-			int64_t result_int_val;
-			double result_double_val;
-			{
-				uint64_t result_val= 0u;
-				for( int i= 0; i < std::min( decimal_point_pos, static_cast<int>(number_digits_.size()) ); i++ )
-				{
-					const uint64_t mul10= result_val * 10u;
-					if( mul10 / 10u != result_val || mul10 < result_val ) // Detect overflow.
-					{
-						result_val= c_max_uint64;
-						break;
-					}
-
-					const uint64_t digit= int64_t(number_digits_[i]);
-					const uint64_t add_digit= mul10 + digit;
-					if( add_digit < mul10 ) // Detect overflow.
-					{
-						result_val= c_max_uint64;
-						break;
-					}
-
-					result_val= add_digit;
-				}
-				for( int i= static_cast<int>(number_digits_.size()); i < decimal_point_pos; i++ )
-				{
-					const uint64_t mul10= result_val * 10u;
-					if( mul10 / 10u != result_val || mul10 < result_val ) // Detect overflow.
-					{
-						result_val= c_max_uint64;
-						break;
-					}
-					result_val= mul10;
-				}
-
-				if( is_negative )
-					result_int_val= -static_cast<int64_t>( std::min( result_val, c_max_abs_int64 ) );
-				else
-					result_int_val= +static_cast<int64_t>( result_val );
-			}
+			if( lazy_numbers_ )
 			{
-				result_double_val= 0u;
-				for( const unsigned char digit : number_digits_ )
-					result_double_val= result_double_val * 10.0 + double(digit);
-
-				const int exponent= decimal_point_pos - static_cast<int>(number_digits_.size());
-				if( exponent >= 0 )
-					result_double_val*= TenPowerDouble(static_cast<unsigned int>(+exponent));
-				else
-					result_double_val/= TenPowerDouble(static_cast<unsigned int>(-exponent));
-
-				if( is_negative )
-					result_double_val*= -1.0;
+				// Store only string, convert it on access.
+				return CreateNumber( NumberValue::Kind::Lazy, NumberValue::Payload( uint64_t(0u) ), num_start, static_cast<size_t>( cur_ - num_start ) );
 			}
 
-			// Allocate number value.
-			// All storage is pointer-aligned, but numbers requires double-alignment, which can be bigger, than pointer alignment.
-			result_.storage.resize( NumberAlignedSize( result_.storage.size() ) );
-			const size_t offset= result_.storage.size();
-			ASSERT_NUMBER_ALIGNED( offset );
-			result_.storage.resize( result_.storage.size() + sizeof(NumberValue) );
-			NumberValue* const value= reinterpret_cast<NumberValue*>( result_.storage.data() + offset );
-
-			// Fill data.
-			value->type= ValueBase::Type::Number;
-			value->int_value= result_int_val;
-			value->double_value= result_double_val;
-
-			// Allocate string value.
-			if( save_number_strings_ )
-			{
-				const size_t str_size= cur_ - num_start;
-				const size_t str_offset= result_.storage.size();
-				result_.storage.resize( result_.storage.size() + PtrAlignedSize( str_size + 1u ) );
-				std::memcpy( result_.storage.data() + str_offset, num_start, str_size );
-				result_.storage[ str_offset + str_size ]= '\0';
-			}
-
-			return reinterpret_cast<NumberValue*>( static_cast<char*>(nullptr) + offset );
+			NumberValue::Kind kind;
+			NumberValue::Payload payload( uint64_t(0u) );
+			ParseNumber( num_start, cur_, kind, payload );
+			return CreateNumber( kind, payload, num_start, static_cast<size_t>( cur_ - num_start ) );
 		}
 		// Null
 		else if( *cur_ == 'n' )
@@ -513,7 +368,7 @@ const ValueBase* Parser::Parse_r()
 			}
 			cur_+= 4;
 
-			return reinterpret_cast<NullValue*>( static_cast<char*>(nullptr) + g_null_value_offset );
+			return GetNullValue();
 		}
 		else if( *cur_ == 't' || *cur_ == 'f' )
 		{
@@ -549,10 +404,7 @@ const ValueBase* Parser::Parse_r()
 				bool_value= false;
 			}
 
-			return
-				reinterpret_cast<BoolValue*>(
-					static_cast<char*>(nullptr) +
-					bool_value ? g_true_value_offset : g_false_value_offset );
+			return GetBoolValue( bool_value );
 		}
 		else
 		{
@@ -565,7 +417,146 @@ const ValueBase* Parser::Parse_r()
 	return nullptr;
 }
 
-StringType Parser::ParseString()
+const ValueBase* Parser::CreateObject( const size_t object_entries_stack_pos )
+{
+	const size_t entries_count= object_entries_stack_.size() - object_entries_stack_pos;
+	ObjectValue::ObjectEntry* const entries= object_entries_stack_.data() + object_entries_stack_pos;
+
+	// Sort keys here, because shapes must be compared with sorted keys.
+	std::sort(
+		entries,
+		entries + entries_count,
+		[this]( const ObjectValue::ObjectEntry& l, const ObjectValue::ObjectEntry& r ) -> bool
+		{
+			return l.key != r.key && StringCompare( GetStorageString( l.key ), GetStorageString( r.key ) ) < 0;
+		} );
+
+	// Shape allocation may change storage size, so, do it before object allocation.
+	const size_t shape_offset=
+		( share_object_shapes_ && intern_keys_ && entries_count > 0u )
+			? GetObjectShape( entries, entries_count )
+			: 0u;
+
+	const size_t offset= result_.storage.size();
+	ASSERT_PTR_ALIGNED( offset );
+	if( shape_offset != 0u )
+	{
+		result_.storage.resize(
+			result_.storage.size() +
+			sizeof(ObjectValue) +
+			sizeof(const ObjectShape*) +
+			sizeof(const ValueBase*) * entries_count );
+
+		ObjectValue* const object_value= reinterpret_cast<ObjectValue*>( result_.storage.data() + offset );
+		object_value->type= ValueBase::Type::Object;
+		object_value->layout= ObjectValue::Layout::Shaped;
+		object_value->object_count= static_cast<uint32_t>(entries_count);
+
+		const ObjectShape** const shape= reinterpret_cast<const ObjectShape**>( result_.storage.data() + offset + sizeof(ObjectValue) );
+		*shape= reinterpret_cast<const ObjectShape*>( static_cast<char*>(nullptr) + shape_offset );
+
+		const ValueBase** const values= reinterpret_cast<const ValueBase**>( shape + 1u );
+		for( size_t i= 0u; i < entries_count; i++ )
+			values[i]= entries[i].value;
+	}
+	else
+	{
+		result_.storage.resize(
+			result_.storage.size() +
+			sizeof(ObjectValue) +
+			sizeof(ObjectValue::ObjectEntry) * entries_count );
+
+		ObjectValue* const object_value= reinterpret_cast<ObjectValue*>( result_.storage.data() + offset );
+		object_value->type= ValueBase::Type::Object;
+		object_value->layout= ObjectValue::Layout::Entries;
+		object_value->object_count= static_cast<uint32_t>(entries_count);
+
+		std::memcpy(
+			result_.storage.data() + offset + sizeof(ObjectValue),
+			entries,
+			sizeof(ObjectValue::ObjectEntry) * entries_count );
+	}
+
+	object_entries_stack_.resize(object_entries_stack_pos);
+
+	return reinterpret_cast<ObjectValue*>( static_cast<char*>(nullptr) + offset );
+}
+
+const ValueBase* Parser::CreateArray( const size_t array_elements_stack_pos )
+{
+	const size_t element_count= array_elements_stack_.size() - array_elements_stack_pos;
+
+	if( pack_number_arrays_ && !save_number_strings_ && !lazy_numbers_ && element_count > 0u )
+	{
+		const size_t packed_array_offset= TryPackNumberArray( array_elements_stack_pos );
+		if( packed_array_offset != 0u )
+		{
+			array_elements_stack_.resize(array_elements_stack_pos);
+			return reinterpret_cast<ArrayValue*>( static_cast<char*>(nullptr) + packed_array_offset );
+		}
+	}
+
+	const size_t offset= result_.storage.size();
+	ASSERT_PTR_ALIGNED( offset );
+	result_.storage.resize(
+		result_.storage.size() +
+		sizeof(ArrayValue) +
+		sizeof(const ValueBase*) * element_count );
+
+	ArrayValue* const array_value= reinterpret_cast<ArrayValue*>( result_.storage.data() + offset );
+	array_value->type= ValueBase::Type::Array;
+	array_value->layout= ArrayValue::Layout::Elements;
+	array_value->object_count= static_cast<uint32_t>(element_count);
+
+	std::memcpy(
+		result_.storage.data() + offset + sizeof(ArrayValue),
+		array_elements_stack_.data() + array_elements_stack_pos,
+		sizeof(const ValueBase*) * element_count );
+
+	array_elements_stack_.resize(array_elements_stack_pos);
+
+	return reinterpret_cast<ArrayValue*>( static_cast<char*>(nullptr) + offset );
+}
+
+const ValueBase* Parser::CreateNumber( const NumberValue::Kind kind, const NumberValue::Payload payload, const char* const str, const size_t str_size )
+{
+	// String is saved for lazy numbers or if saving of number strings is enabled. Numbers from binary formats have no strings.
+	const bool has_string= str != nullptr && ( save_number_strings_ || kind == NumberValue::Kind::Lazy );
+
+	// Store small integers directly in pointer, without number value.
+	if( kind == NumberValue::Kind::Int64 && !has_string &&
+		payload.int_value >= c_min_inline_number && payload.int_value <= c_max_inline_number )
+		return MakeInlineNumber( payload.int_value );
+
+	// Allocate number value.
+	// All storage is pointer-aligned, but numbers requires double-alignment, which can be bigger, than pointer alignment.
+	result_.storage.resize( NumberAlignedSize( result_.storage.size() ) );
+	const size_t offset= result_.storage.size();
+	ASSERT_NUMBER_ALIGNED( offset );
+	result_.storage.resize( result_.storage.size() + sizeof(NumberValue) );
+	NumberValue* const value= reinterpret_cast<NumberValue*>( result_.storage.data() + offset );
+
+	// Fill data.
+	value->type= ValueBase::Type::Number;
+	value->has_string= has_string;
+	value->kind= kind;
+	value->lazy_state.store( NumberValue::LazyState::NotConverted, std::memory_order_relaxed );
+	value->converted_kind= kind;
+	value->payload= payload;
+
+	// Allocate string value.
+	if( has_string )
+	{
+		const size_t str_offset= result_.storage.size();
+		result_.storage.resize( result_.storage.size() + PtrAlignedSize( str_size + 1u ) );
+		std::memcpy( result_.storage.data() + str_offset, str, str_size );
+		result_.storage[ str_offset + str_size ]= '\0';
+	}
+
+	return reinterpret_cast<NumberValue*>( static_cast<char*>(nullptr) + offset );
+}
+
+StringType Parser::ParseString( const bool keep_escapes, bool* const out_has_escapes, size_t* const out_length )
 {
 	if( *cur_ != '"' )
 	{
@@ -575,6 +566,7 @@ StringType Parser::ParseString()
 	++cur_;
 
 	const size_t offset= result_.storage.size();
+	bool has_escapes= false;
 
 	while(true)
 	{
@@ -587,7 +579,17 @@ StringType Parser::ParseString()
 		if( *cur_ == '"' )
 		{
 			++cur_;
+			if( out_length != nullptr )
+				*out_length= result_.storage.size() - offset;
 			result_.storage.push_back('\0');
+			if( has_escapes && keep_escapes )
+			{
+				// Reserve space for unescaped string. Unescaped string is never longer, than escaped.
+				result_.storage.resize( result_.storage.size() + ( result_.storage.size() - offset ) );
+			}
+			if( out_has_escapes != nullptr )
+				*out_has_escapes= has_escapes;
+
 			 // Reconstruct alignment.
 			// Stringrs are only objects in storage, which is not pointer-aligned.
 			result_.storage.resize( PtrAlignedSize( result_.storage.size() ) );
@@ -595,100 +597,28 @@ StringType Parser::ParseString()
 		}
 		else if( *cur_ == '\\' )
 		{
+			const char* const sequence_start= cur_;
 			++cur_;
-			if( cur_ == end_ )
-			{
-				result_.error= Result::Error::UnexpectedEndOfFile;
-				return nullptr;
-			}
 
-			switch(*cur_)
+			char symbol[4];
+			size_t symbol_size= 0u;
+			switch( ParseEscapeSequence( cur_, end_, symbol, symbol_size ) )
 			{
-			case '"':
-			case '\\':
-			case '/':
-				result_.storage.push_back(*cur_);
-				++cur_;
-				break;
-
-			case 'b':
-				result_.storage.push_back('\b');
-				++cur_;
-				break;
-			case 'f':
-				result_.storage.push_back('\f');
-				++cur_;
-				break;
-			case 'n':
-				result_.storage.push_back('\n');
-				++cur_;
-				break;
-			case 'r':
-				result_.storage.push_back('\r');
-				++cur_;
-				break;
-			case 't':
-				result_.storage.push_back('\t');
-				++cur_;
-				break;
-
-			case 'u':
-				{
-					if( end_ - cur_ < 5 )
-					{
-						result_.error= Result::Error::UnexpectedEndOfFile;
-						return nullptr;
-					}
-					++cur_;
-
-					// Parse hex number.
-					size_t char_code= 0u;
-					for( size_t i= 0u; i < 4u; i++ )
-					{
-						size_t digit;
-						if( cur_[i] >= '0' && cur_[i] <= '9' )
-							digit= size_t( cur_[i] - '0' );
-						else if( cur_[i] >= 'a' && cur_[i] <= 'f' )
-							digit= size_t( cur_[i] - 'a' + 10 );
-						else if( cur_[i] >= 'A' && cur_[i] <= 'F' )
-							digit= size_t( cur_[i] - 'A' + 10 );
-						else
-						{
-							result_.error= Result::Error::UnexpectedLexem;
-							return nullptr;
-						}
-						char_code|= digit << ( ( 3u - i ) * 4u );
-					}
-
-					// Convert to UTF-8.
-					// Change this, if string format changed.
-					if( char_code <= 0x7Fu )
-						result_.storage.push_back( static_cast<unsigned char>( char_code ) );
-					else if( char_code <= 0x7FFu )
-					{
-						const size_t b0= 0xC0u | ( char_code >> 6u );
-						const size_t b1= 0x80u | ( char_code & 0x3Fu );
-						result_.storage.push_back( static_cast<unsigned char>(b0) );
-						result_.storage.push_back( static_cast<unsigned char>(b1) );
-					}
-					else// if( char_code <= 0xFFFFu )
-					{
-						const size_t b0= 0xE0u | (         ( char_code >> 12u ) );
-						const size_t b1= 0x80u | ( 0x3Fu & ( char_code >>  6u ) );
-						const size_t b2= 0x80u | ( 0x3Fu & ( char_code >>  0u ) );
-						result_.storage.push_back( static_cast<unsigned char>(b0) );
-						result_.storage.push_back( static_cast<unsigned char>(b1) );
-						result_.storage.push_back( static_cast<unsigned char>(b2) );
-					}
-
-					cur_+= 4u;
-				}
+			case EscapeSequenceParseResult::Ok:
 				break;
-
-			default:
+			case EscapeSequenceParseResult::UnexpectedEndOfFile:
+				result_.error= Result::Error::UnexpectedEndOfFile;
+				return nullptr;
+			case EscapeSequenceParseResult::UnexpectedLexem:
 				result_.error= Result::Error::UnexpectedLexem;
 				return nullptr;
 			};
+
+			has_escapes= true;
+			if( keep_escapes )
+				result_.storage.insert( result_.storage.end(), sequence_start, cur_ );
+			else
+				result_.storage.insert( result_.storage.end(), symbol, symbol + symbol_size );
 		}
 		else
 		{
@@ -706,6 +636,132 @@ StringType Parser::ParseString()
 	}
 }
 
+StringType Parser::InternKey( const StringType key )
+{
+	// Key is last string in storage.
+	const size_t offset= static_cast<size_t>( key - static_cast<StringType>(nullptr) );
+	const char* const str= reinterpret_cast<const char*>( result_.storage.data() + offset );
+	const size_t length= std::strlen( str );
+	const size_t hash= StringHash( str, length );
+
+	// Keep load factor less, than 0.5.
+	if( ( interned_keys_count_ + 1u ) * 2u > interned_keys_.size() )
+	{
+		std::vector<InternedKey> new_interned_keys( std::max( interned_keys_.size() * 2u, size_t(64u) ), InternedKey{ 0u, 0u, 0u } );
+		const size_t mask= new_interned_keys.size() - 1u;
+		for( const InternedKey& interned_key : interned_keys_ )
+		{
+			if( interned_key.offset == 0u )
+				continue;
+			size_t i= interned_key.hash & mask;
+			while( new_interned_keys[i].offset != 0u )
+				i= ( i + 1u ) & mask;
+			new_interned_keys[i]= interned_key;
+		}
+		interned_keys_.swap( new_interned_keys );
+	}
+
+	const size_t mask= interned_keys_.size() - 1u;
+	size_t i= hash & mask;
+	while( interned_keys_[i].offset != 0u )
+	{
+		const InternedKey& interned_key= interned_keys_[i];
+		if( interned_key.hash == hash && interned_key.length == length &&
+			std::memcmp( result_.storage.data() + interned_key.offset, str, length ) == 0 )
+		{
+			// Key already exists - free storage of new key.
+			result_.storage.resize( offset );
+			return static_cast<StringType>(nullptr) + interned_key.offset;
+		}
+		i= ( i + 1u ) & mask;
+	}
+
+	interned_keys_[i]= InternedKey{ offset, length, hash };
+	++interned_keys_count_;
+	return key;
+}
+
+size_t Parser::GetObjectShape( const ObjectValue::ObjectEntry* const entries, const size_t entries_count )
+{
+	// Keys are interned, so, compare and hash only keys pointers.
+	size_t hash= entries_count;
+	for( size_t i= 0u; i < entries_count; i++ )
+		hash= hash * 31u + static_cast<size_t>( entries[i].key - static_cast<StringType>(nullptr) );
+
+	// Keep load factor less, than 0.5.
+	if( ( object_shapes_count_ + 1u ) * 2u > object_shapes_.size() )
+	{
+		std::vector<ObjectShapeInfo> new_object_shapes( std::max( object_shapes_.size() * 2u, size_t(64u) ), ObjectShapeInfo{ 0u, 0u, 0u, 0u } );
+		const size_t mask= new_object_shapes.size() - 1u;
+		for( const ObjectShapeInfo& shape_info : object_shapes_ )
+		{
+			if( shape_info.key_count == 0u )
+				continue;
+			size_t i= shape_info.hash & mask;
+			while( new_object_shapes[i].key_count != 0u )
+				i= ( i + 1u ) & mask;
+			new_object_shapes[i]= shape_info;
+		}
+		object_shapes_.swap( new_object_shapes );
+	}
+
+	const size_t mask= object_shapes_.size() - 1u;
+	size_t i= hash & mask;
+	while( object_shapes_[i].key_count != 0u )
+	{
+		ObjectShapeInfo& shape_info= object_shapes_[i];
+		if( shape_info.hash == hash && shape_info.key_count == entries_count )
+		{
+			const ObjectValue::ObjectEntry* const first_object_entries=
+				reinterpret_cast<const ObjectValue::ObjectEntry*>(
+					result_.storage.data() + shape_info.first_object_offset + sizeof(ObjectValue) );
+
+			bool keys_are_same= true;
+			for( size_t j= 0u; j < entries_count; j++ )
+			{
+				if( first_object_entries[j].key != entries[j].key )
+				{
+					keys_are_same= false;
+					break;
+				}
+			}
+
+			if( keys_are_same )
+			{
+				if( shape_info.shape_offset == 0u )
+				{
+					// Second object with such keys - create shape.
+					shape_info.shape_offset= result_.storage.size();
+					ASSERT_PTR_ALIGNED( shape_info.shape_offset );
+					result_.storage.resize(
+						result_.storage.size() +
+						sizeof(ObjectShape) +
+						sizeof(StringType) * entries_count );
+
+					ObjectShape* const shape= reinterpret_cast<ObjectShape*>( result_.storage.data() + shape_info.shape_offset );
+					shape->key_count= entries_count;
+					StringType* const keys= reinterpret_cast<StringType*>( shape + 1u );
+					for( size_t j= 0u; j < entries_count; j++ )
+						keys[j]= entries[j].key;
+				}
+				return shape_info.shape_offset;
+			}
+		}
+		i= ( i + 1u ) & mask;
+	}
+
+	// First object with such keys. Do not create shape for it, because many objects have unique keys.
+	// Object itself will be placed at end of storage.
+	object_shapes_[i]= ObjectShapeInfo{ hash, entries_count, result_.storage.size(), 0u };
+	++object_shapes_count_;
+	return 0u;
+}
+
+const char* Parser::GetStorageString( const StringType str ) const
+{
+	return reinterpret_cast<const char*>( result_.storage.data() ) + ( str - static_cast<StringType>(nullptr) );
+}
+
 void Parser::SkipWhitespaces()
 {
 	if( !enable_comments_ )
@@ -800,45 +856,142 @@ void Parser::CorrectPointers_r( ValueBase& value )
 		{
 			ObjectValue& object_value= static_cast<ObjectValue&>(value);
 
-			for( size_t i= 0u; i < object_value.object_count; i++ )
+			if( object_value.layout == ObjectValue::Layout::Shaped )
 			{
-				ObjectValue::ObjectEntry& entry= const_cast<ObjectValue::ObjectEntry&>(object_value.GetEntries()[i]);
-				entry.key= CorrectStringPointer( entry.key );
-
-				const size_t offset=
-					reinterpret_cast<const unsigned char*>(entry.value) - static_cast<const unsigned char*>(nullptr);
-				entry.value= reinterpret_cast<const ValueBase*>( offset + result_.storage.data() );
+				// Shapes are corrected separately, because they are shared between objects.
+				const ObjectShape*& shape= *const_cast<const ObjectShape**>( reinterpret_cast<const ObjectShape* const*>( &object_value + 1u ) );
+				shape= reinterpret_cast<const ObjectShape*>( CorrectPointer( shape ) );
 
-				CorrectPointers_r( const_cast<ValueBase&>(*entry.value) );
+				for( size_t i= 0u; i < object_value.object_count; i++ )
+					CorrectValuePointer_r( const_cast<const ValueBase*&>(object_value.GetShapedValues()[i]) );
 			}
-
-			std::sort(
-				const_cast<ObjectValue::ObjectEntry*>(object_value.GetEntries()),
-				const_cast<ObjectValue::ObjectEntry*>(object_value.GetEntries()) + object_value.object_count,
-				[](const ObjectValue::ObjectEntry& l, const ObjectValue::ObjectEntry& r ) -> bool
+			else
+			{
+				for( size_t i= 0u; i < object_value.object_count; i++ )
 				{
-					return StringCompare( l.key, r.key ) < 0;
-				} );
+					ObjectValue::ObjectEntry& entry= const_cast<ObjectValue::ObjectEntry&>(object_value.GetEntries()[i]);
+					entry.key= CorrectStringPointer( entry.key );
+					CorrectValuePointer_r( entry.value );
+				}
+			}
 		}
 		return;
 
 	case ValueBase::Type::Array:
 		{
 			ArrayValue& array_value= static_cast<ArrayValue&>(value);
+			if( array_value.layout != ArrayValue::Layout::Elements )
+				break; // Packed arrays have no pointers.
 
 			for( size_t i= 0u; i < array_value.object_count; i++ )
-			{
-				const size_t offset=
-					reinterpret_cast<const unsigned char*>(array_value.GetElements()[i]) - static_cast<const unsigned char*>(nullptr);
-				const_cast<const ValueBase*&>(array_value.GetElements()[i])= reinterpret_cast<const ValueBase*>( offset + result_.storage.data() );
-
-				CorrectPointers_r( const_cast<ValueBase&>( *array_value.GetElements()[i]) );
-			}
+				CorrectValuePointer_r( const_cast<const ValueBase*&>(array_value.GetElements()[i]) );
 		}
 		break;
 	};
 }
 
+size_t Parser::TryPackNumberArray( const size_t array_elements_stack_pos )
+{
+	const size_t element_count= array_elements_stack_.size() - array_elements_stack_pos;
+	const ValueBase* const* const elements= array_elements_stack_.data() + array_elements_stack_pos;
+
+	// Packed array must restore both int and double values exactly and also keep kind of numbers,
+	// because serializer writes integers and doubles differently. So, only arrays of integers or only arrays of doubles are packed.
+	bool all_integers= true, all_doubles= true;
+	size_t first_number_value_offset= 0u;
+	for( size_t i= 0u; i < element_count; i++ )
+	{
+		if( IsInlineNumber( elements[i] ) )
+		{
+			all_doubles= false; // Small integer.
+			continue;
+		}
+
+		const size_t element_offset= reinterpret_cast<const unsigned char*>(elements[i]) - static_cast<const unsigned char*>(nullptr);
+		const ValueBase& element= *reinterpret_cast<const ValueBase*>( result_.storage.data() + element_offset );
+		if( element.type != ValueBase::Type::Number )
+			return 0u;
+
+		const NumberValue& number= static_cast<const NumberValue&>(element);
+		all_integers= all_integers && number.kind == NumberValue::Kind::Int64;
+		all_doubles= all_doubles && number.kind == NumberValue::Kind::Double;
+
+		if( first_number_value_offset == 0u )
+			first_number_value_offset= element_offset;
+	}
+
+	if( !( all_integers || all_doubles ) )
+		return 0u;
+
+	packed_numbers_.resize( element_count );
+	for( size_t i= 0u; i < element_count; i++ )
+	{
+		int64_t int_value;
+		double double_value;
+		if( IsInlineNumber( elements[i] ) )
+		{
+			int_value= GetInlineNumber( elements[i] );
+			double_value= static_cast<double>(int_value);
+		}
+		else
+		{
+			const size_t element_offset= reinterpret_cast<const unsigned char*>(elements[i]) - static_cast<const unsigned char*>(nullptr);
+			const NumberValue& number= *reinterpret_cast<const NumberValue*>( result_.storage.data() + element_offset );
+			int_value= number.GetInt64();
+			double_value= number.GetDouble();
+		}
+
+		if( all_integers )
+			std::memcpy( &packed_numbers_[i], &int_value, sizeof(int64_t) );
+		else
+			std::memcpy( &packed_numbers_[i], &double_value, sizeof(double) );
+	}
+
+	// All number values were allocated just before array, one after another. Reuse their storage for packed array.
+	const size_t offset=
+		first_number_value_offset != 0u
+			? first_number_value_offset
+			: NumberAlignedSize( result_.storage.size() );
+	ASSERT_NUMBER_ALIGNED( offset );
+	ASSERT_NUMBER_ALIGNED( offset + sizeof(ArrayValue) );
+
+	result_.storage.resize( offset + sizeof(ArrayValue) + sizeof(uint64_t) * element_count );
+
+	ArrayValue* const array_value= reinterpret_cast<ArrayValue*>( result_.storage.data() + offset );
+	array_value->type= ValueBase::Type::Array;
+	array_value->layout= all_integers ? ArrayValue::Layout::PackedInt64s : ArrayValue::Layout::PackedDoubles;
+	array_value->object_count= static_cast<uint32_t>(element_count);
+
+	std::memcpy( result_.storage.data() + offset + sizeof(ArrayValue), packed_numbers_.data(), sizeof(uint64_t) * element_count );
+
+	return offset;
+}
+
+void Parser::CorrectValuePointer_r( const ValueBase*& value )
+{
+	if( IsInlineNumber( value ) )
+		return; // Inline numbers are not pointers.
+
+	value= reinterpret_cast<const ValueBase*>( CorrectPointer( value ) );
+	CorrectPointers_r( const_cast<ValueBase&>(*value) );
+}
+
+void Parser::CorrectShapes()
+{
+	for( const ObjectShapeInfo& shape_info : object_shapes_ )
+	{
+		if( shape_info.shape_offset == 0u )
+			continue;
+
+		ObjectShape* const shape= reinterpret_cast<ObjectShape*>( result_.storage.data() + shape_info.shape_offset );
+		for( size_t i= 0u; i < shape->key_count; i++ )
+		{
+			StringType& key= const_cast<StringType&>( shape->GetKeys()[i] );
+			key= CorrectStringPointer( key );
+		}
+	}
+}
+
 StringType Parser::CorrectStringPointer( const StringType str )
 {
 	const size_t offset=
@@ -846,6 +999,13 @@ StringType Parser::CorrectStringPointer( const StringType str )
 	return reinterpret_cast<const char*>( offset + result_.storage.data() );
 }
 
+const void* Parser::CorrectPointer( const void* const ptr )
+{
+	const size_t offset=
+		reinterpret_cast<const unsigned char*>(ptr) - static_cast<const unsigned char*>(nullptr);
+	return offset + result_.storage.data();
+}
+
 Parser::ResultPtr Parser::Parse( const char* const json_text_null_teriminated )
 {
 	return
@@ -867,45 +1027,63 @@ Parser::ResultPtr Parser::Parse( const char* const json_text, const size_t json_
 	}
 	else
 	{
-		start_= json_text;
-		end_= json_text + json_text_length;
-		end_minus_one_= end_ - 1u;
-		cur_= start_;
-
-		result_.error= Result::Error::NoError;
-		result_.error_pos= 0u;
-
-		array_elements_stack_.clear();
-		object_entries_stack_.clear();
-
-		PrepareFrequentValues();
-		const ValueBase* root= Parse_r();
+		StartParsing( json_text, json_text_length );
+		const ValueBase* const root= Parse_r();
 
 		if( result_.error == Result::Error::NoError )
 		{
 			SkipWhitespacesAtEnd();
 			if( result_.error == Result::Error::NoError )
-			{
-				const size_t offset=
-					reinterpret_cast<const unsigned char*>(root) - static_cast<const unsigned char*>(nullptr);
-				root= reinterpret_cast<const ValueBase*>( offset + result_.storage.data() );
-				CorrectPointers_r( const_cast<ValueBase&>(*root) );
-
-				if( enable_noncomposite_json_root_ ||
-					root->type == ValueBase::Type::Array || root->type == ValueBase::Type::Object )
-				{
-					result_.root= Value( root );
-					all_ok= true;
-				}
-				else
-					result_.error= Result::Error::RootIsNotObjectOrArray;
-			}
+				all_ok= FinishParsing( root );
 		}
 	}
 
+	return MakeResult( all_ok );
+}
+
+void Parser::StartParsing( const char* const data, const size_t data_size )
+{
+	start_= data;
+	end_= data + data_size;
+	end_minus_one_= end_ - 1u;
+	cur_= start_;
+
+	result_.error= Result::Error::NoError;
+	result_.error_pos= 0u;
+
+	array_elements_stack_.clear();
+	object_entries_stack_.clear();
+	std::fill( interned_keys_.begin(), interned_keys_.end(), InternedKey{ 0u, 0u, 0u } );
+	interned_keys_count_= 0u;
+	std::fill( object_shapes_.begin(), object_shapes_.end(), ObjectShapeInfo{ 0u, 0u, 0u, 0u } );
+	object_shapes_count_= 0u;
+
+	PrepareFrequentValues();
+}
+
+bool Parser::FinishParsing( const ValueBase* root )
+{
+	CorrectValuePointer_r( root );
+	CorrectShapes();
+
+	const Value root_value( root );
+	if( enable_noncomposite_json_root_ || root_value.IsArray() || root_value.IsObject() )
+	{
+		result_.root= root_value;
+		return true;
+	}
+
+	result_.error= Result::Error::RootIsNotObjectOrArray;
+	return false;
+}
+
+Parser::ResultPtr Parser::MakeResult( const bool all_ok )
+{
 	if( !all_ok )
 	{
-		result_.error_pos= cur_ - start_;
+		// Position of empty input error is already set, parsing pointers are not valid for it.
+		if( result_.error != Result::Error::EmptyInput )
+			result_.error_pos= cur_ - start_;
 		result_.root= Value();
 	}
 
@@ -948,15 +1126,73 @@ bool Parser::GetSaveNumberStrings() const noexcept
 	return save_number_strings_;
 }
 
+void Parser::SetInternKeys( const bool intern ) noexcept
+{
+	intern_keys_= intern;
+}
+
+bool Parser::GetInternKeys() const noexcept
+{
+	return intern_keys_;
+}
+
+void Parser::SetShareObjectShapes( const bool share ) noexcept
+{
+	share_object_shapes_= share;
+}
+
+bool Parser::GetShareObjectShapes() const noexcept
+{
+	return share_object_shapes_;
+}
+
+void Parser::SetPackNumberArrays( const bool pack ) noexcept
+{
+	pack_number_arrays_= pack;
+}
+
+bool Parser::GetPackNumberArrays() const noexcept
+{
+	return pack_number_arrays_;
+}
+
+void Parser::SetLazyNumbers( const bool lazy ) noexcept
+{
+	lazy_numbers_= lazy;
+}
+
+bool Parser::GetLazyNumbers() const noexcept
+{
+	return lazy_numbers_;
+}
+
+void Parser::SetLazyStringsUnescaping( const bool lazy ) noexcept
+{
+	lazy_strings_unescaping_= lazy;
+}
+
+bool Parser::GetLazyStringsUnescaping() const noexcept
+{
+	return lazy_strings_unescaping_;
+}
+
 void Parser::ResetCaches()
 {
-	number_digits_.clear();
-	number_digits_.shrink_to_fit();
+	packed_numbers_.clear();
+	packed_numbers_.shrink_to_fit();
 
 	array_elements_stack_.clear();
 	array_elements_stack_.shrink_to_fit();
 	object_entries_stack_.clear();
 	object_entries_stack_.shrink_to_fit();
+
+	interned_keys_.clear();
+	interned_keys_.shrink_to_fit();
+	interned_keys_count_= 0u;
+
+	object_shapes_.clear();
+	object_shapes_.shrink_to_fit();
+	object_shapes_count_= 0u;
 }
 
 } // namespace PanzerJson
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstring>
+
+#include "../include/PanzerJson/resumable_serializer.hpp"
+#include "serializers_common.hpp"
+
+namespace PanzerJson
+{
+
+ResumableSerializer::ResumableSerializer( const Value value )
+	: next_value_(value)
+{}
+
+void ResumableSerializer::SetEscapeSlash( const bool escape_slash ) noexcept
+{
+	escape_slash_= escape_slash;
+}
+
+bool ResumableSerializer::IsFinished() const noexcept
+{
+	return pending_pos_ == pending_size_ && !in_string_ && !has_next_value_ && stack_.empty();
+}
+
+size_t ResumableSerializer::Write( char* const buffer, const size_t buffer_size )
+{
+	size_t written= 0u;
+	while( written < buffer_size )
+	{
+		if( pending_pos_ < pending_size_ )
+		{
+			const size_t size= std::min( pending_size_ - pending_pos_, buffer_size - written );
+			std::memcpy( buffer + written, pending_ + pending_pos_, size );
+			pending_pos_+= size;
+			written+= size;
+			continue;
+		}
+
+		if( in_string_ )
+		{
+			// Write symbols until symbol with escaping.
+			const char* const s= string_ + string_pos_;
+			const char* const s_end= string_ + string_size_;
+			// Already escaped strings need only escaping of slashes. Number strings have no slashes.
+			const char* const block_end=
+				string_escape_
+					? FindSymbolForEscaping( s, s_end, escape_slash_ )
+					: ( escape_slash_ ? FindUnescapedSlash( string_, s, s_end ) : s_end );
+			const size_t size= std::min( static_cast<size_t>( block_end - s ), buffer_size - written );
+			std::memcpy( buffer + written, s, size );
+			string_pos_+= size;
+			written+= size;
+
+			pending_pos_= pending_size_= 0u;
+			if( string_pos_ == string_size_ )
+			{
+				// String end.
+				if( string_escape_ )
+					pending_[ pending_size_++ ]= '"';
+				if( string_suffix_ != '\0' )
+					pending_[ pending_size_++ ]= string_suffix_;
+				in_string_= false;
+			}
+			else if( string_ + string_pos_ == block_end )
+			{
+				const unsigned char c= static_cast<unsigned char>( *block_end );
+				const char escape= g_string_escapes_table[c];
+				pending_[ pending_size_++ ]= '\\';
+				if( escape == 'u' )
+				{
+					const char* const hex_digits= "0123456789abcdef";
+					pending_[ pending_size_++ ]= 'u';
+					pending_[ pending_size_++ ]= '0';
+					pending_[ pending_size_++ ]= '0';
+					pending_[ pending_size_++ ]= hex_digits[ c >> 4 ];
+					pending_[ pending_size_++ ]= hex_digits[ c & 15 ];
+				}
+				else
+					pending_[ pending_size_++ ]= escape;
+				++string_pos_;
+			}
+			continue;
+		}
+
+		if( IsFinished() )
+			break;
+		Step();
+	}
+
+	return written;
+}
+
+void ResumableSerializer::Step()
+{
+	pending_pos_= pending_size_= 0u;
+
+	if( has_next_value_ )
+	{
+		has_next_value_= false;
+		StartValue( next_value_ );
+		return;
+	}
+
+	StackEntry& entry= stack_.back();
+	const bool is_object= entry.container.IsObject();
+	if( entry.index == entry.container.ElementCount() )
+	{
+		pending_[ pending_size_++ ]= is_object ? '}' : ']';
+		stack_.pop_back();
+		return;
+	}
+
+	if( entry.index != 0u )
+		pending_[ pending_size_++ ]= ',';
+
+	if( is_object )
+	{
+		const ObjectValue& object= static_cast<const ObjectValue&>( *entry.container.GetInternalValue() );
+		const StringType key= object.GetKey( entry.index );
+		pending_[ pending_size_++ ]= '"';
+		StartString( key, std::strlen( key ), true, ':' );
+		next_value_= Value( object.GetValue( entry.index ) );
+	}
+	else
+		next_value_= entry.container[ entry.index ];
+
+	has_next_value_= true;
+	++entry.index;
+}
+
+void ResumableSerializer::StartValue( const Value value )
+{
+	const ValueBase& internal_value= *value.GetInternalValue();
+	switch( internal_value.type )
+	{
+	case ValueBase::Type::Null:
+		std::memcpy( pending_, "null", 4u );
+		pending_size_= 4u;
+		break;
+
+	case ValueBase::Type::Object:
+	case ValueBase::Type::Array:
+		pending_[ pending_size_++ ]= internal_value.type == ValueBase::Type::Object ? '{' : '[';
+		stack_.push_back( StackEntry{ value, 0u } );
+		break;
+
+	case ValueBase::Type::String:
+		{
+			const StringValue& string_value= static_cast<const StringValue&>(internal_value);
+			pending_[ pending_size_++ ]= '"';
+			if( string_value.HasEscapes() )
+			{
+				// String is already escaped, write it as is. Only slashes may need escaping.
+				const char* const escaped_string= string_value.GetEscapedString();
+				StartString( escaped_string, std::strlen( escaped_string ), false, '"' );
+			}
+			else
+			{
+				const StringView str= string_value.GetStringView();
+				StartString( str.data, str.size, true, '\0' );
+			}
+		}
+		break;
+
+	case ValueBase::Type::Number:
+		if( static_cast<const NumberValue&>(internal_value).has_string )
+		{
+			const char* const number_string= static_cast<const NumberValue&>(internal_value).GetString();
+			StartString( number_string, std::strlen( number_string ), false, '\0' );
+		}
+		else
+			SetPendingNumber( value );
+		break;
+
+	case ValueBase::Type::Bool:
+		if( static_cast<const BoolValue&>(internal_value).value )
+		{
+			std::memcpy( pending_, "true", 4u );
+			pending_size_= 4u;
+		}
+		else
+		{
+			std::memcpy( pending_, "false", 5u );
+			pending_size_= 5u;
+		}
+		break;
+	};
+}
+
+void ResumableSerializer::StartString( const char* const data, const size_t size, const bool escape, const char suffix )
+{
+	string_= data;
+	string_size_= size;
+	string_pos_= 0u;
+	string_escape_= escape;
+	string_suffix_= suffix;
+	in_string_= true;
+}
+
+void ResumableSerializer::SetPendingNumber( const Value value )
+{
+	// Value may be inline number, without own number value, so, use only value methods.
+	NumberStringStorage num_str;
+	switch( static_cast<const NumberValue&>( *value.GetInternalValue() ).kind )
+	{
+	case NumberValue::Kind::Int64: pending_size_= GenIntValueString( value.AsInt64(), num_str ); break;
+	case NumberValue::Kind::Uint64: pending_size_= GenUintValueString( value.AsUint64(), num_str ); break;
+	case NumberValue::Kind::Double: pending_size_= GenDoubleValueString( value.AsDouble(), num_str ); break;
+	case NumberValue::Kind::Lazy:
+		{
+			const NumberValue converted= static_cast<const NumberValue&>( *value.GetInternalValue() ).GetConverted();
+			switch( converted.kind )
+			{
+			case NumberValue::Kind::Int64: pending_size_= GenIntValueString( converted.payload.int_value, num_str ); break;
+			case NumberValue::Kind::Uint64: pending_size_= GenUintValueString( converted.payload.uint_value, num_str ); break;
+			case NumberValue::Kind::Double: pending_size_= GenDoubleValueString( converted.payload.double_value, num_str ); break;
+			case NumberValue::Kind::Lazy: break; // Converted number is never lazy.
+			};
+		}
+		break;
+	};
+	std::memcpy( pending_, num_str.data(), pending_size_ );
+}
+
+} // namespace PanzerJson
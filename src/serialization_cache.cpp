@@ -0,0 +1,55 @@
+#include "../include/PanzerJson/serialization_cache.hpp"
+
+namespace PanzerJson
+{
+
+SerializationCache::SerializationCache( const size_t memory_budget )
+	: memory_budget_(memory_budget)
+{}
+
+StringView SerializationCache::Find( const ValueBase* const value, const bool escape_slash ) const
+{
+	const std::lock_guard<std::mutex> lock( mutex_ );
+
+	const MapType& cache= cache_[ escape_slash ? 1u : 0u ];
+	const auto it= cache.find( value );
+	if( it == cache.end() )
+		return StringView( nullptr, 0u );
+	return StringView( it->second.data(), it->second.size() );
+}
+
+StringView SerializationCache::Insert( const ValueBase* const value, const bool escape_slash, const char* const data, const size_t size )
+{
+	// Approximate size of map node.
+	const size_t entry_size= size + sizeof(MapType::value_type) + sizeof(void*) * 2u;
+
+	const std::lock_guard<std::mutex> lock( mutex_ );
+
+	MapType& cache= cache_[ escape_slash ? 1u : 0u ];
+	const auto it= cache.find( value );
+	if( it != cache.end() ) // Value may be inserted by other thread.
+		return StringView( it->second.data(), it->second.size() );
+
+	if( used_memory_ + entry_size > memory_budget_ )
+		return StringView( nullptr, 0u );
+
+	used_memory_+= entry_size;
+	// Nodes of unordered map are not moved on rehashing, so, data of strings is stable.
+	const std::string& str= cache.emplace( value, std::string( data, size ) ).first->second;
+	return StringView( str.data(), str.size() );
+}
+
+size_t SerializationCache::GetUsedMemory() const
+{
+	const std::lock_guard<std::mutex> lock( mutex_ );
+	return used_memory_;
+}
+
+void SerializationCache::Clear() noexcept
+{
+	cache_[0].clear();
+	cache_[1].clear();
+	used_memory_= 0u;
+}
+
+} // namespace PanzerJson
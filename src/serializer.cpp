@@ -1,51 +1,528 @@
-#include <cmath>
-#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
 
 #include "../include/PanzerJson/serializer.hpp"
 
 namespace PanzerJson
 {
 
-void Serializer::GenNumberValueString( const NumberValue& number_value )
+void Serializer::SetEscapeSlash( const bool escape_slash ) noexcept
 {
-	if( std::floor( number_value.double_value ) != number_value.double_value )
+	escape_slash_= escape_slash;
+}
+
+void Serializer::SetCache( SerializationCache* const cache ) noexcept
+{
+	cache_= cache;
+}
+
+namespace
+{
+
+// Writer, which only counts size of output.
+class SizeCounter final
+{
+public:
+	void Write( char ) noexcept
+	{
+		++size;
+	}
+
+	void Write( const char*, const size_t data_size ) noexcept
+	{
+		size+= data_size;
+	}
+
+public:
+	size_t size= 0u;
+};
+
+// Writer into buffer with enough size, without bounds checks.
+class UncheckedWriter final
+{
+public:
+	void Write( const char c ) noexcept
+	{
+		*cur= c;
+		++cur;
+	}
+
+	void Write( const char* const data, const size_t data_size ) noexcept
+	{
+		std::memcpy( cur, data, data_size );
+		cur+= data_size;
+	}
+
+public:
+	char* cur;
+};
+
+// Calls "func( thread_index )" in "thread_count" threads.
+template<class Func>
+void RunInThreads( const size_t thread_count, const Func& func )
+{
+	std::vector<std::thread> threads;
+	threads.reserve( thread_count - 1u );
+	for( size_t t= 1u; t < thread_count; t++ )
+		threads.emplace_back( func, t );
+	func( size_t(0u) );
+	for( std::thread& thread : threads )
+		thread.join();
+}
+
+// Containers with less elements are not split into chunks.
+const size_t g_min_elements_for_splitting= 64u;
+// Small containers are traversed in search of big containers only up to this depth.
+const size_t g_max_splitting_depth= 8u;
+
+} // namespace
+
+// Part of value, serialized by one thread.
+struct Serializer::Chunk final
+{
+	enum class Kind
+	{
+		Symbol, // Bracket or comma.
+		Value,
+		ObjectMembers, // Range of members. Comma is written before each member, except first member of object.
+		ArrayElements, // Range of elements. Comma is written before each element, except first element of array.
+		ObjectKey, // Comma, if member is not first, and key with colon.
+	};
+
+	Kind kind;
+	char symbol;
+	Value value; // Value, object or array.
+	size_t begin;
+	size_t end; // For ranges.
+
+	size_t size;
+	size_t offset;
+};
+
+void Serializer::Serialize( const Value value, OutputBuffer& out )
+{
+	SerializeValue( out, value );
+}
+
+void Serializer::Serialize( const Value value, ChunkedOutput& out )
+{
+	SerializeValue( out, value );
+}
+
+size_t Serializer::GetSerializedSize( const Value value )
+{
+	SizeCounter counter;
+	SerializeValue( counter, value );
+	return counter.size;
+}
+
+size_t Serializer::SerializeToBuffer( const Value value, char* const buffer )
+{
+	UncheckedWriter writer{ buffer };
+	SerializeValue( writer, value );
+	return static_cast<size_t>( writer.cur - buffer );
+}
+
+void Serializer::SerializeParallel( const Value value, OutputBuffer& out, const unsigned int thread_count )
+{
+	const size_t actual_thread_count= std::max( size_t(thread_count), size_t(1u) );
+	if( cache_ != nullptr )
 	{
-		// Has nonzero fractional part - write as double.
-		GenDoubleValueString( number_value.double_value, num_str_ );
+		Serialize( value, out );
 		return;
 	}
 
-	// Try reconstruct original number value.
-	// Double value allways saves sign of original value.
-	if( number_value.double_value >= 0.0 )
+	std::vector<Chunk> chunks;
+	if( actual_thread_count > 1u )
+		SplitIntoChunks( value, 0u, actual_thread_count, chunks );
+	if( chunks.size() <= 1u )
 	{
-		const uint64_t int_val= static_cast<uint64_t>( number_value.int_value );
-		if( number_value.double_value > static_cast<double>( std::numeric_limits<uint64_t>::max() ) )
+		Serialize( value, out );
+		return;
+	}
+
+	// Each thread uses own copy of serializer, because serializer has internal buffer.
+	std::atomic<size_t> next_chunk( 0u );
+	RunInThreads(
+		actual_thread_count,
+		[&]( size_t )
 		{
-			// Double value is bigger, than int range, write as double.
-			GenDoubleValueString( number_value.double_value, num_str_ );
-			return;
+			Serializer serializer= *this;
+			for( size_t i= next_chunk.fetch_add( 1u ); i < chunks.size(); i= next_chunk.fetch_add( 1u ) )
+			{
+				SizeCounter counter;
+				serializer.SerializeChunk( counter, chunks[i] );
+				chunks[i].size= counter.size;
+			}
+		} );
+
+	size_t total_size= 0u;
+	for( Chunk& chunk : chunks )
+	{
+		chunk.offset= total_size;
+		total_size+= chunk.size;
+	}
+
+	// Write directly into growable buffer. For fixed buffers use intermediate buffer.
+	std::unique_ptr<char[]> temp_buffer;
+	char* dst;
+	if( out.IsGrowable() )
+		dst= out.Reserve( total_size );
+	else
+	{
+		temp_buffer.reset( new char[ total_size ] );
+		dst= temp_buffer.get();
+	}
+
+	next_chunk= 0u;
+	RunInThreads(
+		actual_thread_count,
+		[&]( size_t )
+		{
+			Serializer serializer= *this;
+			for( size_t i= next_chunk.fetch_add( 1u ); i < chunks.size(); i= next_chunk.fetch_add( 1u ) )
+			{
+				UncheckedWriter writer{ dst + chunks[i].offset };
+				serializer.SerializeChunk( writer, chunks[i] );
+			}
+		} );
+
+	if( out.IsGrowable() )
+		out.Commit( total_size );
+	else
+		out.Write( dst, total_size );
+}
+
+void Serializer::SplitIntoChunks( const Value value, const size_t depth, const size_t thread_count, std::vector<Chunk>& chunks ) const
+{
+	const size_t element_count= value.ElementCount();
+	const bool is_object= value.IsObject();
+	if( !( is_object || value.IsArray() ) || element_count == 0u )
+	{
+		chunks.push_back( Chunk{ Chunk::Kind::Value, '\0', value, 0u, 0u, 0u, 0u } );
+		return;
+	}
+
+	if( element_count >= g_min_elements_for_splitting )
+	{
+		// Big container - split its members into ranges.
+		// Make more chunks, than threads, because chunks have different sizes.
+		const size_t chunk_elements= std::max( element_count / ( thread_count * 8u ), g_min_elements_for_splitting / 4u );
+		chunks.push_back( Chunk{ Chunk::Kind::Symbol, is_object ? '{' : '[', Value(), 0u, 0u, 0u, 0u } );
+		for( size_t begin= 0u; begin < element_count; begin+= chunk_elements )
+		{
+			const size_t end= std::min( begin + chunk_elements, element_count );
+			chunks.push_back( Chunk{ is_object ? Chunk::Kind::ObjectMembers : Chunk::Kind::ArrayElements, '\0', value, begin, end, 0u, 0u } );
+		}
+		chunks.push_back( Chunk{ Chunk::Kind::Symbol, is_object ? '}' : ']', Value(), 0u, 0u, 0u, 0u } );
+		return;
+	}
+
+	const ValueBase& internal_value= *value.GetInternalValue();
+	if( depth >= g_max_splitting_depth ||
+		( !is_object && static_cast<const ArrayValue&>(internal_value).layout != ArrayValue::Layout::Elements ) )
+	{
+		chunks.push_back( Chunk{ Chunk::Kind::Value, '\0', value, 0u, 0u, 0u, 0u } );
+		return;
+	}
+
+	// Small container - search big containers inside it.
+	chunks.push_back( Chunk{ Chunk::Kind::Symbol, is_object ? '{' : '[', Value(), 0u, 0u, 0u, 0u } );
+	for( size_t i= 0u; i < element_count; i++ )
+	{
+		if( is_object )
+		{
+			chunks.push_back( Chunk{ Chunk::Kind::ObjectKey, '\0', value, i, i + 1u, 0u, 0u } );
+			SplitIntoChunks( Value( static_cast<const ObjectValue&>(internal_value).GetValue(i) ), depth + 1u, thread_count, chunks );
 		}
 		else
 		{
-			GenUintValueString( int_val, num_str_ );
+			if( i != 0u )
+				chunks.push_back( Chunk{ Chunk::Kind::Symbol, ',', Value(), 0u, 0u, 0u, 0u } );
+			SplitIntoChunks( value[i], depth + 1u, thread_count, chunks );
+		}
+	}
+	chunks.push_back( Chunk{ Chunk::Kind::Symbol, is_object ? '}' : ']', Value(), 0u, 0u, 0u, 0u } );
+}
+
+template<class Writer>
+void Serializer::SerializeChunk( Writer& out, const Chunk& chunk )
+{
+	switch( chunk.kind )
+	{
+	case Chunk::Kind::Symbol:
+		out.Write( chunk.symbol );
+		break;
+	case Chunk::Kind::Value:
+		SerializeValue( out, chunk.value );
+		break;
+	case Chunk::Kind::ObjectMembers:
+		SerializeObjectMembers( out, static_cast<const ObjectValue&>( *chunk.value.GetInternalValue() ), chunk.begin, chunk.end );
+		break;
+	case Chunk::Kind::ArrayElements:
+		SerializeArrayElements( out, static_cast<const ArrayValue&>( *chunk.value.GetInternalValue() ), chunk.begin, chunk.end );
+		break;
+	case Chunk::Kind::ObjectKey:
+		if( chunk.begin != 0u )
+			out.Write( ',' );
+		WriteEscapedString( out, StringView( static_cast<const ObjectValue&>( *chunk.value.GetInternalValue() ).GetKey( chunk.begin ) ), escape_slash_ );
+		out.Write( ':' );
+		break;
+	};
+}
+
+template<class Writer>
+void Serializer::SerializeValue( Writer& out, const Value value )
+{
+	const ValueBase& internal_value= *value.GetInternalValue();
+	if( internal_value.type == ValueBase::Type::Number && !static_cast<const NumberValue&>(internal_value).has_string )
+	{
+		// Value may be inline number, without own number value, so, use only value methods.
+		size_t length= 0u;
+		switch( static_cast<const NumberValue&>(internal_value).kind )
+		{
+		case NumberValue::Kind::Int64: length= GenIntValueString( value.AsInt64(), num_str_ ); break;
+		case NumberValue::Kind::Uint64: length= GenUintValueString( value.AsUint64(), num_str_ ); break;
+		case NumberValue::Kind::Double: length= GenDoubleValueString( value.AsDouble(), num_str_ ); break;
+		case NumberValue::Kind::Lazy: length= GenNumberValueString( static_cast<const NumberValue&>(internal_value) ); break;
+		};
+		out.Write( num_str_.data(), length );
+		return;
+	}
+	if( cache_ != nullptr && ( internal_value.type == ValueBase::Type::Object || internal_value.type == ValueBase::Type::Array ) )
+	{
+		SerializeCached( out, internal_value );
+		return;
+	}
+	Serialize_r( out, internal_value );
+}
+
+template<class Writer>
+void Serializer::SerializeCached( Writer& out, const ValueBase& value )
+{
+	StringView cached= cache_->Find( &value, escape_slash_ );
+	if( cached.data == nullptr )
+	{
+		OutputBuffer buffer;
+		Serialize_r( buffer, value );
+		cached= cache_->Insert( &value, escape_slash_, buffer.GetData(), buffer.GetSize() );
+		if( cached.data == nullptr )
+		{
+			// Memory budget of cache is exhausted.
+			out.Write( buffer.GetData(), buffer.GetSize() );
 			return;
 		}
 	}
+	// Cached data lives in cache and is never evicted, so, chunked output may reference it, while cache is alive.
+	WriteDocumentString( out, cached.data, cached.size );
+}
+
+template<class Writer>
+void Serializer::Serialize_r( Writer& out, const ValueBase& value )
+{
+	switch(value.type)
+	{
+	case ValueBase::Type::Null:
+		out.Write( "null", 4u );
+		break;
+
+	case ValueBase::Type::Object:
+		{
+			const ObjectValue& object= static_cast<const ObjectValue&>(value);
+			out.Write( '{' );
+			SerializeObjectMembers( out, object, 0u, object.object_count );
+			out.Write( '}' );
+		}
+		break;
+
+	case ValueBase::Type::Array:
+		{
+			const ArrayValue& array= static_cast<const ArrayValue&>(value);
+			out.Write( '[' );
+			SerializeArrayElements( out, array, 0u, array.object_count );
+			out.Write( ']' );
+		}
+		break;
+
+	case ValueBase::Type::String:
+		{
+			const StringValue& string_value= static_cast<const StringValue&>(value);
+			if( string_value.HasEscapes() )
+			{
+				// String is already escaped, write it as is. Only slashes may need escaping.
+				out.Write( '"' );
+				const char* const escaped_string= string_value.GetEscapedString();
+				WriteAlreadyEscapedString( out, escaped_string, std::strlen( escaped_string ), escape_slash_ );
+				out.Write( '"' );
+			}
+			else
+				WriteEscapedString( out, string_value.GetStringView(), escape_slash_ );
+		}
+		break;
+
+	case ValueBase::Type::Number:
+		{
+			const NumberValue& number_value= static_cast<const NumberValue&>(value);
+			if( number_value.has_string )
+			{
+				const char* const number_string= number_value.GetString();
+				WriteDocumentString( out, number_string, std::strlen( number_string ) );
+			}
+			else
+				out.Write( num_str_.data(), GenNumberValueString( number_value ) );
+		}
+		break;
+
+	case ValueBase::Type::Bool:
+		if( static_cast<const BoolValue&>(value).value )
+			out.Write( "true", 4u );
+		else
+			out.Write( "false", 5u );
+		break;
+	};
+}
+
+template<class Writer>
+void Serializer::SerializeObjectMembers( Writer& out, const ObjectValue& object, const size_t begin, const size_t end )
+{
+	for( size_t i= begin; i < end; i++ )
+	{
+		if( i != 0u )
+			out.Write( ',' );
+		WriteEscapedString( out, StringView( object.GetKey(i) ), escape_slash_ );
+		out.Write( ':' );
+		SerializeElement( out, object.GetValue(i) );
+	}
+}
+
+template<class Writer>
+void Serializer::SerializeArrayElements( Writer& out, const ArrayValue& array, const size_t begin, const size_t end )
+{
+	for( size_t i= begin; i < end; i++ )
+	{
+		if( i != 0u )
+			out.Write( ',' );
+		switch( array.layout )
+		{
+		case ArrayValue::Layout::Elements:
+			SerializeElement( out, array.GetElements()[i] );
+			break;
+		case ArrayValue::Layout::PackedDoubles:
+			out.Write( num_str_.data(), GenDoubleValueString( array.GetPackedDoubles()[i], num_str_ ) );
+			break;
+		case ArrayValue::Layout::PackedInt64s:
+			out.Write( num_str_.data(), GenIntValueString( array.GetPackedInt64s()[i], num_str_ ) );
+			break;
+		};
+	}
+}
+
+template<class Writer>
+void Serializer::SerializeElement( Writer& out, const ValueBase* const value )
+{
+	if( IsInlineNumber( value ) )
+		out.Write( num_str_.data(), GenIntValueString( GetInlineNumber( value ), num_str_ ) );
 	else
+		Serialize_r( out, *value );
+}
+
+void Serializer::SerializeIndented( OutputBuffer& out, const Value value, const char indent_symbol, const size_t indent_size, const size_t max_line_width )
+{
+	indent_symbol_= indent_symbol;
+	indent_size_= indent_size;
+	max_line_width_= max_line_width;
+	SerializeIndented_r( out, value, 0u, 0u );
+}
+
+void Serializer::SerializeIndented_r( OutputBuffer& out, const Value value, const size_t depth, const size_t column )
+{
+	const size_t element_count= value.ElementCount();
+	const bool is_object= value.IsObject();
+	if( !( is_object || value.IsArray() ) || element_count == 0u ||
+		( max_line_width_ != 0u && column <= max_line_width_ && GetCompactSizeLimited( value, max_line_width_ - column ) <= max_line_width_ - column ) )
 	{
-		if( number_value.double_value < static_cast<double>( std::numeric_limits<int64_t>::min() ) )
+		// Scalars, empty containers and containers, which fit into line, are written in compact form.
+		SerializeValue( out, value );
+		return;
+	}
+
+	const ValueBase& internal_value= *value.GetInternalValue();
+	const size_t element_indent= ( depth + 1u ) * indent_size_;
+	out.Write( is_object ? '{' : '[' );
+	for( size_t i= 0u; i < element_count; i++ )
+	{
+		if( i != 0u )
+			out.Write( ',' );
+		WriteNewLine( out, indent_symbol_, element_indent );
+		if( is_object )
 		{
-			// Absolute double value is bigger, than int range, write as double.
-			GenDoubleValueString( number_value.double_value, num_str_ );
-			return;
+			const ObjectValue& object= static_cast<const ObjectValue&>(internal_value);
+			const StringView key( object.GetKey(i) );
+			WriteEscapedString( out, key, escape_slash_ );
+			out.Write( ": ", 2u );
+
+			SizeCounter key_size;
+			if( max_line_width_ != 0u )
+				WriteEscapedString( key_size, key, escape_slash_ );
+			SerializeIndented_r( out, Value( object.GetValue(i) ), depth + 1u, element_indent + key_size.size + 2u );
 		}
 		else
+			SerializeIndented_r( out, value[i], depth + 1u, element_indent );
+	}
+	WriteNewLine( out, indent_symbol_, depth * indent_size_ );
+	out.Write( is_object ? '}' : ']' );
+}
+
+size_t Serializer::GetCompactSizeLimited( const Value value, const size_t limit )
+{
+	const size_t element_count= value.ElementCount();
+	const bool is_object= value.IsObject();
+	if( !( is_object || value.IsArray() ) || element_count == 0u )
+	{
+		SizeCounter counter;
+		SerializeValue( counter, value );
+		return counter.size;
+	}
+
+	const ValueBase& internal_value= *value.GetInternalValue();
+	size_t size= 2u; // Brackets.
+	for( size_t i= 0u; i < element_count && size <= limit; i++ )
+	{
+		if( i != 0u )
+			++size;
+		if( is_object )
 		{
-			GenIntValueString( number_value.int_value, num_str_ );
-			return;
+			const ObjectValue& object= static_cast<const ObjectValue&>(internal_value);
+			SizeCounter counter;
+			WriteEscapedString( counter, StringView( object.GetKey(i) ), escape_slash_ );
+			size+= counter.size + 1u;
+			if( size <= limit )
+				size+= GetCompactSizeLimited( Value( object.GetValue(i) ), limit - size );
 		}
+		else
+			size+= GetCompactSizeLimited( value[i], limit - size );
 	}
+	return size;
+}
+
+size_t Serializer::GenNumberValueString( const NumberValue& number_value )
+{
+	// Number knows, if it is integer, so, we do not need to guess it.
+	switch( number_value.kind )
+	{
+	case NumberValue::Kind::Int64:
+		return GenIntValueString( number_value.payload.int_value, num_str_ );
+	case NumberValue::Kind::Uint64:
+		return GenUintValueString( number_value.payload.uint_value, num_str_ );
+	case NumberValue::Kind::Double:
+		return GenDoubleValueString( number_value.payload.double_value, num_str_ );
+	case NumberValue::Kind::Lazy:
+		return GenNumberValueString( number_value.GetConverted() );
+	};
+	return 0u;
 }
 
 } // namespace PanzerJson
@@ -1,21 +1,167 @@
+#include <cstring>
+
+#include "../include/PanzerJson/parser.hpp"
+#include "numbers_formatting.hpp"
+#include "panzer_json_assert.hpp"
 #include "serializers_common.hpp"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace PanzerJson
 {
 
-void GenDoubleValueString( const double val, NumberStringStorage& out_str )
+const char g_string_escapes_table[256]
+{
+	'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+	'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+	0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '/',
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+const char* FindSymbolForEscaping( const char* s, const char* const end, const bool escape_slash ) noexcept
+{
+	// If slash is not escaped, compare with quote twice.
+	const char slash= escape_slash ? '/' : '"';
+
+#if defined(__AVX2__)
+	{
+		const __m256i quote_vec= _mm256_set1_epi8( '"' );
+		const __m256i backslash_vec= _mm256_set1_epi8( '\\' );
+		const __m256i slash_vec= _mm256_set1_epi8( slash );
+		const __m256i max_control_vec= _mm256_set1_epi8( 0x1F );
+		while( end - s >= 32 )
+		{
+			const __m256i v= _mm256_loadu_si256( reinterpret_cast<const __m256i*>(s) );
+			const __m256i mask=
+				_mm256_or_si256(
+					_mm256_or_si256( _mm256_cmpeq_epi8( v, quote_vec ), _mm256_cmpeq_epi8( v, backslash_vec ) ),
+					_mm256_or_si256( _mm256_cmpeq_epi8( v, slash_vec ), _mm256_cmpeq_epi8( _mm256_max_epu8( v, max_control_vec ), max_control_vec ) ) );
+			const uint32_t bits= static_cast<uint32_t>( _mm256_movemask_epi8( mask ) );
+			if( bits != 0u )
+				return s + __builtin_ctz( bits );
+			s+= 32;
+		}
+	}
+#endif
+#if defined(__SSE2__)
+	{
+		const __m128i quote_vec= _mm_set1_epi8( '"' );
+		const __m128i backslash_vec= _mm_set1_epi8( '\\' );
+		const __m128i slash_vec= _mm_set1_epi8( slash );
+		const __m128i max_control_vec= _mm_set1_epi8( 0x1F );
+		while( end - s >= 16 )
+		{
+			const __m128i v= _mm_loadu_si128( reinterpret_cast<const __m128i*>(s) );
+			// Unsigned "v <= 0x1F" is same as "max( v, 0x1F ) == 0x1F".
+			const __m128i mask=
+				_mm_or_si128(
+					_mm_or_si128( _mm_cmpeq_epi8( v, quote_vec ), _mm_cmpeq_epi8( v, backslash_vec ) ),
+					_mm_or_si128( _mm_cmpeq_epi8( v, slash_vec ), _mm_cmpeq_epi8( _mm_max_epu8( v, max_control_vec ), max_control_vec ) ) );
+			const uint32_t bits= static_cast<uint32_t>( _mm_movemask_epi8( mask ) );
+			if( bits != 0u )
+				return s + __builtin_ctz( bits );
+			s+= 16;
+		}
+	}
+#endif
+
+	// Scalar tail or fallback for platforms without SIMD.
+	while( s < end )
+	{
+		const char c= *s;
+		if( g_string_escapes_table[ static_cast<unsigned char>(c) ] != 0 && ( c != '/' || escape_slash ) )
+			return s;
+		++s;
+	}
+	return end;
+}
+
+const char* FindUnescapedSlash( const char* const begin, const char* s, const char* const end ) noexcept
+{
+	while( true )
+	{
+		s= static_cast<const char*>( std::memchr( s, '/', static_cast<size_t>( end - s ) ) );
+		if( s == nullptr )
+			return end;
+
+		// Backslashes in valid escaped string are escape sequence starts or escaped backslashes.
+		// So, slash is escaped only after odd number of backslashes.
+		size_t backslash_count= 0u;
+		for( const char* p= s; p > begin && p[-1] == '\\'; --p )
+			++backslash_count;
+		if( backslash_count % 2u == 0u )
+			return s;
+		++s;
+	}
+}
+
+size_t GenDoubleValueString( const double val, NumberStringStorage& out_str )
 {
-	std::snprintf( out_str.data(), out_str.size(), "%1.22e", val );
+	const size_t length= FormatDouble( val, out_str.data() );
+	out_str[length]= '\0';
+	return length;
 }
 
-void GenIntValueString ( const int64_t  val, NumberStringStorage& out_str )
+size_t GenIntValueString ( const int64_t  val, NumberStringStorage& out_str )
+{
+	const size_t length= FormatInt64( val, out_str.data() );
+	out_str[length]= '\0';
+	return length;
+}
+
+size_t GenUintValueString( const uint64_t val, NumberStringStorage& out_str )
+{
+	const size_t length= FormatUint64( val, out_str.data() );
+	out_str[length]= '\0';
+	return length;
+}
+
+namespace
+{
+
+struct IndentLines
+{
+	char tabs[ 1u + c_indent_block_size ];
+	char spaces[ 1u + c_indent_block_size ];
+
+	IndentLines() noexcept
+	{
+		tabs[0]= spaces[0]= '\n';
+		std::memset( tabs + 1u, '\t', c_indent_block_size );
+		std::memset( spaces + 1u, ' ', c_indent_block_size );
+	}
+};
+
+} // namespace
+
+const char* GetIndentLine( const char indent_symbol ) noexcept
 {
-	std::snprintf( out_str.data(), out_str.size(), "%ld", val );
+	static const IndentLines lines;
+	PJ_ASSERT( indent_symbol == '\t' || indent_symbol == ' ' );
+	return indent_symbol == '\t' ? lines.tabs : lines.spaces;
 }
 
-void GenUintValueString( const uint64_t val, NumberStringStorage& out_str )
+bool IsValidJsonFragment( const StringView& str )
 {
-	std::snprintf( out_str.data(), out_str.size(), "%lu", val );
+	Parser parser;
+	parser.SetEnableNoncompositeJsonRoot( true );
+	return parser.Parse( str.data, str.size )->error == Parser::Result::Error::NoError;
 }
 
 } // namespace PanzerJson
@@ -1,20 +1,87 @@
 #pragma once
+#include <algorithm>
 #include <array>
 
+#include "../include/PanzerJson/chunked_output.hpp"
+#include "../include/PanzerJson/output_buffer.hpp"
 #include "../include/PanzerJson/value.hpp"
 
 namespace PanzerJson
 {
 
+// Escape symbols for string symbols.
+// Zero - symbol is written as is, 'u' - symbol is written as "\u00XX", others - symbol is written as '\' and this escape symbol.
+// Escaping of '/' is optional.
+extern const char g_string_escapes_table[256];
+
+// Writes part of document string (value, key, number string). Such strings live longer, than output.
+// Chunked output references them instead of copying.
+template<class Writer>
+void WriteDocumentString( Writer& out, const char* data, size_t size );
+void WriteDocumentString( ChunkedOutput& out, const char* data, size_t size );
+
+// Returns pointer to first symbol, which needs escaping, or "end". Uses SIMD, if it is available.
+const char* FindSymbolForEscaping( const char* s, const char* end, bool escape_slash ) noexcept;
+
+// Returns pointer to first '/' in range [s, end), which is not part of escape sequence "\/", or "end".
+// "begin" is start of escaped string - backslashes before slash are counted back to it.
+const char* FindUnescapedSlash( const char* begin, const char* s, const char* end ) noexcept;
+
+// Writes already escaped string (without quotes) with "WriteDocumentString".
+// If slash escaping is enabled, also escapes slashes, which are not escaped in this string.
+template<class Writer>
+void WriteAlreadyEscapedString( Writer& out, const char* str, size_t size, bool escape_slash );
+
+// Writes quoted and escaped string into writer - class with methods "Write( char )" and "Write( const char*, size_t )".
+// Parts of string are written with "WriteDocumentString", so, for chunked output string must live longer, than output.
+template<class Writer>
+void WriteEscapedString( Writer& out, const StringView& str, bool escape_slash );
+
+// Generic version for stl-like streams.
 template<class Stream>
-void SerializeString( Stream& stream, const StringType str );
+void SerializeString( Stream& stream, const StringView& str, bool escape_slash= false );
+// Fast version for output buffer. Searches symbols for escaping with SIMD, writes symbols without escaping by blocks.
+// Inline wrapper for "WriteEscapedString".
+void SerializeString( OutputBuffer& out, const StringView& str, bool escape_slash= false );
 
 // String with length, enough for exac decimal number representation.
 typedef std::array<char, 64> NumberStringStorage;
 
-void GenDoubleValueString( double val, NumberStringStorage& out_str );
-void GenIntValueString ( int64_t  val, NumberStringStorage& out_str );
-void GenUintValueString( uint64_t val, NumberStringStorage& out_str );
+// Functions write null-terminated string and return its length.
+// Doubles are written in shortest form, which is converted back to same value.
+size_t GenDoubleValueString( double val, NumberStringStorage& out_str );
+size_t GenIntValueString ( int64_t  val, NumberStringStorage& out_str );
+size_t GenUintValueString( uint64_t val, NumberStringStorage& out_str );
+
+// Writes result of Gen*ValueString functions.
+template<class Stream>
+void WriteNumberString( Stream& stream, const NumberStringStorage& num_str, size_t length );
+void WriteNumberString( OutputBuffer& out, const NumberStringStorage& num_str, size_t length );
+
+// Writes null-terminated string with known length.
+template<class Stream>
+void WriteKnownLengthString( Stream& stream, const char* str, size_t length );
+void WriteKnownLengthString( OutputBuffer& out, const char* str, size_t length );
+
+// Maximum number of indent symbols, written with one copy.
+constexpr size_t c_indent_block_size= 128u;
+// Returns precomputed line - new line symbol and "c_indent_block_size" indent symbols. Only tabs and spaces are supported.
+const char* GetIndentLine( char indent_symbol ) noexcept;
+
+// Writes new line symbol and "indent" indent symbols.
+template<class Stream>
+void WriteNewLine( Stream& stream, char indent_symbol, size_t indent );
+// Indents are copied from precomputed line, one copy per line (for indents up to block size).
+void WriteNewLine( OutputBuffer& out, char indent_symbol, size_t indent );
+
+// Writes string with arbitrary content. Stl-like streams must have "write" method.
+template<class Stream>
+void WriteStringView( Stream& stream, const StringView& str );
+void WriteStringView( OutputBuffer& out, const StringView& str );
+
+// Returns true, if string is complete valid json value (any value, not only object or array).
+// Used in debug checks of pre-serialized fragments.
+bool IsValidJsonFragment( const StringView& str );
 
 } // namespace PanzerJson
 
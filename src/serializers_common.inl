@@ -2,7 +2,7 @@ namespace PanzerJson
 {
 
 template<class Stream>
-void SerializeString( Stream& stream, const StringType str )
+void SerializeString( Stream& stream, const StringView& str, const bool escape_slash )
 {
 	// Change this if string type chaged.
 
@@ -10,32 +10,149 @@ void SerializeString( Stream& stream, const StringType str )
 
 	stream << '"';
 
-	const char* s= str;
-	while( *s != '\0' )
+	for( const char c : str )
 	{
-		if( *s == '"' )
-			stream << "\\\"";
-		else if( *s == '\\' )
-			stream << "\\\\";
-		else if( *s == '/' )
-			stream << "\\/";
-		else if( *s == '\b' )
-			stream << "\\b";
-		else if( *s == '\f' )
-			stream << "\\f";
-		else if( *s == '\n' )
-			stream << "\\n";
-		else if( *s == '\r' )
-			stream << "\\r";
-		else if( *s == '\t' )
-			stream << "\\t";
+		const char escape= g_string_escapes_table[ static_cast<unsigned char>(c) ];
+		if( escape == 0 || ( c == '/' && !escape_slash ) )
+			stream << c;
+		else if( escape == 'u' )
+		{
+			const char* const hex_digits= "0123456789abcdef";
+			const char sequence[]{ '\\', 'u', '0', '0', hex_digits[ c >> 4 ], hex_digits[ c & 15 ], '\0' };
+			stream << sequence;
+		}
 		else
-			stream << *s;
+		{
+			const char sequence[]{ '\\', escape, '\0' };
+			stream << sequence;
+		}
+	}
+
+	stream << '"';
+}
+
+template<class Writer>
+void WriteDocumentString( Writer& out, const char* const data, const size_t size )
+{
+	out.Write( data, size );
+}
+
+inline void WriteDocumentString( ChunkedOutput& out, const char* const data, const size_t size )
+{
+	out.WriteReference( data, size );
+}
+
+template<class Writer>
+void WriteEscapedString( Writer& out, const StringView& str, const bool escape_slash )
+{
+	out.Write( '"' );
+
+	const char* s= str.data;
+	const char* const s_end= str.data + str.size;
+	while( true )
+	{
+		// Write symbols without escaping by one block.
+		const char* const block_end= FindSymbolForEscaping( s, s_end, escape_slash );
+		WriteDocumentString( out, s, static_cast<size_t>( block_end - s ) );
+		if( block_end == s_end )
+			break;
 
+		s= block_end;
+		const char escape= g_string_escapes_table[ static_cast<unsigned char>(*s) ];
+		if( escape == 'u' )
+		{
+			const char* const hex_digits= "0123456789abcdef";
+			const char sequence[]{ '\\', 'u', '0', '0', hex_digits[ *s >> 4 ], hex_digits[ *s & 15 ] };
+			out.Write( sequence, sizeof(sequence) );
+		}
+		else
+		{
+			const char sequence[]{ '\\', escape };
+			out.Write( sequence, sizeof(sequence) );
+		}
 		++s;
 	}
 
-	stream << '"';
+	out.Write( '"' );
+}
+
+template<class Writer>
+void WriteAlreadyEscapedString( Writer& out, const char* const str, const size_t size, const bool escape_slash )
+{
+	const char* const s_end= str + size;
+	if( !escape_slash )
+	{
+		WriteDocumentString( out, str, size );
+		return;
+	}
+
+	const char* s= str;
+	while( true )
+	{
+		const char* const slash= FindUnescapedSlash( str, s, s_end );
+		WriteDocumentString( out, s, static_cast<size_t>( slash - s ) );
+		if( slash == s_end )
+			break;
+		out.Write( "\\/", 2u );
+		s= slash + 1;
+	}
+}
+
+inline void SerializeString( OutputBuffer& out, const StringView& str, const bool escape_slash )
+{
+	WriteEscapedString( out, str, escape_slash );
+}
+
+template<class Stream>
+void WriteNumberString( Stream& stream, const NumberStringStorage& num_str, size_t length )
+{
+	(void)length;
+	stream << num_str.data();
+}
+
+inline void WriteNumberString( OutputBuffer& out, const NumberStringStorage& num_str, const size_t length )
+{
+	out.Write( num_str.data(), length );
+}
+
+template<class Stream>
+void WriteKnownLengthString( Stream& stream, const char* const str, size_t length )
+{
+	(void)length;
+	stream << str;
+}
+
+inline void WriteKnownLengthString( OutputBuffer& out, const char* const str, const size_t length )
+{
+	out.Write( str, length );
+}
+
+template<class Stream>
+void WriteStringView( Stream& stream, const StringView& str )
+{
+	stream.write( str.data, str.size );
+}
+
+inline void WriteStringView( OutputBuffer& out, const StringView& str )
+{
+	out.Write( str.data, str.size );
+}
+
+template<class Stream>
+void WriteNewLine( Stream& stream, const char indent_symbol, const size_t indent )
+{
+	stream << '\n';
+	for( size_t i= 0u; i < indent; i++ )
+		stream << indent_symbol;
+}
+
+inline void WriteNewLine( OutputBuffer& out, const char indent_symbol, const size_t indent )
+{
+	const char* const line= GetIndentLine( indent_symbol );
+	const size_t first_block_size= std::min( indent, c_indent_block_size );
+	out.Write( line, 1u + first_block_size );
+	for( size_t i= first_block_size; i < indent; i+= c_indent_block_size )
+		out.Write( line + 1u, std::min( indent - i, c_indent_block_size ) );
 }
 
 } // namespace PanzerJson
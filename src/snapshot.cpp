@@ -0,0 +1,366 @@
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../include/PanzerJson/snapshot.hpp"
+#include "panzer_json_assert.hpp"
+
+namespace PanzerJson
+{
+
+namespace
+{
+
+// Format constants are duplicated in "gen_panzer_json.py" (blob mode). Change them together.
+const char g_snapshot_magic[8]{ 'P', 'J', 'S', 'N', 'A', 'P', 'S', 'H' };
+const uint32_t g_snapshot_version= 1u;
+// Written in native byte order. Snapshot with other order is rejected.
+const uint32_t g_endianness_tag= 0x01020304u;
+
+// Sizes of structures, which define layout of storage.
+const uint32_t g_layout_signature=
+	uint32_t(sizeof(void*)) |
+	uint32_t(sizeof(ObjectValue)) << 5u |
+	uint32_t(sizeof(ArrayValue)) << 10u |
+	uint32_t(sizeof(StringValue)) << 15u |
+	uint32_t(sizeof(NumberValue)) << 20u |
+	uint32_t(alignof(double)) << 25u;
+
+enum class RootKind : uint32_t
+{
+	StorageValue, // "root" is offset of value in storage.
+	InlineNumber, // "root" is integer value of inline number.
+};
+
+struct SnapshotHeader final
+{
+	char magic[8];
+	uint32_t endianness_tag;
+	uint32_t version;
+	uint32_t layout_signature;
+	RootKind root_kind;
+	uint64_t root;
+	uint64_t storage_size;
+	uint64_t relocation_count;
+	uint64_t checksum; // Of header with zero checksum, storage and relocations.
+};
+
+static_assert( sizeof(SnapshotHeader) % sizeof(uint64_t) == 0u, "Header must have aligned size." );
+
+// Relocations are stored just after storage, so, storage size is aligned.
+size_t AlignedStorageSize( const size_t size ) noexcept
+{
+	return ( size + ( sizeof(uint64_t) - 1u ) ) & ~( sizeof(uint64_t) - 1u );
+}
+
+const uint64_t g_checksum_initial_value= 14695981039346656037ull;
+
+// FNV-1a for 64-bit words.
+uint64_t CalculateChecksum( const unsigned char* const data, const size_t size, uint64_t hash ) noexcept
+{
+	PJ_ASSERT( size % sizeof(uint64_t) == 0u );
+
+	for( size_t i= 0u; i < size; i+= sizeof(uint64_t) )
+	{
+		uint64_t word;
+		std::memcpy( &word, data + i, sizeof(uint64_t) );
+		hash= ( hash ^ word ) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// Builds snapshot storage - copy of result storage with offsets in place of pointers.
+class RelocationsBuilder final
+{
+public:
+	RelocationsBuilder( const unsigned char* const storage, unsigned char* const snapshot_storage, std::vector<uint64_t>& relocations )
+		: storage_(storage), snapshot_storage_(snapshot_storage), relocations_(relocations)
+	{}
+
+	void ProcessValue_r( const ValueBase& value )
+	{
+		switch( value.type )
+		{
+		case ValueBase::Type::Null:
+		case ValueBase::Type::Bool:
+			break;
+
+		case ValueBase::Type::Number:
+			{
+				NumberValue& snapshot_number= GetSnapshotValue<NumberValue>( value );
+				// Conversion of lazy number is not finished - it will be repeated after loading.
+				if( snapshot_number.kind == NumberValue::Kind::Lazy &&
+					snapshot_number.lazy_state.load( std::memory_order_relaxed ) == NumberValue::LazyState::Converting )
+					snapshot_number.lazy_state.store( NumberValue::LazyState::NotConverted, std::memory_order_relaxed );
+			}
+			break;
+
+		case ValueBase::Type::String:
+			{
+				StringValue& snapshot_string= GetSnapshotValue<StringValue>( value );
+				// Unescaping is not finished - it will be repeated after loading.
+				if( snapshot_string.state.load( std::memory_order_relaxed ) == StringValue::State::Unescaping )
+				{
+					snapshot_string.state.store( StringValue::State::Escaped, std::memory_order_relaxed );
+					snapshot_string.length= StringValue::c_unknown_length;
+				}
+			}
+			break;
+
+		case ValueBase::Type::Object:
+			{
+				const ObjectValue& object_value= static_cast<const ObjectValue&>(value);
+				if( object_value.layout == ObjectValue::Layout::Shaped )
+				{
+					const ObjectShape* const shape= object_value.GetShape();
+					Relocate( reinterpret_cast<const ObjectShape* const*>( &object_value + 1u ) );
+					// Shapes are shared between objects.
+					if( visited_shapes_.insert( shape ).second )
+						for( size_t i= 0u; i < shape->key_count; i++ )
+							Relocate( &shape->GetKeys()[i] );
+
+					for( size_t i= 0u; i < object_value.object_count; i++ )
+						ProcessValuePointer_r( &object_value.GetShapedValues()[i] );
+				}
+				else
+				{
+					for( size_t i= 0u; i < object_value.object_count; i++ )
+					{
+						Relocate( &object_value.GetEntries()[i].key );
+						ProcessValuePointer_r( &object_value.GetEntries()[i].value );
+					}
+				}
+			}
+			break;
+
+		case ValueBase::Type::Array:
+			{
+				const ArrayValue& array_value= static_cast<const ArrayValue&>(value);
+				if( array_value.layout != ArrayValue::Layout::Elements )
+					break; // Packed arrays have no pointers.
+
+				for( size_t i= 0u; i < array_value.object_count; i++ )
+					ProcessValuePointer_r( &array_value.GetElements()[i] );
+			}
+			break;
+		};
+	}
+
+private:
+	void ProcessValuePointer_r( const ValueBase* const* const value_ptr )
+	{
+		if( IsInlineNumber( *value_ptr ) )
+			return; // Inline numbers are not pointers.
+
+		Relocate( value_ptr );
+		ProcessValue_r( **value_ptr );
+	}
+
+	// Replace pointer in snapshot storage with offset and remember place of it.
+	template<class T>
+	void Relocate( T* const* const ptr )
+	{
+		const uint64_t ptr_offset= Offset( ptr );
+		const uintptr_t value_offset= static_cast<uintptr_t>( Offset( *ptr ) );
+		std::memcpy( snapshot_storage_ + ptr_offset, &value_offset, sizeof(uintptr_t) );
+		relocations_.push_back( ptr_offset );
+	}
+
+	template<class T>
+	T& GetSnapshotValue( const ValueBase& value )
+	{
+		return *reinterpret_cast<T*>( snapshot_storage_ + Offset( &value ) );
+	}
+
+	uint64_t Offset( const void* const ptr ) const noexcept
+	{
+		return static_cast<uint64_t>( static_cast<const unsigned char*>(ptr) - storage_ );
+	}
+
+private:
+	const unsigned char* const storage_;
+	unsigned char* const snapshot_storage_;
+	std::vector<uint64_t>& relocations_;
+	std::unordered_set<const ObjectShape*> visited_shapes_;
+};
+
+} // namespace
+
+void Snapshot::Save( const Parser::Result& result, OutputBuffer& out )
+{
+	PJ_ASSERT( result.error == Parser::Result::Error::NoError );
+
+	const unsigned char* const storage= result.storage.data();
+	const size_t storage_size= result.storage.size();
+
+	std::vector<unsigned char> snapshot_storage( AlignedStorageSize( storage_size ), 0u );
+	std::memcpy( snapshot_storage.data(), storage, storage_size );
+	std::vector<uint64_t> relocations;
+
+	SnapshotHeader header;
+	std::memcpy( header.magic, g_snapshot_magic, sizeof(g_snapshot_magic) );
+	header.endianness_tag= g_endianness_tag;
+	header.version= g_snapshot_version;
+	header.layout_signature= g_layout_signature;
+
+	const ValueBase* const root= result.root.GetInternalValue();
+	const unsigned char* const root_ptr= reinterpret_cast<const unsigned char*>(root);
+	if( root_ptr >= storage && root_ptr < storage + storage_size )
+	{
+		header.root_kind= RootKind::StorageValue;
+		header.root= static_cast<uint64_t>( root_ptr - storage );
+		RelocationsBuilder( storage, snapshot_storage.data(), relocations ).ProcessValue_r( *root );
+	}
+	else
+	{
+		// Only inline numbers are stored outside storage.
+		PJ_ASSERT( result.root.IsNumber() );
+		header.root_kind= RootKind::InlineNumber;
+		header.root= static_cast<uint64_t>( result.root.AsInt64() );
+	}
+
+	header.storage_size= storage_size;
+	header.relocation_count= relocations.size();
+	header.checksum= 0u;
+	uint64_t checksum= CalculateChecksum( reinterpret_cast<const unsigned char*>(&header), sizeof(SnapshotHeader), g_checksum_initial_value );
+	checksum= CalculateChecksum( snapshot_storage.data(), snapshot_storage.size(), checksum );
+	checksum= CalculateChecksum( reinterpret_cast<const unsigned char*>( relocations.data() ), relocations.size() * sizeof(uint64_t), checksum );
+	header.checksum= checksum;
+
+	out.Write( reinterpret_cast<const char*>(&header), sizeof(SnapshotHeader) );
+	out.Write( reinterpret_cast<const char*>( snapshot_storage.data() ), snapshot_storage.size() );
+	if( !relocations.empty() )
+		out.Write( reinterpret_cast<const char*>( relocations.data() ), relocations.size() * sizeof(uint64_t) );
+}
+
+bool Snapshot::SaveFile( const Parser::Result& result, const char* const file_name )
+{
+	std::FILE* const file= std::fopen( file_name, "wb" );
+	if( file == nullptr )
+		return false;
+
+	OutputBuffer out;
+	Save( result, out );
+	const bool ok= std::fwrite( out.GetData(), 1u, out.GetSize(), file ) == out.GetSize();
+	return std::fclose( file ) == 0 && ok;
+}
+
+Parser::ResultPtr Snapshot::Load( const void* const data, const size_t size )
+{
+	SnapshotHeader header;
+	if( size < sizeof(SnapshotHeader) )
+		return nullptr;
+	std::memcpy( &header, data, sizeof(SnapshotHeader) );
+
+	if( std::memcmp( header.magic, g_snapshot_magic, sizeof(g_snapshot_magic) ) != 0 ||
+		header.endianness_tag != g_endianness_tag ||
+		header.version != g_snapshot_version ||
+		header.layout_signature != g_layout_signature )
+		return nullptr;
+
+	const size_t max_size= size - sizeof(SnapshotHeader);
+	if( header.storage_size > max_size ||
+		header.relocation_count > max_size / sizeof(uint64_t) ||
+		AlignedStorageSize( header.storage_size ) + header.relocation_count * sizeof(uint64_t) != max_size )
+		return nullptr;
+
+	const unsigned char* const snapshot_storage= static_cast<const unsigned char*>(data) + sizeof(SnapshotHeader);
+	const unsigned char* const relocations_data= snapshot_storage + AlignedStorageSize( header.storage_size );
+	SnapshotHeader header_without_checksum= header;
+	header_without_checksum.checksum= 0u;
+	uint64_t checksum= CalculateChecksum( reinterpret_cast<const unsigned char*>(&header_without_checksum), sizeof(SnapshotHeader), g_checksum_initial_value );
+	checksum= CalculateChecksum( snapshot_storage, AlignedStorageSize( header.storage_size ), checksum );
+	checksum= CalculateChecksum( relocations_data, header.relocation_count * sizeof(uint64_t), checksum );
+	if( checksum != header.checksum )
+		return nullptr;
+
+	std::unique_ptr<Parser::Result> result( new Parser::Result );
+	result->storage.assign( snapshot_storage, snapshot_storage + header.storage_size );
+	unsigned char* const storage= result->storage.data();
+	const size_t storage_size= result->storage.size();
+
+	for( size_t i= 0u; i < header.relocation_count; i++ )
+	{
+		uint64_t ptr_offset;
+		std::memcpy( &ptr_offset, relocations_data + i * sizeof(uint64_t), sizeof(uint64_t) );
+		if( ptr_offset > storage_size - sizeof(uintptr_t) || storage_size < sizeof(uintptr_t) )
+			return nullptr;
+
+		uintptr_t value_offset;
+		std::memcpy( &value_offset, storage + ptr_offset, sizeof(uintptr_t) );
+		if( value_offset >= storage_size )
+			return nullptr;
+
+		const uintptr_t value= reinterpret_cast<uintptr_t>(storage) + value_offset;
+		std::memcpy( storage + ptr_offset, &value, sizeof(uintptr_t) );
+	}
+
+	switch( header.root_kind )
+	{
+	case RootKind::StorageValue:
+		if( header.root >= storage_size )
+			return nullptr;
+		result->root= Value( reinterpret_cast<const ValueBase*>( storage + header.root ) );
+		break;
+	case RootKind::InlineNumber:
+		{
+			const int64_t number= static_cast<int64_t>( header.root );
+			if( number < c_min_inline_number || number > c_max_inline_number )
+				return nullptr;
+			result->root= Value( MakeInlineNumber( number ) );
+		}
+		break;
+	default:
+		return nullptr;
+	};
+
+	return result;
+}
+
+Parser::ResultPtr Snapshot::LoadFile( const char* const file_name )
+{
+#if defined(__unix__) || defined(__APPLE__)
+	const int fd= open( file_name, O_RDONLY );
+	if( fd < 0 )
+		return nullptr;
+
+	struct stat file_stat;
+	if( fstat( fd, &file_stat ) != 0 || file_stat.st_size <= 0 )
+	{
+		close( fd );
+		return nullptr;
+	}
+
+	const size_t size= static_cast<size_t>( file_stat.st_size );
+	void* const data= mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if( data == MAP_FAILED )
+		return nullptr;
+
+	Parser::ResultPtr result= Load( data, size );
+	munmap( data, size );
+	return result;
+#else
+	std::FILE* const file= std::fopen( file_name, "rb" );
+	if( file == nullptr )
+		return nullptr;
+
+	std::vector<unsigned char> data;
+	unsigned char buffer[65536u];
+	size_t read_size;
+	while( ( read_size= std::fread( buffer, 1u, sizeof(buffer), file ) ) != 0u )
+		data.insert( data.end(), buffer, buffer + read_size );
+	std::fclose( file );
+
+	return Load( data.data(), data.size() );
+#endif
+}
+
+} // namespace PanzerJson
@@ -0,0 +1,101 @@
+#include <cstring>
+
+#include "strings_parsing.hpp"
+
+namespace PanzerJson
+{
+
+EscapeSequenceParseResult ParseEscapeSequence( const char*& str, const char* const str_end, char* const out, size_t& out_size ) noexcept
+{
+	if( str == str_end )
+		return EscapeSequenceParseResult::UnexpectedEndOfFile;
+
+	out_size= 1u;
+	switch(*str)
+	{
+	case '"':
+	case '\\':
+	case '/':
+		out[0]= *str;
+		++str;
+		return EscapeSequenceParseResult::Ok;
+
+	case 'b': out[0]= '\b'; ++str; return EscapeSequenceParseResult::Ok;
+	case 'f': out[0]= '\f'; ++str; return EscapeSequenceParseResult::Ok;
+	case 'n': out[0]= '\n'; ++str; return EscapeSequenceParseResult::Ok;
+	case 'r': out[0]= '\r'; ++str; return EscapeSequenceParseResult::Ok;
+	case 't': out[0]= '\t'; ++str; return EscapeSequenceParseResult::Ok;
+
+	case 'u':
+		{
+			if( str_end - str < 5 )
+				return EscapeSequenceParseResult::UnexpectedEndOfFile;
+			++str;
+
+			// Parse hex number.
+			size_t char_code= 0u;
+			for( size_t i= 0u; i < 4u; i++ )
+			{
+				size_t digit;
+				if( str[i] >= '0' && str[i] <= '9' )
+					digit= size_t( str[i] - '0' );
+				else if( str[i] >= 'a' && str[i] <= 'f' )
+					digit= size_t( str[i] - 'a' + 10 );
+				else if( str[i] >= 'A' && str[i] <= 'F' )
+					digit= size_t( str[i] - 'A' + 10 );
+				else
+					return EscapeSequenceParseResult::UnexpectedLexem;
+				char_code|= digit << ( ( 3u - i ) * 4u );
+			}
+			str+= 4u;
+
+			// Convert to UTF-8.
+			// Change this, if string format changed.
+			if( char_code <= 0x7Fu )
+				out[0]= static_cast<char>( char_code );
+			else if( char_code <= 0x7FFu )
+			{
+				out[0]= static_cast<char>( 0xC0u | ( char_code >> 6u ) );
+				out[1]= static_cast<char>( 0x80u | ( char_code & 0x3Fu ) );
+				out_size= 2u;
+			}
+			else// if( char_code <= 0xFFFFu )
+			{
+				out[0]= static_cast<char>( 0xE0u | (         ( char_code >> 12u ) ) );
+				out[1]= static_cast<char>( 0x80u | ( 0x3Fu & ( char_code >>  6u ) ) );
+				out[2]= static_cast<char>( 0x80u | ( 0x3Fu & ( char_code >>  0u ) ) );
+				out_size= 3u;
+			}
+		}
+		return EscapeSequenceParseResult::Ok;
+
+	default:
+		return EscapeSequenceParseResult::UnexpectedLexem;
+	};
+}
+
+size_t UnescapeString( const char* str, char* out ) noexcept
+{
+	char* const out_start= out;
+	const char* const str_end= str + std::strlen(str);
+	while( str < str_end )
+	{
+		if( *str == '\\' )
+		{
+			++str;
+			size_t symbol_size= 0u;
+			if( ParseEscapeSequence( str, str_end, out, symbol_size ) == EscapeSequenceParseResult::Ok )
+				out+= symbol_size;
+		}
+		else
+		{
+			*out= *str;
+			++out;
+			++str;
+		}
+	}
+	*out= '\0';
+	return static_cast<size_t>( out - out_start );
+}
+
+} // namespace PanzerJson
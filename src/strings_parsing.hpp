@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+namespace PanzerJson
+{
+
+enum class EscapeSequenceParseResult
+{
+	Ok,
+	UnexpectedEndOfFile,
+	UnexpectedLexem,
+};
+
+// Parses escape sequence of json string. "str" must point to symbol after '\'.
+// On success moves "str" after sequence, writes UTF-8 bytes of symbol into "out" (up to 3 bytes) and number of bytes into "out_size".
+EscapeSequenceParseResult ParseEscapeSequence( const char*& str, const char* str_end, char* out, size_t& out_size ) noexcept;
+
+// Unescapes null-terminated string with valid json escape sequences.
+// "out" must have size, at least equal to size of "str", including terminating null.
+// Returns length of unescaped string. It may contain null symbols.
+size_t UnescapeString( const char* str, char* out ) noexcept;
+
+} // namespace PanzerJson
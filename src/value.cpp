@@ -1,6 +1,11 @@
+#include <algorithm>
 #include <cstring>
+#include <thread>
+#include <type_traits>
 
+#include "numbers_parsing.hpp"
 #include "panzer_json_assert.hpp"
+#include "strings_parsing.hpp"
 
 #include "../include/PanzerJson/value.hpp"
 
@@ -20,11 +25,11 @@ static_assert(
 	enum_size == 1u,
 	"Value::Type size must be 1");
 static_assert(
-	sizeof(ValueBase) == enum_size,
-	"Unexpected size of ValueBase");
+	sizeof(ValueBase) == 2u && alignof(ValueBase) == 2u,
+	"Unexpected size of ValueBase"); // Lowest bit of pointers must be free for inline numbers.
 
 static_assert(
-	sizeof(NullValue) == enum_size, // enum value
+	sizeof(NullValue) == sizeof(ValueBase), // enum value + padding
 	"Unexpceted size of NullValue");
 
 static_assert(
@@ -36,11 +41,11 @@ static_assert(
 	"Unexpceted size of ArrayValue");
 
 static_assert(
-	sizeof(StringValue) == enum_size, // enum value
+	sizeof(StringValue) == sizeof(uint32_t) * 2u, // enum value + state + padding + uint32
 	"Unexpceted size of StringValue");
 
 static_assert(
-	sizeof(NumberValue) == ( sizeof(int32_t) * 2u + sizeof(int64_t) + sizeof(double) ), // enum value + padding + int64 + double
+	sizeof(NumberValue) == sizeof(int64_t) * 2u, // enum value + has_string + kind + lazy state + converted kind + padding + payload
 	"Unexpceted size of NumberValue");
 
 static_assert(
@@ -50,6 +55,7 @@ static_assert(
 // Nulls are not pointer-aligned.
 static_assert( sizeof(ObjectValue) % ptr_size == 0u, "Value classes must have pointer-scaled size." );
 static_assert( sizeof(ObjectValue::ObjectEntry) % ptr_size == 0u, "Value classes must have pointer-scaled size." );
+static_assert( sizeof(ObjectShape) == ptr_size, "Shape keys must be placed just after shape." );
 static_assert( sizeof(ArrayValue) % ptr_size == 0u, "Value classes must have pointer-scaled size." );
 // Strings are not pointer-aligned.
 static_assert( sizeof(NumberValue) % ptr_size == 0u, "Value classes must have pointer-scaled size." );
@@ -61,18 +67,40 @@ static_assert(
 	sizeof(ObjectValueWithEntriesStorage<10000000u>) == sizeof(ObjectValue) + sizeof(ObjectValue::ObjectEntry) * 10000000u,
 	"Object`s entries storage must store entries just behind object and have no gaps between object and entries." );
 
+static_assert(
+	sizeof(ShapedObjectValueWithValuesStorage<       0u>) == sizeof(ObjectValue) + ptr_size &&
+	sizeof(ShapedObjectValueWithValuesStorage<       1u>) == sizeof(ObjectValue) + ptr_size + sizeof(const ValueBase*) &&
+	sizeof(ShapedObjectValueWithValuesStorage<10000000u>) == sizeof(ObjectValue) + ptr_size + sizeof(const ValueBase*) * 10000000u,
+	"Shaped object`s values storage must have no gaps between object, shape pointer and values." );
+
+static_assert(
+	sizeof(ObjectShapeWithKeysStorage<       1u>) == sizeof(ObjectShape) + sizeof(StringType) &&
+	sizeof(ObjectShapeWithKeysStorage<10000000u>) == sizeof(ObjectShape) + sizeof(StringType) * 10000000u,
+	"Shape`s keys storage must have no gaps between shape and keys." );
+
 static_assert(
 	sizeof(ArrayValueWithElementsStorage<       0u>) == sizeof(ArrayValue) &&
 	sizeof(ArrayValueWithElementsStorage<       1u>) == sizeof(ArrayValue) + sizeof(const ValueBase*) &&
 	sizeof(ArrayValueWithElementsStorage<10000000u>) == sizeof(ArrayValue) + sizeof(const ValueBase*) * 10000000u,
 	"Arrays`s elements storage must have no gaps between array value and elements." );
 
+static_assert(
+	sizeof(PackedDoubleArrayValueWithStorage<       1u>) == sizeof(ArrayValue) + sizeof(double) &&
+	sizeof(PackedDoubleArrayValueWithStorage<10000000u>) == sizeof(ArrayValue) + sizeof(double) * 10000000u,
+	"Packed array`s storage must have no gaps between array value and numbers." );
+
+static_assert(
+	sizeof(PackedInt64ArrayValueWithStorage<       1u>) == sizeof(ArrayValue) + sizeof(int64_t) &&
+	sizeof(PackedInt64ArrayValueWithStorage<10000000u>) == sizeof(ArrayValue) + sizeof(int64_t) * 10000000u,
+	"Packed array`s storage must have no gaps between array value and numbers." );
+
 // String storage placed just after string value.
-// Alignmnet of string storage must be "1".
+// Alignmnet of string storage must be "1", but size of storage is aligned to values alignment.
 static_assert(
 	sizeof(StringValueWithStorage<       0u>) == sizeof(StringValue) &&
-	sizeof(StringValueWithStorage<       1u>) == sizeof(StringValue) + 1u &&
-	sizeof(StringValueWithStorage<       2u>) == sizeof(StringValue) + 2u &&
+	sizeof(StringValueWithStorage<       1u>) == sizeof(StringValue) + 4u &&
+	sizeof(StringValueWithStorage<       4u>) == sizeof(StringValue) + 4u &&
+	sizeof(StringValueWithStorage<       5u>) == sizeof(StringValue) + 8u &&
 	sizeof(StringValueWithStorage<10000000u>) == sizeof(StringValue) + 10000000u,
 	"Bad string storage" );
 
@@ -86,8 +114,8 @@ static_assert(
 	"Bad number string storage" );
 
 static_assert( sizeof(Value::UniversalIterator) <= ptr_size * 2u, "Universal iterator is too large." );
-static_assert( sizeof(Value::ArrayIterator) == ptr_size, "Specialized iterator must have pointer size." );
-static_assert( sizeof(Value::ObjectIterator) == ptr_size, "Specialized iterator must have pointer size." );
+static_assert( sizeof(Value::ArrayIterator) == ptr_size * 2u, "Array iterator must have size of two pointers." );
+static_assert( sizeof(Value::ObjectIterator) == ptr_size * 2u, "Object iterator must have size of two pointers." );
 
 }
 
@@ -103,78 +131,213 @@ int StringCompare( const StringType& l, const StringType& r ) noexcept
 	return std::strcmp( l, r );
 }
 
-static bool ValuesAreEqual_r( const ValueBase& l, const ValueBase& r ) noexcept
+int StringCompare( const StringView& l, const StringType& r ) noexcept
+{
+	// Change this if string type changed.
+
+	for( size_t i= 0u; i < l.size; ++i )
+	{
+		const unsigned char l_c= static_cast<unsigned char>( l.data[i] );
+		const unsigned char r_c= static_cast<unsigned char>( r[i] );
+		if( r_c == 0u ) // Right string is end, left is longer.
+			return +1;
+		if( l_c != r_c )
+			return l_c < r_c ? -1 : +1;
+	}
+	return r[l.size] == '\0' ? 0 : -1;
+}
+
+size_t StringHash( const char* const str, const size_t length ) noexcept
+{
+	// FNV-1a hash.
+	uint64_t hash= 14695981039346656037ull;
+	for( size_t i= 0u; i < length; i++ )
+	{
+		hash^= static_cast<unsigned char>( str[i] );
+		hash*= 1099511628211ull;
+	}
+	return static_cast<size_t>(hash);
+}
+
+// Returns first bytes of string in big-endian order. Missing bytes are zeros.
+static uint64_t GetStringPrefix( const StringType str, const size_t length= ~size_t(0u) ) noexcept
 {
-	if( l.type != r.type )
+	uint64_t result= 0u;
+	for( size_t i= 0u; i < sizeof(uint64_t); i++ )
+	{
+		const unsigned char c= i < length ? static_cast<unsigned char>( str[i] ) : 0u;
+		if( c == 0u )
+			return i == 0u ? 0u : result << ( ( sizeof(uint64_t) - i ) * 8u );
+		result= ( result << 8u ) | c;
+	}
+	return result;
+}
+
+Key::Key( const StringType key ) noexcept
+	: Key( StringView( key ) )
+{}
+
+Key::Key( const StringView& key ) noexcept
+	: str_(key.data)
+	, length_(key.size)
+	, prefix_( GetStringPrefix( key.data, key.size ) )
+{}
+
+int Key::Compare( const StringType str ) const noexcept
+{
+	if( str == str_ )
+		return 0;
+
+	const uint64_t str_prefix= GetStringPrefix( str );
+	if( prefix_ < str_prefix )
+		return -1;
+	if( prefix_ > str_prefix )
+		return +1;
+
+	// Prefixes are equal. If key is short, prefixes contain terminating null, so, strings are equal.
+	if( length_ < sizeof(uint64_t) )
+		return 0;
+	return StringCompare( StringView( str_ + sizeof(uint64_t), length_ - sizeof(uint64_t) ), str + sizeof(uint64_t) );
+}
+
+bool Key::IsEqual( const StringType str ) const noexcept
+{
+	return Compare( str ) == 0;
+}
+
+void Key::ResetCache() const noexcept
+{
+	cached_index_= 0u;
+	cached_key_ptr_= nullptr;
+}
+
+static bool ValuesAreEqual_r( const Value& l, const Value& r ) noexcept
+{
+	const ValueBase::Type type= l.GetType();
+	if( type != r.GetType() )
 		return false;
 
-	switch( l.type )
+	switch( type )
 	{
 	case ValueBase::Type::Null:
 		return true;
 
 	case ValueBase::Type::Object:
 		{
-			const ObjectValue& l_object= static_cast<const ObjectValue&>(l);
-			const ObjectValue& r_object= static_cast<const ObjectValue&>(r);
-			if( l_object.object_count != r_object.object_count )
+			if( l.ElementCount() != r.ElementCount() )
 				return false;
 
-			for( uint32_t i= 0u; i < l_object.object_count; i++ )
+			Value::ObjectIterator r_it= r.object_begin();
+			for( const auto& l_member : l.object_elements() )
 			{
-				if( StringCompare( l_object.GetEntries()[i].key, r_object.GetEntries()[i].key ) != 0 )
+				const auto r_member= *r_it;
+				if( StringCompare( l_member.first, r_member.first ) != 0 )
 					return false;
-				if( !ValuesAreEqual_r( *l_object.GetEntries()[i].value, *r_object.GetEntries()[i].value ) )
+				if( !ValuesAreEqual_r( l_member.second, r_member.second ) )
 					return false;
+				++r_it;
 			}
 			return true;
 		}
 
 	case ValueBase::Type::Array:
 		{
-			const ArrayValue& l_array= static_cast<const ArrayValue&>(l);
-			const ArrayValue& r_array= static_cast<const ArrayValue&>(r);
-			if( l_array.object_count != r_array.object_count )
+			if( l.ElementCount() != r.ElementCount() )
 				return false;
 
-			for( uint32_t i= 0u; i < l_array.object_count; i++ )
+			// Elements of packed and not packed arrays are compared same way.
+			Value::ArrayIterator r_it= r.array_begin();
+			for( const Value l_element : l.array_elements() )
 			{
-				if( !ValuesAreEqual_r( *l_array.GetElements()[i], *r_array.GetElements()[i] ) )
+				if( !ValuesAreEqual_r( l_element, *r_it ) )
 					return false;
+				++r_it;
 			}
 			return true;
 		}
 
 	case ValueBase::Type::String:
-		return
-			StringCompare(
-				static_cast<const StringValue&>(l).GetString(),
-				static_cast<const StringValue&>(r).GetString() ) == 0;
-
-	case ValueBase::Type::Number:
 		{
-			const NumberValue& l_number= static_cast<const NumberValue&>(l);
-			const NumberValue& r_number= static_cast<const NumberValue&>(r);
-			// TODO - maybe compare and string values too?
-			return
-				l_number.int_value == r_number.int_value &&
-				l_number.double_value == r_number.double_value;
+			const StringView l_str= l.AsStringView();
+			const StringView r_str= r.AsStringView();
+			return l_str.size == r_str.size && std::memcmp( l_str.data, r_str.data, l_str.size ) == 0;
 		}
 
+	case ValueBase::Type::Number:
+		// TODO - maybe compare and string values too?
+		return l.AsInt64() == r.AsInt64() && l.AsDouble() == r.AsDouble();
+
 		case ValueBase::Type::Bool:
-			return static_cast<const BoolValue&>(l).value == static_cast<const BoolValue&>(r).value;
+			return l.AsInt64() == r.AsInt64();
 	}
 
 	return false;
 }
 
+const NumberValue Value::inline_double_number_= NumberValue::FromDouble( 0.0 );
+const NumberValue Value::inline_int_number_= NumberValue::FromInt64( 0 );
+
+const char* StringValue::GetUnescapedString() const noexcept
+{
+	const char* const escaped_string= GetEscapedString();
+	char* const unescaped_string= const_cast<char*>( escaped_string + std::strlen( escaped_string ) + 1u );
+
+	State expected_state= State::Escaped;
+	if( state.compare_exchange_strong( expected_state, State::Unescaping, std::memory_order_acquire ) )
+	{
+		const size_t unescaped_length= UnescapeString( escaped_string, unescaped_string );
+		length= unescaped_length < c_unknown_length ? uint32_t(unescaped_length) : c_unknown_length;
+		state.store( State::Unescaped, std::memory_order_release );
+		return unescaped_string;
+	}
+
+	// Other thread unescapes string now - wait for it.
+	while( state.load( std::memory_order_acquire ) != State::Unescaped )
+		std::this_thread::yield();
+	return unescaped_string;
+}
+
+NumberValue NumberValue::GetConverted() const noexcept
+{
+	if( kind != Kind::Lazy )
+		return *this;
+
+	if( lazy_state.load( std::memory_order_acquire ) == LazyState::Converted )
+		return NumberValue( converted_kind, payload, has_string );
+
+	const char* const str= GetString();
+	Kind result_kind;
+	Payload result_payload( uint64_t(0u) );
+	ParseNumber( str, str + std::strlen( str ), result_kind, result_payload );
+
+	// Save result, if no other thread does this now. Other threads do not wait - they convert number themselves.
+	// Lazy numbers are created only by parser in its nonconstant storage, so, writing of payload is allowed.
+	LazyState expected_state= LazyState::NotConverted;
+	if( lazy_state.compare_exchange_strong( expected_state, LazyState::Converting, std::memory_order_acquire ) )
+	{
+		converted_kind= result_kind;
+		const_cast<Payload&>(payload)= result_payload;
+		lazy_state.store( LazyState::Converted, std::memory_order_release );
+	}
+
+	return NumberValue( result_kind, result_payload, has_string );
+}
+
 Value::Value() noexcept
 	: value_( &g_null_value_content )
-{}
+{
+	inline_number_.int_value= 0;
+}
 
 Value::Value( const ValueBase* const value ) noexcept
 	: value_(value)
 {
+	inline_number_.int_value= 0;
+	if( IsInlineNumber( value ) )
+	{
+		value_= &inline_int_number_;
+		inline_number_.int_value= GetInlineNumber( value );
+	}
 	PJ_ASSERT( value_ != nullptr );
 }
 
@@ -187,6 +350,28 @@ size_t Value::ElementCount() const noexcept
 	return 0u;
 }
 
+Span<double> Value::AsDoubleSpan() const noexcept
+{
+	if( value_->type == ValueBase::Type::Array )
+	{
+		const ArrayValue& array_value= static_cast<const ArrayValue&>(*value_);
+		if( array_value.layout == ArrayValue::Layout::PackedDoubles )
+			return Span<double>{ array_value.GetPackedDoubles(), array_value.object_count };
+	}
+	return Span<double>{ nullptr, 0u };
+}
+
+Span<int64_t> Value::AsInt64Span() const noexcept
+{
+	if( value_->type == ValueBase::Type::Array )
+	{
+		const ArrayValue& array_value= static_cast<const ArrayValue&>(*value_);
+		if( array_value.layout == ArrayValue::Layout::PackedInt64s )
+			return Span<int64_t>{ array_value.GetPackedInt64s(), array_value.object_count };
+	}
+	return Span<int64_t>{ nullptr, 0u };
+}
+
 bool Value::IsMember( const StringType& key ) const noexcept
 {
 	if( value_->type == ValueBase::Type::Object )
@@ -195,13 +380,29 @@ bool Value::IsMember( const StringType& key ) const noexcept
 	return false;
 }
 
+bool Value::IsMember( const StringView& key ) const noexcept
+{
+	if( value_->type == ValueBase::Type::Object )
+		return SearchObject( static_cast<const ObjectValue&>(*value_), key );
+
+	return false;
+}
+
+bool Value::IsMember( const Key& key ) const noexcept
+{
+	if( value_->type == ValueBase::Type::Object )
+		return SearchObject( static_cast<const ObjectValue&>(*value_), key );
+
+	return false;
+}
+
 Value Value::operator[]( const size_t array_index ) const noexcept
 {
 	if( value_->type == ValueBase::Type::Array )
 	{
 		const ArrayValue& array_value= static_cast<const ArrayValue&>(*value_);
 		if( array_index < array_value.object_count )
-			return Value( array_value.GetElements()[ array_index ] );
+			return GetArrayElement( array_value, array_index );
 	}
 
 	return g_null_value;
@@ -218,49 +419,193 @@ Value Value::operator[]( const StringType& key ) const noexcept
 	return g_null_value;
 }
 
-const ValueBase* Value::SearchObject( const ObjectValue& object, const StringType& key ) const noexcept
+Value Value::operator[]( const StringView& key ) const noexcept
 {
-	/*
-	for( size_t i= 0u; i < object.object_count; i++ )
+	if( value_->type == ValueBase::Type::Object )
 	{
-		if( StringCompare( key, object.sub_objects[i].key ) == 0 )
-			return object.sub_objects[i].value;
-	}*/
+		const ValueBase* const member= SearchObject( static_cast<const ObjectValue&>(*value_), key );
+		if( member != nullptr )
+			return Value( member );
+	}
+	return g_null_value;
+}
 
+Value Value::operator[]( const Key& key ) const noexcept
+{
+	if( value_->type == ValueBase::Type::Object )
+	{
+		const ValueBase* const member= SearchObject( static_cast<const ObjectValue&>(*value_), key );
+		if( member != nullptr )
+			return Value( member );
+	}
+	return g_null_value;
+}
+
+// Keys accessor for objects with entries.
+struct EntriesKeys final
+{
+	const ObjectValue::ObjectEntry* entries;
+
+	StringType operator[]( const size_t index ) const noexcept
+	{
+		return entries[index].key;
+	}
+};
+
+// Returns key index or keys count, if key not found.
+// "KeyString" is StringType or StringView.
+template<class Keys, class KeyString>
+static size_t SearchKey( const Keys& keys, const size_t key_count, const KeyString& key ) noexcept
+{
 	// Make binary search here.
 	// WARNING! Keys must be sorted. Python script or parser must sort keys.
-	const ObjectValue::ObjectEntry* start= object.GetEntries();
-	const ObjectValue::ObjectEntry* end= object.GetEntries() + object.object_count;
-	if( start == end )
-		return nullptr;
+	if( key_count == 0u )
+		return key_count;
 
-	if( StringCompare( key, start->key ) < 0 )
-		return nullptr;
-	if( StringCompare( key, (end-1u)->key ) > 0 )
-		return nullptr;
+	if( StringCompare( key, keys[0u] ) < 0 )
+		return key_count;
+	if( StringCompare( key, keys[key_count - 1u] ) > 0 )
+		return key_count;
 
-	while(true)
+	size_t start= 0u;
+	size_t end= key_count;
+	while( start < end )
 	{
-		if( start == end )
-			return nullptr;
+		const size_t middle= start + ( end - start ) / 2u;
+		const int comp= StringCompare( key, keys[middle] );
+		if( comp < 0 )
+			end= middle;
+		else if( comp > 0 )
+			start= middle + 1u;
+		else
+			return middle;
+	}
+
+	return key_count;
+}
+
+// Returns true, if string has given prefix (result of "GetStringPrefix") and length.
+static bool HasPrefixAndLength( const StringType str, const uint64_t prefix, const size_t length ) noexcept
+{
+	if( GetStringPrefix( str ) != prefix )
+		return false;
+	// If string is short, prefix contains terminating null.
+	if( length < sizeof(uint64_t) )
+		return true;
+
+	// Stop at terminating null, so, shorter strings are not read after their end.
+	for( size_t i= sizeof(uint64_t); i < length; i++ )
+	{
+		if( str[i] == '\0' )
+			return false;
+	}
+	return str[length] == '\0';
+}
 
-		const ObjectValue::ObjectEntry* const middle= start + size_t( end - start ) / 2u;
-		const int comp= StringCompare( key, middle->key );
+template<class Keys>
+static size_t SearchKey(
+	const Keys& keys, const size_t key_count,
+	const Key& key, const uint64_t key_prefix,
+	size_t& cached_index, StringType& cached_key_ptr ) noexcept
+{
+	// Try member, found last time. For objects with same keys (records in arrays) it will be same.
+	if( cached_index < key_count )
+	{
+		const StringType cached_index_key= keys[cached_index];
+		// Interned keys of objects in one document have same pointers, so, comparison of pointers is almost enough.
+		// But storage of freed document may be reused by other document, so, check also prefix and length.
+		if( cached_index_key == cached_key_ptr && HasPrefixAndLength( cached_index_key, key_prefix, key.GetLength() ) )
+			return cached_index;
+		if( key.IsEqual( cached_index_key ) )
+		{
+			cached_key_ptr= cached_index_key;
+			return cached_index;
+		}
+	}
+
+	size_t start= 0u;
+	size_t end= key_count;
+	while( start < end )
+	{
+		const size_t middle= start + ( end - start ) / 2u;
+		const int comp= key.Compare( keys[middle] );
 		if( comp < 0 )
 			end= middle;
 		else if( comp > 0 )
 			start= middle + 1u;
 		else
-			return middle->value;
+		{
+			cached_index= middle;
+			cached_key_ptr= keys[middle];
+			return middle;
+		}
+	}
+
+	return key_count;
+}
+
+const ValueBase* Value::SearchObject( const ObjectValue& object, const StringType& key ) const noexcept
+{
+	size_t index;
+	if( object.layout == ObjectValue::Layout::Shaped )
+	{
+		index= SearchKey( object.GetShape()->GetKeys(), object.object_count, key );
+		if( index < object.object_count )
+			return object.GetShapedValues()[index];
+	}
+	else
+	{
+		index= SearchKey( EntriesKeys{ object.GetEntries() }, object.object_count, key );
+		if( index < object.object_count )
+			return object.GetEntries()[index].value;
 	}
+	return nullptr;
+}
 
+const ValueBase* Value::SearchObject( const ObjectValue& object, const StringView& key ) const noexcept
+{
+	size_t index;
+	if( object.layout == ObjectValue::Layout::Shaped )
+	{
+		index= SearchKey( object.GetShape()->GetKeys(), object.object_count, key );
+		if( index < object.object_count )
+			return object.GetShapedValues()[index];
+	}
+	else
+	{
+		index= SearchKey( EntriesKeys{ object.GetEntries() }, object.object_count, key );
+		if( index < object.object_count )
+			return object.GetEntries()[index].value;
+	}
+	return nullptr;
+}
+
+const ValueBase* Value::SearchObject( const ObjectValue& object, const Key& key ) const noexcept
+{
+	size_t index;
+	if( object.layout == ObjectValue::Layout::Shaped )
+	{
+		index= SearchKey( object.GetShape()->GetKeys(), object.object_count, key, key.prefix_, key.cached_index_, key.cached_key_ptr_ );
+		if( index < object.object_count )
+			return object.GetShapedValues()[index];
+	}
+	else
+	{
+		index= SearchKey( EntriesKeys{ object.GetEntries() }, object.object_count, key, key.prefix_, key.cached_index_, key.cached_key_ptr_ );
+		if( index < object.object_count )
+			return object.GetEntries()[index].value;
+	}
 	return nullptr;
 }
 
 double Value::AsDouble() const noexcept
 {
+	if( value_ == &inline_double_number_ )
+		return inline_number_.double_value;
+	if( value_ == &inline_int_number_ )
+		return static_cast<double>(inline_number_.int_value);
 	if( value_->type == ValueBase::Type::Number )
-		return static_cast<const NumberValue&>(*value_).double_value;
+		return static_cast<const NumberValue&>(*value_).GetDouble();
 	if( value_->type == ValueBase::Type::Bool )
 		return static_cast<const BoolValue&>(*value_).value ? 1.0 : 0.0;
 	return 0.0;
@@ -273,8 +618,12 @@ float Value::AsFloat() const noexcept
 
 int64_t Value::AsInt64() const noexcept
 {
+	if( value_ == &inline_double_number_ )
+		return NumberValue::IntFromDouble( inline_number_.double_value );
+	if( value_ == &inline_int_number_ )
+		return inline_number_.int_value;
 	if( value_->type == ValueBase::Type::Number )
-		return static_cast<const NumberValue&>(*value_).int_value;
+		return static_cast<const NumberValue&>(*value_).GetInt64();
 	if( value_->type == ValueBase::Type::Bool )
 		return static_cast<const BoolValue&>(*value_).value ? 1 : 0;
 	return 0;
@@ -295,6 +644,123 @@ uint32_t Value::AsUint() const noexcept
 	return static_cast<uint32_t>(AsInt64());
 }
 
+// Converts number like As* methods do it.
+template<class T> static T ConvertNumber( int64_t int_value, double double_value ) noexcept;
+template<> float ConvertNumber<float>( const int64_t int_value, const double double_value ) noexcept
+{
+	(void)int_value;
+	return static_cast<float>(double_value);
+}
+template<> double ConvertNumber<double>( const int64_t int_value, const double double_value ) noexcept
+{
+	(void)int_value;
+	return double_value;
+}
+template<> int32_t ConvertNumber<int32_t>( const int64_t int_value, const double double_value ) noexcept
+{
+	(void)double_value;
+	return static_cast<int32_t>(int_value);
+}
+template<> int64_t ConvertNumber<int64_t>( const int64_t int_value, const double double_value ) noexcept
+{
+	(void)double_value;
+	return int_value;
+}
+
+template<class T>
+static NumbersExtractionResult ExtractNumbersImpl( const ValueBase& value, T* const dst, const size_t dst_size ) noexcept
+{
+	NumbersExtractionResult result{ 0u, 0u, 0u };
+	if( value.type != ValueBase::Type::Array )
+		return result;
+
+	const ArrayValue& array_value= static_cast<const ArrayValue&>(value);
+	const size_t count= std::min( static_cast<size_t>(array_value.object_count), dst_size );
+	result.count= count;
+	result.first_non_number_index= count;
+
+	// Simple loops for packed arrays, compiler can vectorize them.
+	switch( array_value.layout )
+	{
+	case ArrayValue::Layout::PackedDoubles:
+		{
+			const double* const src= array_value.GetPackedDoubles();
+			if( std::is_same<T, double>::value )
+				std::memcpy( dst, src, sizeof(double) * count );
+			else if( std::is_floating_point<T>::value )
+				for( size_t i= 0u; i < count; i++ )
+					dst[i]= static_cast<T>( src[i] );
+			else
+				for( size_t i= 0u; i < count; i++ )
+					dst[i]= static_cast<T>( NumberValue::IntFromDouble( src[i] ) );
+		}
+		return result;
+
+	case ArrayValue::Layout::PackedInt64s:
+		{
+			const int64_t* const src= array_value.GetPackedInt64s();
+			if( std::is_same<T, int64_t>::value )
+				std::memcpy( dst, src, sizeof(int64_t) * count );
+			else
+				for( size_t i= 0u; i < count; i++ )
+					dst[i]= static_cast<T>( src[i] );
+		}
+		return result;
+
+	case ArrayValue::Layout::Elements:
+		break;
+	};
+
+	const ValueBase* const* const elements= array_value.GetElements();
+	for( size_t i= 0u; i < count; i++ )
+	{
+		if( IsInlineNumber( elements[i] ) )
+		{
+			const int64_t number= GetInlineNumber( elements[i] );
+			dst[i]= ConvertNumber<T>( number, static_cast<double>(number) );
+			continue;
+		}
+
+		const ValueBase& element= *elements[i];
+		if( element.type == ValueBase::Type::Number )
+		{
+			const NumberValue& number= static_cast<const NumberValue&>(element);
+			dst[i]= ConvertNumber<T>( number.GetInt64(), number.GetDouble() );
+		}
+		else
+		{
+			const bool bool_value= element.type == ValueBase::Type::Bool && static_cast<const BoolValue&>(element).value;
+			dst[i]= static_cast<T>( bool_value ? 1 : 0 );
+
+			if( result.non_number_count == 0u )
+				result.first_non_number_index= i;
+			++result.non_number_count;
+		}
+	}
+
+	return result;
+}
+
+NumbersExtractionResult Value::ExtractNumbers( float* const dst, const size_t dst_size ) const noexcept
+{
+	return ExtractNumbersImpl( *value_, dst, dst_size );
+}
+
+NumbersExtractionResult Value::ExtractNumbers( double* const dst, const size_t dst_size ) const noexcept
+{
+	return ExtractNumbersImpl( *value_, dst, dst_size );
+}
+
+NumbersExtractionResult Value::ExtractNumbers( int32_t* const dst, const size_t dst_size ) const noexcept
+{
+	return ExtractNumbersImpl( *value_, dst, dst_size );
+}
+
+NumbersExtractionResult Value::ExtractNumbers( int64_t* const dst, const size_t dst_size ) const noexcept
+{
+	return ExtractNumbersImpl( *value_, dst, dst_size );
+}
+
 StringType Value::AsString() const noexcept
 {
 	switch(value_->type)
@@ -316,9 +782,16 @@ StringType Value::AsString() const noexcept
 	return "";
 }
 
+StringView Value::AsStringView() const noexcept
+{
+	if( value_->type == ValueBase::Type::String )
+		return static_cast<const StringValue&>(*value_).GetStringView();
+	return StringView( AsString() );
+}
+
 bool Value::operator==( const Value& other ) const noexcept
 {
-	return ValuesAreEqual_r( *value_, *other.value_ );
+	return ValuesAreEqual_r( *this, other );
 }
 
 bool Value::operator!=( const Value& other ) const noexcept
@@ -330,18 +803,45 @@ Value::UniversalIterator Value::begin() const noexcept
 {
 	UniversalIterator::Ptr ptr;
 	ptr.array_value= nullptr;
-	ValueBase::Type type= ValueBase::Type::Array;
+	UniversalIterator::Kind kind= UniversalIterator::Kind::ArrayElements;
 
 	switch(value_->type)
 	{
 	case ValueBase::Type::Object:
-		ptr.object_entry= static_cast<const ObjectValue&>(*value_).GetEntries();
-		type= ValueBase::Type::Object;
+		{
+			const ObjectValue& object_value= static_cast<const ObjectValue&>(*value_);
+			if( object_value.layout == ObjectValue::Layout::Shaped )
+			{
+				ptr.array_value= object_value.GetShapedValues();
+				kind= UniversalIterator::Kind::ArrayElements;
+			}
+			else
+			{
+				ptr.object_entry= object_value.GetEntries();
+				kind= UniversalIterator::Kind::ObjectEntries;
+			}
+		}
 		break;
 
 	case ValueBase::Type::Array:
-		ptr.array_value= static_cast<const ArrayValue&>(*value_).GetElements();
-		type= ValueBase::Type::Array;
+		{
+			const ArrayValue& array_value= static_cast<const ArrayValue&>(*value_);
+			switch( array_value.layout )
+			{
+			case ArrayValue::Layout::Elements:
+				ptr.array_value= array_value.GetElements();
+				kind= UniversalIterator::Kind::ArrayElements;
+				break;
+			case ArrayValue::Layout::PackedDoubles:
+				ptr.packed_double= array_value.GetPackedDoubles();
+				kind= UniversalIterator::Kind::PackedDoubles;
+				break;
+			case ArrayValue::Layout::PackedInt64s:
+				ptr.packed_int= array_value.GetPackedInt64s();
+				kind= UniversalIterator::Kind::PackedInt64s;
+				break;
+			};
+		}
 		break;
 
 	case ValueBase::Type::Null:
@@ -351,49 +851,53 @@ Value::UniversalIterator Value::begin() const noexcept
 		break;
 	};
 
-	return UniversalIterator( type, ptr );
+	return UniversalIterator( kind, ptr );
 }
 
 Value::UniversalIterator Value::end() const noexcept
 {
-	UniversalIterator::Ptr ptr;
-	ptr.array_value= nullptr;
-	ValueBase::Type type= ValueBase::Type::Array;
+	UniversalIterator result= begin();
+	UniversalIterator::Ptr& ptr= result.ptr_;
 
-	switch(value_->type)
+	// All iterators of containers are random-access, so, just shift begin pointer.
+	const size_t count= ElementCount();
+	switch( result.kind_ )
 	{
-	case ValueBase::Type::Object:
-		{
-			const ObjectValue& object_value= static_cast<const ObjectValue&>(*value_);
-			ptr.object_entry= object_value.GetEntries() + object_value.object_count;
-			type= ValueBase::Type::Object;
-		}
-		break;
+	case UniversalIterator::Kind::ArrayElements: ptr.array_value+= count; break;
+	case UniversalIterator::Kind::PackedDoubles: ptr.packed_double+= count; break;
+	case UniversalIterator::Kind::PackedInt64s: ptr.packed_int+= count; break;
+	case UniversalIterator::Kind::ObjectEntries: ptr.object_entry+= count; break;
+	};
 
-	case ValueBase::Type::Array:
-		{
-			const ArrayValue& array_value= static_cast<const ArrayValue&>(*value_);
-			ptr.array_value= array_value.GetElements() + array_value.object_count;
-			type= ValueBase::Type::Array;
-		}
-		break;
+	return result;
+}
 
-	case ValueBase::Type::Null:
-	case ValueBase::Type::String:
-	case ValueBase::Type::Number:
-	case ValueBase::Type::Bool:
-		break;
-	};
+static const void* GetArrayData( const ArrayValue& array_value ) noexcept
+{
+	// Storage of all layouts placed just after array.
+	return &array_value + 1u;
+}
 
-	return UniversalIterator( type, ptr );
+static size_t GetArrayElementSize( const ArrayValue& array_value ) noexcept
+{
+	switch( array_value.layout )
+	{
+	case ArrayValue::Layout::Elements: return sizeof(const ValueBase*);
+	case ArrayValue::Layout::PackedDoubles: return sizeof(double);
+	case ArrayValue::Layout::PackedInt64s: return sizeof(int64_t);
+	};
+	return 0u;
 }
 
 Value::ArrayIterator Value::array_begin() const noexcept
 {
 	if( value_->type == ValueBase::Type::Array )
-		return ArrayIterator( static_cast<const ArrayValue&>(*value_).GetElements() );
+	{
+		const ArrayValue& array_value= static_cast<const ArrayValue&>(*value_);
+		return ArrayIterator( array_value.layout, GetArrayData( array_value ) );
+	}
 	else
-		return ArrayIterator( nullptr );
+		return ArrayIterator( ArrayValue::Layout::Elements, nullptr );
 }
 
 Value::ArrayIterator Value::array_end() const noexcept
@@ -401,16 +905,24 @@ Value::ArrayIterator Value::array_end() const noexcept
 	if( value_->type == ValueBase::Type::Array )
 	{
 		const ArrayValue& array_value= static_cast<const ArrayValue&>(*value_);
-		return ArrayIterator( array_value.GetElements() + array_value.object_count );
+		return
+			ArrayIterator(
+				array_value.layout,
+				static_cast<const unsigned char*>( GetArrayData( array_value ) ) + GetArrayElementSize( array_value ) * array_value.object_count );
 	}
 	else
-		return ArrayIterator( nullptr );
+		return ArrayIterator( ArrayValue::Layout::Elements, nullptr );
 }
 
 Value::ObjectIterator Value::object_begin() const noexcept
 {
 	if( value_->type == ValueBase::Type::Object )
-		return ObjectIterator( static_cast<const ObjectValue&>(*value_).GetEntries() );
+	{
+		const ObjectValue& object_value= static_cast<const ObjectValue&>(*value_);
+		if( object_value.layout == ObjectValue::Layout::Shaped )
+			return ObjectIterator( object_value.GetShape()->GetKeys(), object_value.GetShapedValues() );
+		return ObjectIterator( object_value.GetEntries() );
+	}
 	else
 		return ObjectIterator( nullptr );
 }
@@ -420,6 +932,11 @@ Value::ObjectIterator Value::object_end() const noexcept
 	if( value_->type == ValueBase::Type::Object )
 	{
 		const ObjectValue& object_value= static_cast<const ObjectValue&>(*value_);
+		if( object_value.layout == ObjectValue::Layout::Shaped )
+			return
+				ObjectIterator(
+					object_value.GetShape()->GetKeys() + object_value.object_count,
+					object_value.GetShapedValues() + object_value.object_count );
 		return ObjectIterator( object_value.GetEntries() + object_value.object_count );
 	}
 	else
@@ -0,0 +1,262 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include "../include/PanzerJson/cbor_serializer.hpp"
+#include "../include/PanzerJson/parser.hpp"
+#include "../include/PanzerJson/serializer.hpp"
+#include "tests.hpp"
+
+using namespace PanzerJson;
+
+static std::string Serialize( const Value value )
+{
+	OutputBuffer out;
+	Serializer().Serialize( value, out );
+	return std::string( out.GetData(), out.GetSize() );
+}
+
+static std::string ToCbor( const Value value )
+{
+	OutputBuffer out;
+	CborSerializer().Serialize( value, out );
+	return std::string( out.GetData(), out.GetSize() );
+}
+
+static std::string FromHex( const char* hex )
+{
+	std::string result;
+	for( ; hex[0] != '\0' && hex[1] != '\0'; hex+= 2 )
+		result.push_back( char( std::stoi( std::string( hex, 2u ), nullptr, 16 ) ) );
+	return result;
+}
+
+static Parser::ResultPtr ParseCbor( const std::string& data )
+{
+	Parser parser;
+	parser.SetEnableNoncompositeJsonRoot( true );
+	return parser.ParseCbor( data.data(), data.size() );
+}
+
+static void CborRoundTripTest()
+{
+	static const char json_text[]=
+	u8R"(
+		{
+			"records" : [ { "id" : 1, "name" : "a\nb" }, { "id" : 2, "name" : "c" }, { "id" : 3000000000, "name" : "\u0000" } ],
+			"packed" : [ 1, -2, 3 ],
+			"doubles" : [ 0.5, 1e300, -0.1, 65504, 100000.5 ],
+			"big" : [ 18446744073709551615, -9223372036854775808, 4294967296 ],
+			"mixed" : [ null, true, false, 17, -2.5, "s", [], {} ],
+			"escaped" : "x\tyü"
+		}
+	)";
+
+	for( const bool shapes : { false, true } )
+	for( const bool lazy : { false, true } )
+	{
+		Parser parser;
+		parser.SetShareObjectShapes( shapes );
+		parser.SetInternKeys( shapes );
+		parser.SetLazyNumbers( lazy );
+		parser.SetLazyStringsUnescaping( lazy );
+		const Parser::ResultPtr result= parser.Parse( json_text );
+		test_assert( result->error == Parser::Result::Error::NoError );
+
+		const std::string cbor= ToCbor( result->root );
+		const Parser::ResultPtr cbor_result= parser.ParseCbor( cbor.data(), cbor.size() );
+		test_assert( cbor_result->error == Parser::Result::Error::NoError );
+		test_assert( cbor_result->root == result->root );
+		test_assert( ToCbor( cbor_result->root ) == cbor );
+		if( !lazy )
+			test_assert( Serialize( cbor_result->root ) == Serialize( result->root ) );
+
+		test_assert( cbor_result->root["big"][0u].AsUint64() == std::numeric_limits<uint64_t>::max() );
+		test_assert( cbor_result->root["big"][1u].AsInt64() == std::numeric_limits<int64_t>::min() );
+		test_assert( cbor_result->root["records"][2u]["name"].AsStringView().size == 1u );
+	}
+}
+
+static void CborDecodeTest()
+{
+	// Examples from RFC 8949, appendix A.
+	const struct
+	{
+		const char* cbor_hex;
+		const char* json;
+	} examples[]=
+	{
+		{ "00", "0" },
+		{ "17", "23" },
+		{ "1818", "24" },
+		{ "1903e8", "1000" },
+		{ "1a000f4240", "1000000" },
+		{ "1b000000e8d4a51000", "1000000000000" },
+		{ "1bffffffffffffffff", "18446744073709551615" },
+		{ "20", "-1" },
+		{ "3903e7", "-1000" },
+		{ "f90000", "0" },
+		{ "f93c00", "1" },
+		{ "fb3ff199999999999a", "1.1" },
+		{ "f93e00", "1.5" },
+		{ "f97bff", "65504" },
+		{ "fa47c35000", "100000" },
+		{ "f9c400", "-4" },
+		{ "f4", "false" },
+		{ "f5", "true" },
+		{ "f6", "null" },
+		{ "f7", "null" },
+		{ "c074323031332d30332d32315432303a30343a30305a", "\"2013-03-21T20:04:00Z\"" },
+		{ "60", "\"\"" },
+		{ "6161", "\"a\"" },
+		{ "62c3bc", u8"\"ü\"" },
+		{ "80", "[]" },
+		{ "83010203", "[1,2,3]" },
+		{ "8301820203820405", "[1,[2,3],[4,5]]" },
+		{ "a0", "{}" },
+		{ "a26161016162820203", R"({"a":1,"b":[2,3]})" },
+		{ "826161a161626163", R"(["a",{"b":"c"}])" },
+		{ "7f657374726561646d696e67ff", "\"streaming\"" },
+		{ "9fff", "[]" },
+		{ "9f018202039f0405ffff", "[1,[2,3],[4,5]]" },
+		{ "83018202039f0405ff", "[1,[2,3],[4,5]]" },
+		{ "bf61610161629f0203ffff", R"({"a":1,"b":[2,3]})" },
+		{ "bf6346756ef563416d7421ff", R"({"Amt":-2,"Fun":true})" },
+	};
+
+	for( const auto& example : examples )
+	{
+		const Parser::ResultPtr result= ParseCbor( FromHex( example.cbor_hex ) );
+		test_assert( result->error == Parser::Result::Error::NoError );
+		const Parser::ResultPtr json_result= Parser().Parse( ( "[" + std::string( example.json ) + "]" ).c_str() );
+		test_assert( json_result->error == Parser::Result::Error::NoError );
+		test_assert( result->root == json_result->root[0u] );
+	}
+
+	// Negative values out of int64 range are converted to doubles.
+	const Parser::ResultPtr big_negative= ParseCbor( FromHex( "3bffffffffffffffff" ) );
+	test_assert( big_negative->error == Parser::Result::Error::NoError );
+	test_assert( big_negative->root.AsDouble() == -18446744073709551616.0 );
+
+	// Special floats.
+	const Parser::ResultPtr infinity= ParseCbor( FromHex( "f9fc00" ) );
+	test_assert( infinity->root.AsDouble() == -std::numeric_limits<double>::infinity() );
+	const Parser::ResultPtr nan= ParseCbor( FromHex( "f97e00" ) );
+	test_assert( std::isnan( nan->root.AsDouble() ) );
+	const Parser::ResultPtr subnormal= ParseCbor( FromHex( "f90001" ) );
+	test_assert( subnormal->root.AsDouble() == 5.960464477539063e-8 );
+}
+
+static void CborEncodeTest()
+{
+	// Examples from RFC 8949, appendix A.
+	const struct
+	{
+		const char* json;
+		const char* cbor_hex;
+	} examples[]=
+	{
+		{ "0", "00" },
+		{ "23", "17" },
+		{ "24", "1818" },
+		{ "100", "1864" },
+		{ "1000", "1903e8" },
+		{ "1000000", "1a000f4240" },
+		{ "1000000000000", "1b000000e8d4a51000" },
+		{ "-1", "20" },
+		{ "-100", "3863" },
+		{ "-1000", "3903e7" },
+		{ "0.0", "00" }, // Parser stores exact integers as integers.
+		{ "-0.0", "f98000" },
+		{ "1.5", "f93e00" },
+		{ "1.1", "fb3ff199999999999a" },
+		{ "6.103515625e-05", "f90400" },
+		{ "-65504.5", "fac77fe080" },
+		{ "100000.5", "fa47c35040" },
+		{ "1099511627776.5", "fb4270000000000800" },
+		{ "-4.1", "fbc010666666666666" },
+		{ "false", "f4" },
+		{ "true", "f5" },
+		{ "null", "f6" },
+		{ "\"\"", "60" },
+		{ "\"IETF\"", "6449455446" },
+		{ "\"\\\"\\\\\"", "62225c" },
+		{ "[]", "80" },
+		{ "[1,[2,3],[4,5]]", "8301820203820405" },
+		{ "{}", "a0" },
+		{ R"({"a":1,"b":[2,3]})", "a26161016162820203" },
+		{ R"(["a",{"b":"c"}])", "826161a161626163" },
+	};
+
+	for( const auto& example : examples )
+	{
+		Parser parser;
+		parser.SetEnableNoncompositeJsonRoot( true );
+		const Parser::ResultPtr result= parser.Parse( example.json );
+		test_assert( result->error == Parser::Result::Error::NoError );
+		test_assert( ToCbor( result->root ) == FromHex( example.cbor_hex ) );
+
+		// Array elements may be inline or packed numbers.
+		const Parser::ResultPtr array_result= parser.Parse( ( "[" + std::string( example.json ) + "]" ).c_str() );
+		test_assert( ToCbor( array_result->root ) == "\x81" + FromHex( example.cbor_hex ) );
+	}
+
+	Parser parser;
+	parser.SetEnableNoncompositeJsonRoot( true );
+	test_assert( ToCbor( parser.Parse( "18446744073709551615" )->root ) == FromHex( "1bffffffffffffffff" ) );
+
+	// Array with 25 elements has 1-byte length argument.
+	std::string json_text= "[";
+	for( size_t i= 0u; i < 25u; ++i )
+		json_text+= ( i == 0u ? "" : "," ) + std::to_string(i);
+	json_text+= "]";
+	const std::string cbor= ToCbor( Parser().Parse( json_text.c_str() )->root );
+	test_assert( cbor.size() == 2u + 24u + 2u );
+	test_assert( cbor.substr( 0u, 2u ) == FromHex( "9819" ) );
+}
+
+static void CborErrorsTest()
+{
+	const struct
+	{
+		const char* cbor_hex;
+		Parser::Result::Error error;
+		size_t error_pos;
+	} examples[]=
+	{
+		{ "", Parser::Result::Error::EmptyInput, 0u },
+		{ "19", Parser::Result::Error::UnexpectedEndOfFile, 1u },
+		{ "8301", Parser::Result::Error::UnexpectedEndOfFile, 2u },
+		{ "6261", Parser::Result::Error::UnexpectedEndOfFile, 1u },
+		{ "0000", Parser::Result::Error::ExtraCharactersAfterJsonRoot, 1u },
+		{ "4161", Parser::Result::Error::UnexpectedLexem, 0u }, // Byte string.
+		{ "1c", Parser::Result::Error::UnexpectedLexem, 0u }, // Reserved additional info.
+		{ "ff", Parser::Result::Error::UnexpectedLexem, 0u }, // Break outside indefinite item.
+		{ "a10101", Parser::Result::Error::UnexpectedLexem, 1u }, // Not text key.
+		{ "f0", Parser::Result::Error::UnexpectedLexem, 0u }, // Unassigned simple value.
+		{ "7f6161", Parser::Result::Error::UnexpectedEndOfFile, 3u },
+		{ "7f01ff", Parser::Result::Error::UnexpectedLexem, 1u }, // Not text chunk in indefinite string.
+	};
+
+	for( const auto& example : examples )
+	{
+		const Parser::ResultPtr result= ParseCbor( FromHex( example.cbor_hex ) );
+		test_assert( result->error == example.error );
+		test_assert( result->error_pos == example.error_pos );
+	}
+
+	// Noncomposite root may be disabled.
+	Parser parser;
+	parser.SetEnableNoncompositeJsonRoot( false );
+	const std::string number= FromHex( "01" );
+	const Parser::ResultPtr result= parser.ParseCbor( number.data(), number.size() );
+	test_assert( result->error == Parser::Result::Error::RootIsNotObjectOrArray );
+}
+
+void RunCborTests()
+{
+	CborRoundTripTest();
+	CborDecodeTest();
+	CborEncodeTest();
+	CborErrorsTest();
+}
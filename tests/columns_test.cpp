@@ -0,0 +1,135 @@
+#include <cstring>
+#include <string>
+#include "../include/PanzerJson/columns.hpp"
+#include "../include/PanzerJson/parser.hpp"
+#include "tests.hpp"
+
+using namespace PanzerJson;
+
+static void SimpleColumnsTest()
+{
+	static const char json_text[]=
+	u8R"(
+		[
+			{ "id" : 1, "price" : 2.5, "name" : "apple" },
+			{ "id" : 2, "price" : -1.25, "name" : "banana" },
+			{ "id" : 3, "name" : 42 },
+			"not an object",
+			{ "price" : 100, "name" : "cherry", "other" : null }
+		]
+	)";
+
+	const Parser::ResultPtr result= Parser().Parse( json_text );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	const ColumnDescription descriptions[]
+	{
+		{ "id", ColumnType::Int64 },
+		{ "price", ColumnType::Double },
+		{ "name", ColumnType::String },
+		{ "nonexistent", ColumnType::Double },
+	};
+	const std::vector<Column> columns= ExtractColumns( result->root, descriptions, 4u );
+	test_assert( columns.size() == 4u );
+
+	const Column& id= columns[0];
+	test_assert( id.GetType() == ColumnType::Int64 );
+	test_assert( id.GetSize() == 5u );
+	test_assert( id.GetDoubles() == nullptr && id.GetInts() != nullptr );
+	test_assert( id.GetInts()[0] == 1 && id.GetInts()[1] == 2 && id.GetInts()[2] == 3 );
+	test_assert( id.IsValid(2u) && !id.IsValid(3u) && !id.IsValid(4u) );
+	test_assert( id.GetValidCount() == 3u );
+	test_assert( id.GetValidityBitmap()[0] == 7u );
+
+	const Column& price= columns[1];
+	test_assert( price.GetDoubles()[0] == 2.5 && price.GetDoubles()[1] == -1.25 && price.GetDoubles()[4] == 100.0 );
+	test_assert( !price.IsValid(2u) && price.GetDoubles()[2] == 0.0 );
+
+	const Column& name= columns[2];
+	test_assert( std::strcmp( name.GetStrings()[1], "banana" ) == 0 );
+	test_assert( std::strcmp( name.GetStrings()[4], "cherry" ) == 0 );
+	test_assert( !name.IsValid(2u) && std::strcmp( name.GetStrings()[2], "" ) == 0 );
+
+	test_assert( columns[3].GetValidCount() == 0u );
+
+	const ColumnAggregates<int64_t> id_aggregates= AggregateInts( id );
+	test_assert( id_aggregates.count == 3u && id_aggregates.sum == 6 && id_aggregates.min == 1 && id_aggregates.max == 3 );
+
+	const ColumnAggregates<double> price_aggregates= AggregateDoubles( price );
+	test_assert( price_aggregates.count == 3u );
+	test_assert( price_aggregates.sum == 101.25 && price_aggregates.min == -1.25 && price_aggregates.max == 100.0 );
+
+	// Aggregation of column with wrong type.
+	test_assert( AggregateDoubles( id ).count == 0u );
+
+	// Aggregation of column without valid values.
+	const ColumnAggregates<double> empty_aggregates= AggregateDoubles( columns[3] );
+	test_assert( empty_aggregates.count == 0u && empty_aggregates.min == 0.0 && empty_aggregates.max == 0.0 );
+
+	// Not an array.
+	test_assert( ExtractColumns( result->root[0u], descriptions, 4u )[0].GetSize() == 0u );
+}
+
+static void ParallelColumnsTest()
+{
+	// Big array, with some invalid rows.
+	const unsigned int row_count= 10000u;
+	std::string json_text= "[";
+	for( unsigned int i= 0u; i < row_count; i++ )
+	{
+		if( i > 0u )
+			json_text+= ",";
+		if( i % 7u == 3u )
+			json_text+= "{ \"b\" : 1 }";
+		else
+			json_text+= "{ \"a\" : " + std::to_string( int(i) - 5000 ) + ", \"b\" : " + std::to_string(i) + ".5 }";
+	}
+	json_text+= "]";
+
+	const Parser::ResultPtr result= Parser().Parse( json_text.data(), json_text.size() );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	const ColumnDescription descriptions[]
+	{
+		{ "a", ColumnType::Int64 },
+		{ "b", ColumnType::Double },
+	};
+	const std::vector<Column> columns_single= ExtractColumns( result->root, descriptions, 2u, 1u );
+	const std::vector<Column> columns_parallel= ExtractColumns( result->root, descriptions, 2u, 4u );
+
+	int64_t expected_sum= 0, expected_max= 0;
+	size_t expected_count= 0u;
+	for( unsigned int i= 0u; i < row_count; i++ )
+	{
+		if( i % 7u != 3u )
+		{
+			expected_sum+= int(i) - 5000;
+			expected_max= int(i) - 5000;
+			++expected_count;
+		}
+	}
+
+	for( const std::vector<Column>* const columns : { &columns_single, &columns_parallel } )
+	{
+		const ColumnAggregates<int64_t> a= AggregateInts( (*columns)[0] );
+		test_assert( a.count == expected_count );
+		test_assert( a.sum == expected_sum );
+		test_assert( a.min == -5000 && a.max == expected_max );
+
+		const ColumnAggregates<double> b= AggregateDoubles( (*columns)[1] );
+		test_assert( b.count == row_count );
+		test_assert( b.min == 0.5 && b.max == double(row_count) - 1.5 ); // Last row is invalid for "a" and have "b" = 1.
+
+		test_assert(
+			std::memcmp(
+				(*columns)[0].GetValidityBitmap(),
+				columns_single[0].GetValidityBitmap(),
+				sizeof(uint64_t) * ( ( row_count + 63u ) / 64u ) ) == 0 );
+	}
+}
+
+void RunColumnsTests()
+{
+	SimpleColumnsTest();
+	ParallelColumnsTest();
+}
@@ -66,12 +66,14 @@ static constexpr ArrayValueWithElementsStorage<1u> simple_array_storage2
 	{ &simple_null_value }
 };
 
-static constexpr NumberValueWithStringStorage<3u> number_storage
+static constexpr NumberValueWithStringStorage<5u> number_storage
 {
-	NumberValue( 42, 42.1, true ),
-	"42"
+	NumberValue::FromDouble( 42.1, true ),
+	"42.1"
 };
 
+static_assert( number_storage.value.kind == NumberValue::Kind::Double && number_storage.value.payload.double_value == 42.1, "Wrong number" );
+
 }
 
 } // namespace PanzerJson
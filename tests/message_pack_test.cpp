@@ -0,0 +1,264 @@
+#include <cmath>
+#include <limits>
+#include <string>
+#include "../include/PanzerJson/message_pack_serializer.hpp"
+#include "../include/PanzerJson/parser.hpp"
+#include "../include/PanzerJson/serializer.hpp"
+#include "tests.hpp"
+
+using namespace PanzerJson;
+
+static std::string Serialize( const Value value )
+{
+	OutputBuffer out;
+	Serializer().Serialize( value, out );
+	return std::string( out.GetData(), out.GetSize() );
+}
+
+static std::string ToMessagePack( const Value value )
+{
+	OutputBuffer out;
+	MessagePackSerializer( out ).AddValue( value );
+	return std::string( out.GetData(), out.GetSize() );
+}
+
+static std::string FromHex( const char* hex )
+{
+	std::string result;
+	for( ; hex[0] != '\0' && hex[1] != '\0'; hex+= 2 )
+		result.push_back( char( std::stoi( std::string( hex, 2u ), nullptr, 16 ) ) );
+	return result;
+}
+
+static Parser::ResultPtr ParseMessagePack( const std::string& data )
+{
+	return Parser().ParseMessagePack( data.data(), data.size() );
+}
+
+static void MessagePackRoundTripTest()
+{
+	std::string long_string( 70000u, 'x' );
+	std::string json_text=
+	u8R"(
+		{
+			"records" : [ { "id" : 1, "name" : "a\nb" }, { "id" : 2, "name" : "c" }, { "id" : 3000000000, "name" : "\u0000" } ],
+			"packed" : [ 1, -2, 3, -200, 40000, -40000, 5000000000, -5000000000 ],
+			"doubles" : [ 0.5, 1e300, -0.1, 65504.5 ],
+			"big" : [ 18446744073709551615, -9223372036854775808, 4294967296 ],
+			"mixed" : [ null, true, false, 17, -2.5, "s", [], {}, [0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16] ],
+			"escaped" : "x\tyü",
+			"long_string" : ")" + long_string + R"(",
+			"medium_string" : "0123456789012345678901234567890123456789"
+		}
+	)";
+
+	for( const bool shapes : { false, true } )
+	for( const bool lazy : { false, true } )
+	{
+		Parser parser;
+		parser.SetShareObjectShapes( shapes );
+		parser.SetInternKeys( shapes );
+		parser.SetLazyNumbers( lazy );
+		parser.SetLazyStringsUnescaping( lazy );
+		const Parser::ResultPtr result= parser.Parse( json_text.data(), json_text.size() );
+		test_assert( result->error == Parser::Result::Error::NoError );
+
+		const std::string message_pack= ToMessagePack( result->root );
+		const Parser::ResultPtr message_pack_result= parser.ParseMessagePack( message_pack.data(), message_pack.size() );
+		test_assert( message_pack_result->error == Parser::Result::Error::NoError );
+		test_assert( message_pack_result->root == result->root );
+		test_assert( ToMessagePack( message_pack_result->root ) == message_pack );
+		if( !lazy )
+			test_assert( Serialize( message_pack_result->root ) == Serialize( result->root ) );
+
+		test_assert( message_pack_result->root["big"][0u].AsUint64() == std::numeric_limits<uint64_t>::max() );
+		test_assert( message_pack_result->root["big"][1u].AsInt64() == std::numeric_limits<int64_t>::min() );
+		test_assert( message_pack_result->root["records"][2u]["name"].AsStringView().size == 1u );
+		test_assert( message_pack_result->root["long_string"].AsStringView().size == long_string.size() );
+	}
+}
+
+static void MessagePackDecodeTest()
+{
+	const struct
+	{
+		const char* message_pack_hex;
+		const char* json;
+	} examples[]=
+	{
+		{ "00", "0" },
+		{ "7f", "127" },
+		{ "ff", "-1" },
+		{ "e0", "-32" },
+		{ "cc80", "128" },
+		{ "cd0100", "256" },
+		{ "ce00010000", "65536" },
+		{ "cf0000000100000000", "4294967296" },
+		{ "cfffffffffffffffff", "18446744073709551615" },
+		{ "d0df", "-33" },
+		{ "d1ff7f", "-129" },
+		{ "d2ffff7fff", "-32769" },
+		{ "d38000000000000000", "-9223372036854775808" },
+		{ "ca3fc00000", "1.5" },
+		{ "cb3ff199999999999a", "1.1" },
+		{ "c0", "null" },
+		{ "c2", "false" },
+		{ "c3", "true" },
+		{ "a0", "\"\"" },
+		{ "a3616263", "\"abc\"" },
+		{ "d903616263", "\"abc\"" },
+		{ "da0003616263", "\"abc\"" },
+		{ "db00000003616263", "\"abc\"" },
+		{ "a2c3bc", u8"\"ü\"" },
+		{ "90", "[]" },
+		{ "93010203", "[1,2,3]" },
+		{ "dc0002c0c3", "[null,true]" },
+		{ "dd00000001a0", "[\"\"]" },
+		{ "80", "{}" },
+		{ "82a16101a16292c2c3", R"({"a":1,"b":[false,true]})" },
+		{ "de0001a16180", R"({"a":{}})" },
+		{ "df00000001d9016190", R"({"a":[]})" },
+	};
+
+	for( const auto& example : examples )
+	{
+		const Parser::ResultPtr result= ParseMessagePack( FromHex( example.message_pack_hex ) );
+		test_assert( result->error == Parser::Result::Error::NoError );
+		const Parser::ResultPtr json_result= Parser().Parse( ( "[" + std::string( example.json ) + "]" ).c_str() );
+		test_assert( json_result->error == Parser::Result::Error::NoError );
+		test_assert( result->root == json_result->root[0u] );
+	}
+
+	const Parser::ResultPtr nan= ParseMessagePack( FromHex( "ca7fc00000" ) );
+	test_assert( std::isnan( nan->root.AsDouble() ) );
+}
+
+static void MessagePackEncodeTest()
+{
+	const struct
+	{
+		const char* json;
+		const char* message_pack_hex;
+	} examples[]=
+	{
+		{ "0", "00" },
+		{ "127", "7f" },
+		{ "128", "cc80" },
+		{ "256", "cd0100" },
+		{ "65536", "ce00010000" },
+		{ "4294967296", "cf0000000100000000" },
+		{ "-1", "ff" },
+		{ "-32", "e0" },
+		{ "-33", "d0df" },
+		{ "-129", "d1ff7f" },
+		{ "-32769", "d2ffff7fff" },
+		{ "-2147483649", "d3ffffffff7fffffff" },
+		{ "1.5", "ca3fc00000" },
+		{ "1.1", "cb3ff199999999999a" },
+		{ "null", "c0" },
+		{ "false", "c2" },
+		{ "true", "c3" },
+		{ "\"\"", "a0" },
+		{ "\"abc\"", "a3616263" },
+		{ "\"0123456789012345678901234567890123456789\"", "d928" "30313233343536373839" "30313233343536373839" "30313233343536373839" "30313233343536373839" },
+		{ "[]", "90" },
+		{ "[1,[2,3]]", "9201920203" },
+		{ "[0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15]", "dc0010000102030405060708090a0b0c0d0e0f" },
+		{ "{}", "80" },
+		{ R"({"b":[false,true],"a":1})", "82a16101a16292c2c3" },
+	};
+
+	for( const auto& example : examples )
+	{
+		const Parser::ResultPtr result= Parser().Parse( example.json );
+		test_assert( result->error == Parser::Result::Error::NoError );
+		test_assert( ToMessagePack( result->root ) == FromHex( example.message_pack_hex ) );
+	}
+
+	// Build document directly.
+	OutputBuffer out;
+	MessagePackSerializer serializer( out );
+	serializer.AddMap( 3u );
+	serializer.AddString( "one" );
+	serializer.AddNumber( 1 );
+	serializer.AddString( "arr" );
+	serializer.AddArray( 3u );
+	serializer.AddNull();
+	serializer.AddNumber( 0.25 );
+	serializer.AddValue( Parser().Parse( R"({"x":[1,2]})" )->root );
+	serializer.AddString( "str" );
+	serializer.AddString( "s" );
+
+	const Parser::ResultPtr result= Parser().ParseMessagePack( out.GetData(), out.GetSize() );
+	test_assert( result->error == Parser::Result::Error::NoError );
+	test_assert( Serialize( result->root ) == R"({"arr":[null,0.25,{"x":[1,2]}],"one":1,"str":"s"})" );
+
+	// Integer types of any size are accepted.
+	OutputBuffer numbers_out;
+	MessagePackSerializer numbers_serializer( numbers_out );
+	numbers_serializer.AddNumber( 1ll );
+	numbers_serializer.AddNumber( 2ull );
+	numbers_serializer.AddNumber( -3l );
+	numbers_serializer.AddNumber( (unsigned short)(400u) );
+	numbers_serializer.AddNumber( (signed char)(-5) );
+	numbers_serializer.AddNumber( 0.5f );
+	test_assert( std::string( numbers_out.GetData(), numbers_out.GetSize() ) == FromHex( "0102fdcd0190fbca3f000000" ) );
+}
+
+static void MessagePackSizeLimitsTest()
+{
+	if( sizeof(size_t) <= sizeof(uint32_t) )
+		return;
+
+	// Too big strings, arrays and maps are refused, nothing is written.
+	const uint64_t too_big= uint64_t(1u) << 32u;
+	OutputBuffer out;
+	MessagePackSerializer serializer( out );
+	test_assert( !serializer.AddString( StringView( "abc", size_t(too_big) ) ) );
+	test_assert( !serializer.AddArray( size_t(too_big) ) );
+	test_assert( !serializer.AddMap( size_t(too_big) ) );
+	test_assert( out.GetSize() == 0u );
+
+	test_assert( serializer.AddArray( size_t(too_big - 1u) ) );
+	test_assert( serializer.AddMap( size_t(too_big - 1u) ) );
+	test_assert( std::string( out.GetData(), out.GetSize() ) == FromHex( "ddffffffffdfffffffff" ) );
+}
+
+static void MessagePackErrorsTest()
+{
+	const struct
+	{
+		const char* message_pack_hex;
+		Parser::Result::Error error;
+		size_t error_pos;
+	} examples[]=
+	{
+		{ "", Parser::Result::Error::EmptyInput, 0u },
+		{ "cd01", Parser::Result::Error::UnexpectedEndOfFile, 1u },
+		{ "9301", Parser::Result::Error::UnexpectedEndOfFile, 2u },
+		{ "a261", Parser::Result::Error::UnexpectedEndOfFile, 1u },
+		{ "0000", Parser::Result::Error::ExtraCharactersAfterJsonRoot, 1u },
+		{ "c40161", Parser::Result::Error::UnexpectedLexem, 0u }, // Bin.
+		{ "d40100", Parser::Result::Error::UnexpectedLexem, 0u }, // Ext.
+		{ "c1", Parser::Result::Error::UnexpectedLexem, 0u }, // Never used.
+		{ "910101", Parser::Result::Error::ExtraCharactersAfterJsonRoot, 2u },
+		{ "810101", Parser::Result::Error::UnexpectedLexem, 1u }, // Not str key.
+		{ "81a161", Parser::Result::Error::UnexpectedEndOfFile, 3u },
+	};
+
+	for( const auto& example : examples )
+	{
+		const Parser::ResultPtr result= ParseMessagePack( FromHex( example.message_pack_hex ) );
+		test_assert( result->error == example.error );
+		test_assert( result->error_pos == example.error_pos );
+	}
+}
+
+void RunMessagePackTests()
+{
+	MessagePackRoundTripTest();
+	MessagePackDecodeTest();
+	MessagePackEncodeTest();
+	MessagePackErrorsTest();
+	MessagePackSizeLimitsTest();
+}
@@ -1,7 +1,13 @@
+#include <atomic>
 #include <cmath>
 #include <cstring>
 #include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 #include "../include/PanzerJson/parser.hpp"
+#include "../include/PanzerJson/serializer.hpp"
 #include "tests.hpp"
 
 using namespace PanzerJson;
@@ -706,6 +712,372 @@ static void CommentsTest2()
 	test_assert( result->root["baz"].AsInt() == 42u );
 }
 
+static void KeysInterningTest()
+{
+	static const char json_text[]=
+	u8R"(
+		[
+			{ "x" : 1, "y" : 2, "name" : "first" },
+			{ "y" : 4, "x" : 3, "name" : "second", "extra" : null },
+			{ "name" : "third" }
+		]
+	)";
+
+	Parser parser;
+	const Parser::ResultPtr result= parser.Parse( json_text );
+
+	test_assert( result->error == Parser::Result::Error::NoError );
+	test_assert( result->root.ElementCount() == 3u );
+
+	// Same keys must have same pointers.
+	const StringType name_key= (*result->root[0u].object_begin()).first; // "name" is first after sorting.
+	test_assert( std::strcmp( name_key, "name" ) == 0 );
+	test_assert( (*++result->root[1u].object_begin()).first == name_key ); // "extra" is first here.
+	test_assert( (*result->root[2u].object_begin()).first == name_key );
+
+	const Key x( "x" ), name( "name" ), extra( "extra" );
+	test_assert( result->root[0u][x].AsInt() == 1 );
+	test_assert( result->root[1u][x].AsInt() == 3 );
+	test_assert( result->root[2u][x].IsNull() );
+	test_assert( std::strcmp( result->root[1u][name].AsString(), "second" ) == 0 );
+	test_assert( std::strcmp( result->root[2u][name].AsString(), "third" ) == 0 );
+	test_assert( result->root[1u].IsMember( extra ) && !result->root[0u].IsMember( extra ) );
+
+	// Key, created from document key, must work too.
+	const Key name_from_document( name_key );
+	test_assert( std::strcmp( result->root[0u][name_from_document].AsString(), "first" ) == 0 );
+
+	// Key, created from other string, remembers pointer of found document key and uses it in lookups in other objects.
+	// Change tail of key string after first lookup - next lookups with remembered pointer must not compare strings.
+	const Parser::ResultPtr long_keys_result= parser.Parse( R"([ { "long key string" : 1 }, { "long key string" : 2 } ])" );
+	std::string long_key_string= "long key string";
+	const Key long_key( long_key_string.c_str() );
+	test_assert( long_keys_result->root[0u][long_key].AsInt() == 1 );
+	long_key_string.back()= 'G';
+	test_assert( long_keys_result->root[1u][long_key].AsInt() == 2 );
+	// After cache reset strings are compared again.
+	long_key.ResetCache();
+	test_assert( long_keys_result->root[1u][long_key].IsNull() );
+
+	// Result must be same without interning.
+	parser.SetInternKeys( false );
+	const Parser::ResultPtr result_without_interning= parser.Parse( json_text );
+	test_assert( result_without_interning->root == result->root );
+	test_assert( (*result_without_interning->root[0u].object_begin()).first != (*result_without_interning->root[2u].object_begin()).first );
+}
+static void ObjectShapesTest()
+{
+	static const char json_text[]=
+	u8R"(
+		[
+			{ "x" : 1, "y" : 2, "name" : "first" },
+			{ "y" : 4, "x" : 3, "name" : "second" },
+			{ "name" : "third", "x" : 5, "y" : 6 },
+			{ "name" : "unique" },
+			{ "x" : 7, "y" : 8, "name" : "fourth", "z" : 9 },
+			{}
+		]
+	)";
+
+	Parser parser;
+	const Parser::ResultPtr result= parser.Parse( json_text );
+
+	test_assert( result->error == Parser::Result::Error::NoError );
+	const Value& root= result->root;
+	test_assert( root.ElementCount() == 6u );
+
+	// First object with such keys have no shape, next have.
+	const auto get_layout= [&]( const size_t i )
+	{
+		return static_cast<const ObjectValue*>( root[i].GetInternalValue() )->layout;
+	};
+	test_assert( get_layout(0u) == ObjectValue::Layout::Entries );
+	test_assert( get_layout(1u) == ObjectValue::Layout::Shaped );
+	test_assert( get_layout(2u) == ObjectValue::Layout::Shaped );
+	test_assert( get_layout(3u) == ObjectValue::Layout::Entries );
+	test_assert( get_layout(4u) == ObjectValue::Layout::Entries );
+	test_assert(
+		static_cast<const ObjectValue*>( root[1u].GetInternalValue() )->GetShape() ==
+		static_cast<const ObjectValue*>( root[2u].GetInternalValue() )->GetShape() );
+
+	// Search.
+	const Key x( "x" ), y( "y" ), name( "name" );
+	for( size_t i= 0u; i < 3u; i++ )
+	{
+		test_assert( root[i][x].AsInt() == int(i * 2u + 1u) );
+		test_assert( root[i]["y"].AsInt() == int(i * 2u + 2u) );
+		test_assert( root[i].IsMember( name ) && root[i].IsMember( "name" ) );
+		test_assert( !root[i].IsMember( "z" ) );
+	}
+	test_assert( std::strcmp( root[2u][name].AsString(), "third" ) == 0 );
+
+	// Iteration.
+	const char* const expected_keys[]= { "name", "x", "y" };
+	size_t key_index= 0u;
+	for( const auto& member : root[2u].object_elements() )
+	{
+		test_assert( std::strcmp( member.first, expected_keys[key_index] ) == 0 );
+		test_assert( member.second == root[2u][ expected_keys[key_index] ] );
+		++key_index;
+	}
+	test_assert( key_index == 3u );
+
+	size_t value_count= 0u;
+	for( const Value member_value : root[1u] )
+	{
+		test_assert( member_value == root[1u][ expected_keys[value_count] ] );
+		++value_count;
+	}
+	test_assert( value_count == 3u );
+	test_assert( std::distance( root[1u].object_begin(), root[1u].object_end() ) == 3 );
+
+	// Result must be same without shapes.
+	parser.SetShareObjectShapes( false );
+	const Parser::ResultPtr result_without_shapes= parser.Parse( json_text );
+	test_assert( result_without_shapes->root == root );
+	test_assert( static_cast<const ObjectValue*>( result_without_shapes->root[1u].GetInternalValue() )->layout == ObjectValue::Layout::Entries );
+}
+
+static void PackedNumberArraysTest()
+{
+	static const char json_text[]=
+	u8R"(
+		[
+			[ 1, -2, 3, 1234567890123, -1234567890000 ],
+			[ 1.5, -2.25, 3.125, 0.0625 ],
+			[ 1, 2, "three" ],
+			[ -0.0, 0.5 ],
+			[ 18446744073709551615 ],
+			[ ],
+			[ 1.5, 3, 100000000000 ]
+		]
+	)";
+
+	Parser parser;
+	const Parser::ResultPtr result= parser.Parse( json_text );
+	test_assert( result->error == Parser::Result::Error::NoError );
+	const Value& root= result->root;
+
+	const auto get_layout= [&]( const size_t i )
+	{
+		return static_cast<const ArrayValue*>( root[i].GetInternalValue() )->layout;
+	};
+	test_assert( get_layout(0u) == ArrayValue::Layout::PackedInt64s );
+	test_assert( get_layout(1u) == ArrayValue::Layout::PackedDoubles );
+	test_assert( get_layout(2u) == ArrayValue::Layout::Elements );
+	test_assert( get_layout(3u) == ArrayValue::Layout::PackedDoubles ); // Negative zero is not integer.
+	test_assert( get_layout(4u) == ArrayValue::Layout::Elements ); // Uint64 is not representable in packed arrays.
+	test_assert( get_layout(5u) == ArrayValue::Layout::Elements );
+	test_assert( get_layout(6u) == ArrayValue::Layout::Elements ); // Integers and doubles are not packed together.
+
+	// Access.
+	test_assert( root[0u].ElementCount() == 5u );
+	test_assert( root[0u][1u].IsNumber() && root[0u][1u].AsInt() == -2 && root[0u][1u].AsDouble() == -2.0 );
+	test_assert( root[0u][3u].AsInt64() == 1234567890123ll );
+	test_assert( root[0u][4u].AsDouble() == -1234567890000.0 );
+	test_assert( root[0u][5u].IsNull() );
+	test_assert( root[1u][0u].AsDouble() == 1.5 && root[1u][0u].AsInt64() == 1 );
+	test_assert( root[1u][1u].AsInt64() == -2 );
+	test_assert( root[1u][3u].AsDouble() == 0.0625 );
+	test_assert( root[4u][0u].AsUint64() == std::numeric_limits<uint64_t>::max() );
+
+	const Span<int64_t> ints= root[0u].AsInt64Span();
+	test_assert( ints.size == 5u && ints.data[2u] == 3 );
+	test_assert( root[0u].AsDoubleSpan().size == 0u );
+	test_assert( root[1u].AsDoubleSpan().size == 4u && root[1u].AsDoubleSpan().data[1u] == -2.25 );
+	test_assert( root[2u].AsInt64Span().data == nullptr );
+
+	// Iteration.
+	int64_t sum= 0;
+	for( const Value element : root[0u].array_elements() )
+		sum+= element.AsInt64();
+	test_assert( sum == 1 - 2 + 3 + 123 );
+
+	double double_sum= 0.0;
+	for( const Value element : root[1u] )
+		double_sum+= element.AsDouble();
+	test_assert( double_sum == 1.5 - 2.25 + 3.125 + 0.0625 );
+	test_assert( std::distance( root[1u].array_begin(), root[1u].array_end() ) == 4 );
+
+	// Result must be same without packing.
+	parser.SetPackNumberArrays( false );
+	const Parser::ResultPtr result_without_packing= parser.Parse( json_text );
+	test_assert( static_cast<const ArrayValue*>( result_without_packing->root[0u].GetInternalValue() )->layout == ArrayValue::Layout::Elements );
+	test_assert( result_without_packing->root == root );
+	test_assert( std::signbit( result_without_packing->root[3u][0u].AsDouble() ) && std::signbit( root[3u][0u].AsDouble() ) );
+
+	// Serialized result does not depend on packing - integers are written as integers, doubles - as doubles.
+	std::ostringstream stream, stream_without_packing;
+	Serializer().Serialize( root, stream );
+	Serializer().Serialize( result_without_packing->root, stream_without_packing );
+	test_assert( stream.str() == stream_without_packing.str() );
+
+	std::ostringstream mixed_stream;
+	Serializer().Serialize( root[6u], mixed_stream );
+	test_assert( mixed_stream.str() == "[1.5,3,100000000000]" );
+}
+
+static void InlineNumbersTest()
+{
+	static const char json_text[]= u8R"( { "small" : -42, "big" : 1234567890123, "double" : 0.25, "mixed" : [ 1, "two", 1e3 ] } )";
+
+	Parser parser;
+	const Parser::ResultPtr result= parser.Parse( json_text );
+	test_assert( result->error == Parser::Result::Error::NoError );
+	const Value& root= result->root;
+
+	// Small integers are stored directly in pointers to values.
+	const ObjectValue& object= *static_cast<const ObjectValue*>( root.GetInternalValue() );
+	test_assert( IsInlineNumber( object.GetValue(3u) ) && GetInlineNumber( object.GetValue(3u) ) == -42 );
+	test_assert( !IsInlineNumber( object.GetValue(0u) ) );
+	test_assert( static_cast<const NumberValue*>( object.GetValue(0u) )->kind == NumberValue::Kind::Int64 );
+	test_assert( static_cast<const NumberValue*>( object.GetValue(1u) )->kind == NumberValue::Kind::Double );
+
+	test_assert( root["small"].IsNumber() && root["small"].AsInt() == -42 && root["small"].AsDouble() == -42.0 );
+	test_assert( root["big"].AsInt64() == 1234567890123ll );
+	test_assert( root["double"].AsDouble() == 0.25 );
+	test_assert( root["mixed"][0u].AsInt() == 1 && root["mixed"][2u].AsInt() == 1000 );
+
+	// Same result without inline numbers.
+	parser.SetSaveNumberStrings( true );
+	const Parser::ResultPtr result_with_strings= parser.Parse( json_text );
+	test_assert( result_with_strings->root == root );
+	test_assert( std::strcmp( result_with_strings->root["small"].AsString(), "-42" ) == 0 );
+}
+
+static void LazyNumbersTest()
+{
+	static const char json_text[]= u8R"([1.50,-0,12345678901234567890,-7,2.5e-3,1E2])";
+
+	Parser parser;
+	parser.SetLazyNumbers( true );
+	const Parser::ResultPtr result= parser.Parse( json_text );
+	test_assert( result->error == Parser::Result::Error::NoError );
+	const Value& root= result->root;
+
+	const NumberValue& number= *static_cast<const NumberValue*>( root[0u].GetInternalValue() );
+	test_assert( number.kind == NumberValue::Kind::Lazy && number.has_string );
+	test_assert( number.lazy_state == NumberValue::LazyState::NotConverted );
+	test_assert( std::strcmp( root[0u].AsString(), "1.50" ) == 0 );
+
+	// Numbers are converted on access. Converted value is saved, number stays lazy and keeps its string.
+	test_assert( root[0u].AsDouble() == 1.5 && root[0u].AsInt() == 1 );
+	test_assert( number.lazy_state == NumberValue::LazyState::Converted );
+	test_assert( number.kind == NumberValue::Kind::Lazy && number.converted_kind == NumberValue::Kind::Double );
+	test_assert( number.payload.double_value == 1.5 );
+	test_assert( root[0u].AsDouble() == 1.5 && std::strcmp( root[0u].AsString(), "1.50" ) == 0 );
+	test_assert( root[1u].AsInt() == 0 && std::signbit( root[1u].AsDouble() ) );
+	test_assert( root[2u].AsUint64() == 12345678901234567890ull );
+	test_assert( root[3u].AsInt() == -7 );
+	test_assert( root[5u].AsInt() == 100 && number.GetConverted().kind == NumberValue::Kind::Double );
+
+	// Result is equal to result of normal parsing.
+	parser.SetLazyNumbers( false );
+	test_assert( parser.Parse( json_text )->root == root );
+
+	// Original strings are serialized.
+	std::ostringstream stream;
+	Serializer().Serialize( root, stream );
+	test_assert( stream.str() == json_text );
+}
+
+static void LazyNumbersThreadsTest()
+{
+	std::string json_text= "[";
+	for( size_t i= 0u; i < 1000u; ++i )
+		json_text+= ( i == 0u ? "" : "," ) + std::to_string(i) + ".5";
+	json_text+= "]";
+
+	Parser parser;
+	parser.SetLazyNumbers( true );
+	const Parser::ResultPtr result= parser.Parse( json_text.data(), json_text.size() );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	// Numbers are converted concurrently in many threads.
+	std::atomic<bool> all_ok{ true };
+	std::vector<std::thread> threads;
+	for( size_t t= 0u; t < 4u; ++t )
+		threads.emplace_back(
+			[&]
+			{
+				for( size_t i= 0u; i < 1000u; ++i )
+					if( result->root[i].AsDouble() != double(i) + 0.5 )
+						all_ok= false;
+			} );
+	for( std::thread& thread : threads )
+		thread.join();
+
+	test_assert( all_ok );
+	for( size_t i= 0u; i < 1000u; ++i )
+		test_assert( static_cast<const NumberValue*>( result->root[i].GetInternalValue() )->lazy_state == NumberValue::LazyState::Converted );
+}
+
+static void LazyStringsUnescapingTest()
+{
+	static const char json_text[]= u8R"({"escaped":"\u0041\tb\"c\/","key\n":"\u0444","plain":"abc"})";
+
+	Parser parser;
+	parser.SetLazyStringsUnescaping( true );
+	const Parser::ResultPtr result= parser.Parse( json_text );
+	test_assert( result->error == Parser::Result::Error::NoError );
+	const Value& root= result->root;
+
+	const StringValue& escaped= *static_cast<const StringValue*>( root["escaped"].GetInternalValue() );
+	test_assert( escaped.state == StringValue::State::Escaped );
+	test_assert( !static_cast<const StringValue*>( root["plain"].GetInternalValue() )->HasEscapes() );
+
+	// Original strings are serialized, without unescaping.
+	std::ostringstream stream;
+	Serializer().Serialize( root, stream );
+	test_assert( escaped.state == StringValue::State::Escaped );
+	test_assert( stream.str() == json_text );
+
+	// Strings are unescaped on access. Keys are unescaped always.
+	test_assert( std::strcmp( root["escaped"].AsString(), "A\tb\"c/" ) == 0 );
+	test_assert( escaped.state == StringValue::State::Unescaped );
+	test_assert( std::strcmp( root["key\n"].AsString(), u8"ф" ) == 0 );
+	test_assert( std::strcmp( escaped.GetEscapedString(), "\\u0041\\tb\\\"c\\/" ) == 0 );
+
+	parser.SetLazyStringsUnescaping( false );
+	test_assert( parser.Parse( json_text )->root == root );
+}
+
+static void StringViewsTest()
+{
+	static const char json_text[]= u8R"({"key":"a\u0000b","long key name":"\u0001 \u0444"})";
+
+	for( const bool lazy_unescaping : { false, true } )
+	{
+		Parser parser;
+		parser.SetLazyStringsUnescaping( lazy_unescaping );
+		const Parser::ResultPtr result= parser.Parse( json_text );
+		test_assert( result->error == Parser::Result::Error::NoError );
+		const Value& root= result->root;
+
+		// Strings with null symbols are not truncated.
+		const StringView str= root["key"].AsStringView();
+		test_assert( str.size == 3u && std::memcmp( str.data, "a\0b", 3u ) == 0 );
+		test_assert( std::strcmp( root["key"].AsString(), "a" ) == 0 );
+		test_assert( root["long key name"].AsStringView().size == 4u );
+
+		// Lookup by strings without null-termination.
+		const std::string key= "key";
+		test_assert( root[key] == root["key"] );
+		test_assert( root[ StringView( "long key name with suffix", 13u ) ] == root["long key name"] );
+		test_assert( root.IsMember( StringView( "keys", 3u ) ) );
+		test_assert( !root.IsMember( StringView( "ke", 2u ) ) );
+		test_assert( !root.IsMember( StringView( "key\0", 4u ) ) );
+		test_assert( root[ Key( StringView( "long key name with suffix", 13u ) ) ] == root["long key name"] );
+		test_assert( root[ Key( StringView( "keys", 3u ) ) ] == root["key"] );
+		test_assert( root[ Key( StringView( "long key", 8u ) ) ].IsNull() );
+
+		// Null symbols are escaped on serialization.
+		std::ostringstream stream;
+		Serializer().Serialize( root, stream );
+		test_assert( !lazy_unescaping || stream.str() == json_text ); // Escaped strings are written as is.
+		test_assert( Parser().Parse( stream.str().data(), stream.str().size() )->root == root );
+	}
+}
 
 void RunParserTests()
 {
@@ -754,4 +1126,12 @@ void RunParserTests()
 	CommentsTest0();
 	CommentsTest1();
 	CommentsTest2();
+	KeysInterningTest();
+	ObjectShapesTest();
+	PackedNumberArraysTest();
+	InlineNumbersTest();
+	LazyNumbersTest();
+	LazyNumbersThreadsTest();
+	LazyStringsUnescapingTest();
+	StringViewsTest();
 }
@@ -9,8 +9,24 @@
 #include "gen_strings_pooling_test.hpp"
 #include "gen_objects_and_arrays_pooling_test.hpp"
 #include "gen_string_values_as_key_reuse_test.hpp"
+#include "gen_number_arrays_test.hpp"
+#include "gen_number_kinds_test.hpp"
+#include "gen_utf8_test.hpp"
+#include "gen_blob_complex_object.hpp"
+#include "gen_blob_int_convert_test.hpp"
+#include "gen_blob_simple_object.hpp"
+#include "gen_blob_sort_test.hpp"
+#include "gen_blob_null_and_bool_values_pooling_test.hpp"
+#include "gen_blob_numbers_pooling_test.hpp"
+#include "gen_blob_strings_pooling_test.hpp"
+#include "gen_blob_objects_and_arrays_pooling_test.hpp"
+#include "gen_blob_string_values_as_key_reuse_test.hpp"
+#include "gen_blob_number_arrays_test.hpp"
+#include "gen_blob_number_kinds_test.hpp"
+#include "gen_blob_utf8_test.hpp"
 
 #include "../include/PanzerJson/parser.hpp"
+#include "../include/PanzerJson/serializer.hpp"
 #include "tests.hpp"
 
 std::string ReadTestJsonFile( const char* const test_json_name )
@@ -34,6 +50,59 @@ std::string ReadTestJsonFile( const char* const test_json_name )
 
 using namespace PanzerJson;
 
+// "operator==" compares only values of numbers. Check also kinds of numbers and layouts of arrays.
+static void CheckKindsAreEqual_r( const Value& l, const Value& r )
+{
+	test_assert( l.GetType() == r.GetType() );
+	test_assert( l.ElementCount() == r.ElementCount() );
+
+	switch( l.GetType() )
+	{
+	case ValueBase::Type::Object:
+		{
+			Value::ObjectIterator r_it= r.object_begin();
+			for( const auto& l_member : l.object_elements() )
+			{
+				CheckKindsAreEqual_r( l_member.second, (*r_it).second );
+				++r_it;
+			}
+		}
+		break;
+
+	case ValueBase::Type::Array:
+		{
+			test_assert(
+				static_cast<const ArrayValue*>( l.GetInternalValue() )->layout ==
+				static_cast<const ArrayValue*>( r.GetInternalValue() )->layout );
+			Value::ArrayIterator r_it= r.array_begin();
+			for( const Value l_element : l.array_elements() )
+			{
+				CheckKindsAreEqual_r( l_element, *r_it );
+				++r_it;
+			}
+		}
+		break;
+
+	case ValueBase::Type::Number:
+		test_assert(
+			static_cast<const NumberValue*>( l.GetInternalValue() )->GetConverted().kind ==
+			static_cast<const NumberValue*>( r.GetInternalValue() )->GetConverted().kind );
+		break;
+
+	case ValueBase::Type::Null:
+	case ValueBase::Type::String:
+	case ValueBase::Type::Bool:
+		break;
+	};
+}
+
+static std::string Serialize( const Value value )
+{
+	OutputBuffer out;
+	Serializer().Serialize( value, out );
+	return std::string( out.GetData(), out.GetSize() );
+}
+
 void RunParsersEqualityTests()
 {
 	// Equality test.
@@ -45,15 +114,53 @@ void RunParsersEqualityTests()
 		const std::string src_json= ReadTestJsonFile( #TEST_NAME );\
 		const Parser::ResultPtr result= parser.Parse( src_json.data(), src_json.size() );\
 		test_assert( result->root == Value( &TEST_NAME ) );\
+		CheckKindsAreEqual_r( result->root, Value( &TEST_NAME ) );\
+		test_assert( Serialize( result->root ) == Serialize( Value( &TEST_NAME ) ) );\
+	}
+
+	// Parser converts some big doubles inexactly, so, check only kinds of numbers.
+	#define CHECK_TEST_JSON_KINDS( TEST_NAME ) \
+	{\
+		const std::string src_json= ReadTestJsonFile( #TEST_NAME );\
+		const Parser::ResultPtr result= parser.Parse( src_json.data(), src_json.size() );\
+		CheckKindsAreEqual_r( result->root, Value( &TEST_NAME ) );\
 	}
 
 	CHECK_TEST_JSON( complex_object )
 //	CHECK_TEST_JSON( int_convert_test )
+	CHECK_TEST_JSON_KINDS( int_convert_test )
 	CHECK_TEST_JSON( simple_object )
 	CHECK_TEST_JSON( sort_test )
 	CHECK_TEST_JSON( null_and_bool_values_pooling_test )
 //	CHECK_TEST_JSON( numbers_pooling_test )
+	CHECK_TEST_JSON_KINDS( numbers_pooling_test )
 	CHECK_TEST_JSON( strings_pooling_test )
 	CHECK_TEST_JSON( objects_and_arrays_pooling_test )
 	CHECK_TEST_JSON( string_values_as_key_reuse_test )
+	CHECK_TEST_JSON( number_arrays_test )
+	CHECK_TEST_JSON( number_kinds_test )
+
+	// Result of python-script in blob mode must be equal to result of python-script in normal mode.
+	#define CHECK_TEST_JSON_BLOB( TEST_NAME ) \
+	{\
+		const Parser::Result* const blob_result= TEST_NAME##_blob();\
+		test_assert( blob_result != nullptr );\
+		test_assert( blob_result == TEST_NAME##_blob() );\
+		test_assert( blob_result->root == Value( &TEST_NAME ) );\
+		CheckKindsAreEqual_r( blob_result->root, Value( &TEST_NAME ) );\
+		test_assert( Serialize( blob_result->root ) == Serialize( Value( &TEST_NAME ) ) );\
+	}
+
+	CHECK_TEST_JSON_BLOB( complex_object )
+	CHECK_TEST_JSON_BLOB( int_convert_test )
+	CHECK_TEST_JSON_BLOB( simple_object )
+	CHECK_TEST_JSON_BLOB( sort_test )
+	CHECK_TEST_JSON_BLOB( null_and_bool_values_pooling_test )
+	CHECK_TEST_JSON_BLOB( numbers_pooling_test )
+	CHECK_TEST_JSON_BLOB( strings_pooling_test )
+	CHECK_TEST_JSON_BLOB( objects_and_arrays_pooling_test )
+	CHECK_TEST_JSON_BLOB( string_values_as_key_reuse_test )
+	CHECK_TEST_JSON_BLOB( number_arrays_test )
+	CHECK_TEST_JSON_BLOB( number_kinds_test )
+	CHECK_TEST_JSON_BLOB( utf8_test )
 }
@@ -0,0 +1,752 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/PanzerJson/parser.hpp"
+#include "../include/PanzerJson/resumable_serializer.hpp"
+#include "../include/PanzerJson/serializer.hpp"
+#include "../include/PanzerJson/streamed_serializer.hpp"
+#include "tests.hpp"
+
+using namespace PanzerJson;
+
+static std::string ToString( const OutputBuffer& out )
+{
+	return std::string( out.GetData(), out.GetSize() );
+}
+
+static void GrowableOutputBufferTest()
+{
+	OutputBuffer out;
+	test_assert( out.GetSize() == 0u );
+
+	out << 'a' << "bc" << StringView( "def", 2u );
+	out.Write( "xyz", 3u );
+	test_assert( ToString( out ) == "abcdexyz" );
+
+	// Buffer grows.
+	const std::string big_string( 10000u, 'q' );
+	out << big_string.c_str();
+	test_assert( ToString( out ) == "abcdexyz" + big_string );
+
+	char* const ptr= out.Reserve( 3u );
+	ptr[0]= '1'; ptr[1]= '2';
+	out.Commit( 2u );
+	test_assert( ToString( out ) == "abcdexyz" + big_string + "12" );
+
+	out.Clear();
+	test_assert( out.GetSize() == 0u );
+}
+
+static void FixedOutputBufferTest()
+{
+	std::string result;
+	size_t flush_count= 0u;
+
+	struct FlushData
+	{
+		std::string* result;
+		size_t* flush_count;
+	};
+	FlushData flush_data{ &result, &flush_count };
+
+	char buffer[4u];
+	OutputBuffer out(
+		buffer, sizeof(buffer),
+		[]( void* const user_data, const char* const data, const size_t size )
+		{
+			FlushData& d= *static_cast<FlushData*>(user_data);
+			d.result->append( data, size );
+			++*d.flush_count;
+		},
+		&flush_data );
+
+	out << "abc";
+	test_assert( flush_count == 0u && result.empty() );
+	out << 'd' << 'e';
+	test_assert( flush_count == 1u && result == "abcd" );
+	out << "0123456789"; // Bigger, than buffer.
+	test_assert( result == "abcde0123456789" );
+	out << "xyz";
+	out.Flush();
+	test_assert( result == "abcde0123456789xyz" );
+	out.Flush();
+	test_assert( result == "abcde0123456789xyz" );
+}
+
+static void SerializeIntoBufferTest()
+{
+	static const char json_text[]= u8R"({"a":[1,2.5,"s\ntr\u0001ing"],"b":{"c":null,"d":true,"e":false},"f":"Ünicode \/"})";
+
+	const Parser::ResultPtr result= Parser().Parse( json_text );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	OutputBuffer out;
+	Serializer().Serialize( result->root, out );
+	const Parser::ResultPtr result_reparsed= Parser().Parse( out.GetData(), out.GetSize() );
+	test_assert( result_reparsed->error == Parser::Result::Error::NoError );
+	test_assert( result_reparsed->root == result->root );
+
+	// Serialization into stream produces same result.
+	std::ostringstream stream;
+	Serializer().Serialize( result->root, stream );
+	test_assert( stream.str() == ToString( out ) );
+}
+
+static void SerializeBigValueIntoStreamTest()
+{
+	// Result is bigger, than serializer intermediate buffer.
+	std::string json_text= "[";
+	for( size_t i= 0u; i < 4000u; ++i )
+		json_text+= "\"string " + std::to_string(i) + "\",";
+	json_text+= "null]";
+
+	const Parser::ResultPtr result= Parser().Parse( json_text.data(), json_text.size() );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	std::ostringstream stream;
+	Serializer().Serialize( result->root, stream );
+	test_assert( stream.str() == json_text );
+}
+
+static void StreamedSerializerTest()
+{
+	OutputBuffer out;
+	{
+		StreamedSerializer<> serializer( out );
+		auto object= serializer.AddObject();
+		object.AddNumber( "one", 1 );
+		object.AddBool( "false", false );
+		{
+			auto arr= object.AddArray( "arr" );
+			arr.AddNumber( 2u );
+			arr.AddString( std::string( "a\0b", 3u ) );
+			arr.AddBool( true );
+			arr.AddNull();
+		}
+	}
+	test_assert( ToString( out ) == R"({"one":1,"false":false,"arr":[2,"a\u0000b",true,null]})" );
+}
+
+static void PreparedKeysTest()
+{
+	static constexpr PreparedKey c_name_key= PJ_PREPARED_KEY( "name" );
+	static_assert( c_name_key.size == 7u, "wrong size" );
+
+	OutputBuffer out;
+	std::ostringstream stream;
+	{
+		StreamedSerializer<> serializer( out );
+		StreamedSerializer<std::ostringstream> stream_serializer( stream );
+		auto object= serializer.AddObject();
+		auto stream_object= stream_serializer.AddObject();
+		object.AddString( c_name_key, "foo" );
+		stream_object.AddString( c_name_key, "foo" );
+		object.AddNumber( PJ_PREPARED_KEY( "id/" ), 42 );
+		stream_object.AddNumber( PJ_PREPARED_KEY( "id/" ), 42 );
+		object.AddNull( "plain\n" );
+		stream_object.AddNull( "plain\n" );
+		{
+			auto arr= object.AddArray( PJ_PREPARED_KEY( "" ) );
+			arr.AddBool( true );
+		}
+	}
+	test_assert( ToString( out ) == R"({"name":"foo","id/":42,"plain\n":null,"":[true]})" );
+	test_assert( stream.str() == R"({"name":"foo","id/":42,"plain\n":null})" );
+}
+
+static void BulkArrayAppendersTest()
+{
+	std::vector<double> doubles;
+	std::vector<int> ints;
+	std::vector<uint64_t> uints;
+	std::vector<float> floats;
+	for( size_t i= 0u; i < 100u; ++i )
+	{
+		doubles.push_back( double(i) * 0.37 - 5.0 );
+		ints.push_back( int(i) * 1000 - 31337 );
+		uints.push_back( ~uint64_t(0u) - i * 7u );
+		floats.push_back( float(i) * 0.25f );
+	}
+	bool bools[]{ true, false, false, true, true };
+	const StringView strings[]{ "a", StringView( "b\0c", 3u ), "d\"" };
+
+	for( const size_t count : { 0u, 1u, 16u, 17u, 100u } )
+	{
+		OutputBuffer bulk_out, single_out;
+		{
+			StreamedSerializer<> bulk_serializer( bulk_out );
+			StreamedSerializer<> single_serializer( single_out );
+			auto bulk_arr= bulk_serializer.AddArray();
+			auto single_arr= single_serializer.AddArray();
+
+			bulk_arr.AddNumbers( doubles.data(), count );
+			bulk_arr.AddNumbers( ints.data(), count );
+			bulk_arr.AddNumbers( uints.data(), count );
+			bulk_arr.AddNumbers( floats.data(), count );
+			bulk_arr.AddBools( bools, std::min( count, size_t(5u) ) );
+			bulk_arr.AddStrings( strings, std::min( count, size_t(3u) ) );
+			bulk_arr.AddNull();
+
+			for( size_t i= 0u; i < count; ++i ) single_arr.AddNumber( doubles[i] );
+			for( size_t i= 0u; i < count; ++i ) single_arr.AddNumber( ints[i] );
+			for( size_t i= 0u; i < count; ++i ) single_arr.AddNumber( uints[i] );
+			for( size_t i= 0u; i < count; ++i ) single_arr.AddNumber( floats[i] );
+			for( size_t i= 0u; i < std::min( count, size_t(5u) ); ++i ) single_arr.AddBool( bools[i] );
+			for( size_t i= 0u; i < std::min( count, size_t(3u) ); ++i ) single_arr.AddString( strings[i] );
+			single_arr.AddNull();
+		}
+		test_assert( ToString( bulk_out ) == ToString( single_out ) );
+	}
+
+	// Generic stream.
+	std::ostringstream stream;
+	{
+		StreamedSerializer<std::ostringstream> serializer( stream );
+		auto arr= serializer.AddArray();
+		arr.AddNumbers( ints.data(), 3u );
+		arr.AddBools( bools, 2u );
+	}
+	test_assert( stream.str() == "[-31337,-30337,-29337,true,false]" );
+}
+
+static void StreamedSerializerEmbeddingTest()
+{
+	const Parser::ResultPtr result= Parser().Parse( R"({"static":[1,2.5,"s\n"],"e":{}})" );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	OutputBuffer out;
+	std::ostringstream stream;
+	{
+		StreamedSerializer<> serializer( out );
+		StreamedSerializer<std::ostringstream> stream_serializer( stream );
+		auto object= serializer.AddObject();
+		auto stream_object= stream_serializer.AddObject();
+		object.AddNumber( "id", 7 );
+		object.AddValue( "block", result->root );
+		object.AddRaw( PJ_PREPARED_KEY( "raw" ), R"({"x":[true]})" );
+		stream_object.AddValue( "block", result->root["static"] );
+		stream_object.AddRaw( "raw", "null" );
+		{
+			auto arr= object.AddArray( "arr" );
+			arr.AddValue( result->root["static"][1u] );
+			arr.AddRaw( "\"r\"" );
+			arr.AddValue( result->root["e"] );
+		}
+	}
+	test_assert( ToString( out ) == R"({"id":7,"block":{"e":{},"static":[1,2.5,"s\n"]},"raw":{"x":[true]},"arr":[2.5,"r",{}]})" );
+	test_assert( stream.str() == R"({"block":[1,2.5,"s\n"],"raw":null})" );
+
+	test_assert( IsValidJsonFragment( "[1,2]" ) );
+	test_assert( IsValidJsonFragment( "\"s\"" ) );
+	test_assert( !IsValidJsonFragment( "[1,2" ) );
+	test_assert( !IsValidJsonFragment( "" ) );
+}
+
+static void StringsEscapingTest()
+{
+	// Compare fast version for output buffer with generic version for different positions of special symbols.
+	const char special_symbols[]{ '"', '\\', '/', '\0', '\n', '\x1F', '\x7F', '\x80', '\xFF', ' ' };
+	for( const bool escape_slash : { false, true } )
+	for( const char special_symbol : special_symbols )
+	for( size_t length= 1u; length < 80u; ++length )
+	for( size_t pos= 0u; pos < length; ++pos )
+	{
+		std::string str( length, 'a' );
+		str[pos]= special_symbol;
+		str[length - 1u]= '\x10';
+
+		OutputBuffer out;
+		SerializeString( out, str, escape_slash );
+		std::ostringstream stream;
+		SerializeString( stream, str, escape_slash );
+		test_assert( ToString( out ) == stream.str() );
+	}
+
+	OutputBuffer out;
+	SerializeString( out, std::string( "\"a/b\\c\x01\x1F\b\f\n\r\t\x7F\0", 15u ) );
+	test_assert( ToString( out ) == R"("\"a/b\\c\u0001\u001f\b\f\n\r\t)" "\x7F" R"(\u0000")" );
+
+	out.Clear();
+	SerializeString( out, "a/b", true );
+	test_assert( ToString( out ) == R"("a\/b")" );
+
+	static const char json_text[]= R"({"a/b":"c/d"})";
+	const Parser::ResultPtr result= Parser().Parse( json_text );
+	Serializer serializer;
+	std::ostringstream stream;
+	serializer.Serialize( result->root, stream );
+	test_assert( stream.str() == json_text );
+	serializer.SetEscapeSlash( true );
+	stream.str( "" );
+	serializer.Serialize( result->root, stream );
+	test_assert( stream.str() == R"({"a\/b":"c\/d"})" );
+}
+
+static std::string DoubleToString( const double d )
+{
+	NumberStringStorage str;
+	const size_t length= GenDoubleValueString( d, str );
+	test_assert( std::strlen( str.data() ) == length );
+	return str.data();
+}
+
+static void NumbersFormattingTest()
+{
+	test_assert( DoubleToString( 0.0 ) == "0.0" );
+	test_assert( DoubleToString( -0.0 ) == "-0.0" );
+	test_assert( DoubleToString( 1.0 ) == "1.0" );
+	test_assert( DoubleToString( -2.5 ) == "-2.5" );
+	test_assert( DoubleToString( 0.1 ) == "0.1" );
+	test_assert( DoubleToString( 0.3 ) == "0.3" );
+	test_assert( DoubleToString( 3.14159 ) == "3.14159" );
+	test_assert( DoubleToString( 1e20 ) == "100000000000000000000.0" );
+	test_assert( DoubleToString( 1e21 ) == "1e21" );
+	test_assert( DoubleToString( 0.000001 ) == "0.000001" );
+	test_assert( DoubleToString( 1.25e-7 ) == "1.25e-7" );
+	test_assert( DoubleToString( 5e-324 ) == "5e-324" );
+	test_assert( DoubleToString( std::numeric_limits<double>::max() ) == "1.7976931348623157e308" );
+
+	// Formatted doubles are converted back exactly.
+	std::mt19937_64 gen;
+	for( size_t i= 0u; i < 100000u; ++i )
+	{
+		const uint64_t bits= gen();
+		double d;
+		std::memcpy( &d, &bits, sizeof(double) );
+		if( d != d || d == std::numeric_limits<double>::infinity() || d == -std::numeric_limits<double>::infinity() )
+			continue;
+		test_assert( std::strtod( DoubleToString( d ).c_str(), nullptr ) == d );
+	}
+
+	NumberStringStorage str;
+	test_assert( GenIntValueString( 0, str ) == 1u && std::strcmp( str.data(), "0" ) == 0 );
+	test_assert( GenIntValueString( -7, str ) == 2u && std::strcmp( str.data(), "-7" ) == 0 );
+	test_assert( GenIntValueString( 1234567, str ) == 7u && std::strcmp( str.data(), "1234567" ) == 0 );
+	GenIntValueString( std::numeric_limits<int64_t>::min(), str );
+	test_assert( std::strcmp( str.data(), "-9223372036854775808" ) == 0 );
+	GenUintValueString( std::numeric_limits<uint64_t>::max(), str );
+	test_assert( std::strcmp( str.data(), "18446744073709551615" ) == 0 );
+}
+
+static void EscapeSlashInEscapedStringsTest()
+{
+	// Lazily unescaped strings are written as is, but slashes, which are not escaped, are escaped, if it is required.
+	const char* const json_text= R"(["/a\/b\\/c\\\/\n/","\u002f/"])";
+	for( const bool escape_slash : { false, true } )
+	{
+		std::string results[2];
+		for( const bool lazy : { false, true } )
+		{
+			Parser parser;
+			parser.SetLazyStringsUnescaping( lazy );
+			const Parser::ResultPtr result= parser.Parse( json_text );
+			test_assert( result->error == Parser::Result::Error::NoError );
+			test_assert( std::strcmp( result->root[0u].AsString(), "/a/b\\/c\\/\n/" ) == 0 );
+
+			Serializer serializer;
+			serializer.SetEscapeSlash( escape_slash );
+			OutputBuffer out;
+			serializer.Serialize( result->root, out );
+			results[ lazy ? 1u : 0u ]= ToString( out );
+		}
+
+		if( escape_slash )
+		{
+			test_assert( results[0] == R"(["\/a\/b\\\/c\\\/\n\/","\/\/"])" );
+			test_assert( results[1] == R"(["\/a\/b\\\/c\\\/\n\/","\u002f\/"])" );
+		}
+		else
+		{
+			test_assert( results[0] == R"(["/a/b\\/c\\/\n/","//"])" );
+			test_assert( results[1] == json_text );
+		}
+	}
+}
+
+static void TwoPhaseSerializationTest()
+{
+	static const char* const json_texts[]
+	{
+		"null", "true", "-17", "2.5", "18446744073709551615", R"("s\"/\u0000")",
+		"[]", "{}", "[1,2,3]", "[0.5,-1.25]",
+		u8R"({"a":[1,2.5,"s\ntr\u0001ing",[],{}],"b":{"c":null,"d":true,"e":false},"f":"Ünicode /","g":[1e300,-0.0]})",
+	};
+
+	for( const bool escape_slash : { false, true } )
+	for( const bool lazy : { false, true } )
+	for( const char* const json_text : json_texts )
+	{
+		Parser parser;
+		parser.SetLazyNumbers( lazy );
+		parser.SetLazyStringsUnescaping( lazy );
+		const Parser::ResultPtr result= parser.Parse( json_text );
+		test_assert( result->error == Parser::Result::Error::NoError );
+
+		Serializer serializer;
+		serializer.SetEscapeSlash( escape_slash );
+		OutputBuffer out;
+		serializer.Serialize( result->root, out );
+
+		const size_t size= serializer.GetSerializedSize( result->root );
+		test_assert( size == out.GetSize() );
+
+		// Check, that nothing is written outside of buffer.
+		std::vector<char> buffer( size + 1u, '#' );
+		test_assert( serializer.SerializeToBuffer( result->root, buffer.data() ) == size );
+		test_assert( std::string( buffer.data(), size ) == ToString( out ) );
+		test_assert( buffer[size] == '#' );
+	}
+}
+
+static void ParallelSerializationTest()
+{
+	// Big array of objects, big object, big packed array and small containers around them.
+	std::string json_text= R"({"a":[)";
+	for( size_t i= 0u; i < 3000u; ++i )
+		json_text+= ( i == 0u ? "" : "," ) + std::string( R"({"id":)" ) + std::to_string(i) + R"(,"name":"n\t)" + std::to_string(i) + R"(","v":[0.5,null,true]})";
+	json_text+= R"(],"b":{)";
+	for( size_t i= 0u; i < 500u; ++i )
+		json_text+= ( i == 0u ? "\"" : ",\"" ) + std::to_string( 100000u + i ) + R"(":[)" + std::to_string(i) + "]";
+	json_text+= R"(},"c":[[],{},[)";
+	for( size_t i= 0u; i < 1000u; ++i )
+		json_text+= ( i == 0u ? "" : "," ) + std::to_string( i * 3u + 1000000000000u );
+	json_text+= R"(]],"d":"/"})";
+
+	const Parser::ResultPtr result= Parser().Parse( json_text.data(), json_text.size() );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	for( const Value value : { result->root, result->root["a"], result->root["b"], result->root["c"], result->root["d"] } )
+	{
+		OutputBuffer expected;
+		Serializer().Serialize( value, expected );
+
+		for( const unsigned int thread_count : { 1u, 2u, 4u, 7u } )
+		{
+			OutputBuffer out;
+			out << "prefix";
+			Serializer().SerializeParallel( value, out, thread_count );
+			test_assert( ToString( out ) == "prefix" + ToString( expected ) );
+
+			// Fixed buffer.
+			std::string stream_result;
+			char buffer[64u];
+			OutputBuffer fixed_out(
+				buffer, sizeof(buffer),
+				[]( void* const user_data, const char* const data, const size_t size )
+				{
+					static_cast<std::string*>(user_data)->append( data, size );
+				},
+				&stream_result );
+			Serializer().SerializeParallel( value, fixed_out, thread_count );
+			fixed_out.Flush();
+			test_assert( stream_result == ToString( expected ) );
+		}
+	}
+}
+
+static std::string ToString( const ChunkedOutput& out )
+{
+	std::string result;
+	for( size_t i= 0u; i < out.GetChunkCount(); ++i )
+		result.append( static_cast<const char*>( out.GetChunks()[i].data ), out.GetChunks()[i].size );
+	test_assert( result.size() == out.GetSize() );
+	return result;
+}
+
+static void ChunkedOutputTest()
+{
+	const std::string long_string( 1000u, 'x' );
+	const std::string json_text=
+		R"({"a":")" + long_string + R"(","b":[1,2.5,"short",")" + long_string + R"(\n)" + long_string + R"("],"c":null})";
+
+	const Parser::ResultPtr result= Parser().Parse( json_text.data(), json_text.size() );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	OutputBuffer expected;
+	Serializer().Serialize( result->root, expected );
+
+	ChunkedOutput out;
+	Serializer().Serialize( result->root, out );
+	test_assert( ToString( out ) == ToString( expected ) );
+
+	// Long strings are referenced from document storage, other parts are merged into few chunks.
+	test_assert( out.GetChunkCount() == 7u );
+	test_assert( out.GetChunks()[1].data == result->root["a"].AsString() );
+	test_assert( out.GetChunks()[3].data == result->root["b"][3u].AsString() );
+	test_assert( out.GetChunks()[5].data == result->root["b"][3u].AsString() + long_string.size() + 1u );
+
+	// Without references.
+	ChunkedOutput copying_out( ~size_t(0u) );
+	Serializer().Serialize( result->root, copying_out );
+	test_assert( ToString( copying_out ) == ToString( expected ) );
+	test_assert( copying_out.GetChunkCount() == 1u );
+
+#if defined(__unix__) || defined(__APPLE__)
+	std::FILE* const file= std::tmpfile();
+	test_assert( file != nullptr );
+	test_assert( WriteChunks( fileno(file), out.GetChunks(), out.GetChunkCount() ) );
+	std::rewind( file );
+	std::string file_content( out.GetSize(), '\0' );
+	test_assert( std::fread( &file_content[0], 1u, file_content.size(), file ) == file_content.size() );
+	std::fclose( file );
+	test_assert( file_content == ToString( expected ) );
+#endif
+
+	out.Clear();
+	test_assert( out.GetChunkCount() == 0u && out.GetSize() == 0u );
+}
+
+static void ResumableSerializationTest()
+{
+	const std::string long_string( 300u, 'x' );
+	static const char* const json_texts[]
+	{
+		"null", "true", "-17", "2.5", "18446744073709551615", R"("s\"/\u0000")", "[]", "{}", R"(["/a\/b\\/c\\\/\n/"])",
+		u8R"({"a":[1,2.5,"s\ntr\u0001ing",[],{}],"b\t":{"c":null,"d":true,"e":false},"f":"Ünicode /","g":[1e300,-0.0,12345678901234567890123]})",
+	};
+
+	std::vector<std::string> texts( std::begin(json_texts), std::end(json_texts) );
+	texts.push_back( R"({"long":[")" + long_string + R"(\n)" + long_string + R"(",")" + long_string + R"("]})" );
+
+	for( const bool escape_slash : { false, true } )
+	for( const bool lazy : { false, true } )
+	for( const std::string& json_text : texts )
+	{
+		Parser parser;
+		parser.SetLazyNumbers( lazy );
+		parser.SetLazyStringsUnescaping( lazy );
+		parser.SetPackNumberArrays( lazy );
+		parser.SetSaveNumberStrings( escape_slash );
+		const Parser::ResultPtr result= parser.Parse( json_text.data(), json_text.size() );
+		test_assert( result->error == Parser::Result::Error::NoError );
+
+		Serializer serializer;
+		serializer.SetEscapeSlash( escape_slash );
+		OutputBuffer expected;
+		serializer.Serialize( result->root, expected );
+
+		for( const size_t buffer_size : { 1u, 2u, 3u, 5u, 7u, 64u, 4096u } )
+		{
+			ResumableSerializer resumable_serializer( result->root );
+			resumable_serializer.SetEscapeSlash( escape_slash );
+
+			std::string out;
+			char buffer[4096u];
+			while( !resumable_serializer.IsFinished() )
+			{
+				const size_t size= resumable_serializer.Write( buffer, buffer_size );
+				test_assert( size <= buffer_size );
+				test_assert( size == buffer_size || resumable_serializer.IsFinished() );
+				out.append( buffer, size );
+			}
+			test_assert( out == ToString( expected ) );
+			test_assert( resumable_serializer.Write( buffer, buffer_size ) == 0u );
+		}
+	}
+}
+
+static void SerializationCacheTest()
+{
+	const Parser::ResultPtr result= Parser().Parse( R"({"a":[1,"s/",{"b":null}],"c":{"d":2.5}})" );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	OutputBuffer expected;
+	Serializer().Serialize( result->root, expected );
+
+	SerializationCache cache( 1024u * 1024u );
+	Serializer serializer;
+	serializer.SetCache( &cache );
+
+	// First serialization fills cache, second takes result from it.
+	for( size_t i= 0u; i < 2u; ++i )
+	{
+		OutputBuffer out;
+		serializer.Serialize( result->root, out );
+		test_assert( ToString( out ) == ToString( expected ) );
+	}
+	const StringView cached= cache.Find( result->root.GetInternalValue(), false );
+	test_assert( cached.data != nullptr && std::string( cached.data, cached.size ) == ToString( expected ) );
+	test_assert( cache.Find( result->root.GetInternalValue(), true ).data == nullptr );
+	test_assert( cache.Find( result->root["a"].GetInternalValue(), false ).data == nullptr );
+	const size_t used_memory= cache.GetUsedMemory();
+	test_assert( used_memory >= ToString( expected ).size() );
+
+	// Cached value is referenced by chunked output.
+	ChunkedOutput chunked_out( 1u );
+	serializer.Serialize( result->root, chunked_out );
+	test_assert( chunked_out.GetChunkCount() == 1u && chunked_out.GetChunks()[0].data == cached.data );
+	test_assert( serializer.GetSerializedSize( result->root ) == cached.size );
+
+	// Escaping of slash is cached separately.
+	serializer.SetEscapeSlash( true );
+	OutputBuffer slash_out;
+	serializer.Serialize( result->root["a"], slash_out );
+	test_assert( ToString( slash_out ) == R"([1,"s\/",{"b":null}])" );
+	test_assert( cache.Find( result->root["a"].GetInternalValue(), true ).data != nullptr );
+	serializer.SetEscapeSlash( false );
+
+	// Concurrent usage.
+	std::vector<std::thread> threads;
+	for( size_t t= 0u; t < 4u; ++t )
+		threads.emplace_back(
+			[&]
+			{
+				Serializer thread_serializer;
+				thread_serializer.SetCache( &cache );
+				for( size_t i= 0u; i < 100u; ++i )
+				{
+					OutputBuffer out;
+					thread_serializer.Serialize( result->root["c"], out );
+					test_assert( ToString( out ) == R"({"d":2.5})" );
+				}
+			} );
+	for( std::thread& thread : threads )
+		thread.join();
+
+	// Budget is exhausted - result is correct, but value is not cached.
+	SerializationCache small_cache( 16u );
+	serializer.SetCache( &small_cache );
+	OutputBuffer out;
+	serializer.Serialize( result->root, out );
+	test_assert( ToString( out ) == ToString( expected ) );
+	test_assert( small_cache.Find( result->root.GetInternalValue(), false ).data == nullptr );
+	test_assert( small_cache.GetUsedMemory() == 0u );
+
+	// Streamed serializer.
+	OutputBuffer streamed_out;
+	{
+		StreamedSerializer<> streamed_serializer( streamed_out );
+		auto arr= streamed_serializer.AddArray();
+		arr.AddValue( result->root, &cache );
+		arr.AddValue( result->root["c"], &cache );
+	}
+	test_assert( ToString( streamed_out ) == "[" + ToString( expected ) + R"(,{"d":2.5}])" );
+	test_assert( cache.GetUsedMemory() > used_memory );
+
+	cache.Clear();
+	test_assert( cache.GetUsedMemory() == 0u );
+}
+
+static void SerializationCacheDocumentsTest()
+{
+	SerializationCache cache( 1024u * 1024u );
+	Serializer serializer;
+	serializer.SetCache( &cache );
+
+	// Values of different alive documents are cached separately.
+	const Parser::ResultPtr result_a= Parser().Parse( R"({"a":1})" );
+	const Parser::ResultPtr result_b= Parser().Parse( R"({"b":2})" );
+	for( size_t i= 0u; i < 2u; ++i )
+	{
+		OutputBuffer out_a, out_b;
+		serializer.Serialize( result_a->root, out_a );
+		serializer.Serialize( result_b->root, out_b );
+		test_assert( ToString( out_a ) == R"({"a":1})" );
+		test_assert( ToString( out_b ) == R"({"b":2})" );
+	}
+
+	// Cache is cleared after freeing of document. New document may be placed at same address, but it gets own serialized form.
+	for( size_t i= 0u; i < 8u; ++i )
+	{
+		const std::string key= "k" + std::to_string(i);
+		const std::string json_text= "{\"" + key + "\":" + std::to_string(i) + "}";
+
+		{
+			const Parser::ResultPtr result= Parser().Parse( json_text.data(), json_text.size() );
+			OutputBuffer out;
+			serializer.Serialize( result->root, out );
+			test_assert( ToString( out ) == json_text );
+			test_assert( cache.Find( result->root.GetInternalValue(), false ).data != nullptr );
+		}
+		cache.Clear();
+	}
+}
+
+static void FormattedSerializationTest()
+{
+	const Parser::ResultPtr result= Parser().Parse( R"({"a":[1,2,{"b":null}],"c":{},"d":[],"e":"s/"})" );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	OutputBuffer compact_out, expected_compact;
+	Serializer serializer;
+	serializer.SerializeFormatted<CompactFormatting>( result->root, compact_out );
+	serializer.Serialize( result->root, expected_compact );
+	test_assert( ToString( compact_out ) == ToString( expected_compact ) );
+
+	OutputBuffer tabs_out;
+	serializer.SerializeFormatted< TabsFormatting<> >( result->root, tabs_out );
+	test_assert( ToString( tabs_out ) == "{\n\t\"a\": [\n\t\t1,\n\t\t2,\n\t\t{\n\t\t\t\"b\": null\n\t\t}\n\t],\n\t\"c\": {},\n\t\"d\": [],\n\t\"e\": \"s/\"\n}" );
+
+	std::ostringstream stream;
+	serializer.SerializeFormatted< SpacesFormatting<2> >( result->root["a"], stream );
+	test_assert( stream.str() == "[\n  1,\n  2,\n  {\n    \"b\": null\n  }\n]" );
+
+	// Containers, which fit into line, are written in one line.
+	OutputBuffer width_out;
+	serializer.SerializeFormatted< SpacesFormatting<2, 16> >( result->root, width_out );
+	test_assert( ToString( width_out ) == "{\n  \"a\": [\n    1,\n    2,\n    {\"b\":null}\n  ],\n  \"c\": {},\n  \"d\": [],\n  \"e\": \"s/\"\n}" );
+	OutputBuffer wide_out;
+	serializer.SerializeFormatted< SpacesFormatting<2, 80> >( result->root, wide_out );
+	test_assert( ToString( wide_out ) == ToString( expected_compact ) );
+
+	// Deep indents are written by blocks.
+	std::string deep_json;
+	for( size_t i= 0u; i < 200u; ++i )
+		deep_json+= "[";
+	deep_json+= "1";
+	for( size_t i= 0u; i < 200u; ++i )
+		deep_json+= "]";
+	const Parser::ResultPtr deep_result= Parser().Parse( deep_json.data(), deep_json.size() );
+	test_assert( deep_result->error == Parser::Result::Error::NoError );
+	OutputBuffer deep_out;
+	serializer.SerializeFormatted< TabsFormatting<> >( deep_result->root, deep_out );
+	const std::string deep_str= ToString( deep_out );
+	test_assert( deep_str.find( "\n" + std::string( 200u, '\t' ) + "1\n" + std::string( 199u, '\t' ) + "]" ) != std::string::npos );
+	test_assert( deep_str.back() == ']' );
+
+	// Streamed serializer with indents.
+	OutputBuffer streamed_out;
+	{
+		StreamedSerializer<OutputBuffer, SerializationFormatting::TabIndents> streamed_serializer( streamed_out );
+		auto object= streamed_serializer.AddObject();
+		{
+			auto arr= object.AddArray( "a" );
+			arr.AddNumber( 1 );
+			arr.AddNumber( 2 );
+			auto sub_object= arr.AddObject();
+			sub_object.AddNull( "b" );
+		}
+		object.AddObject( "c" );
+		object.AddArray( "d" );
+		object.AddString( "e", "s/" );
+	}
+	test_assert( ToString( streamed_out ) == ToString( tabs_out ) );
+}
+
+void RunSerializerTests()
+{
+	GrowableOutputBufferTest();
+	FixedOutputBufferTest();
+	SerializeIntoBufferTest();
+	SerializeBigValueIntoStreamTest();
+	StreamedSerializerTest();
+	PreparedKeysTest();
+	BulkArrayAppendersTest();
+	StreamedSerializerEmbeddingTest();
+	StringsEscapingTest();
+	NumbersFormattingTest();
+	EscapeSlashInEscapedStringsTest();
+	TwoPhaseSerializationTest();
+	ParallelSerializationTest();
+	ChunkedOutputTest();
+	ResumableSerializationTest();
+	SerializationCacheTest();
+	SerializationCacheDocumentsTest();
+	FormattedSerializationTest();
+}
@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "../include/PanzerJson/parser.hpp"
+#include "../include/PanzerJson/serializer.hpp"
+#include "../include/PanzerJson/snapshot.hpp"
+#include "tests.hpp"
+
+using namespace PanzerJson;
+
+static std::string Serialize( const Value value )
+{
+	OutputBuffer out;
+	Serializer().Serialize( value, out );
+	return std::string( out.GetData(), out.GetSize() );
+}
+
+static std::string ToString( const StringView& str )
+{
+	return std::string( str.data, str.size );
+}
+
+static Parser::ResultPtr SaveAndLoad( const Parser::Result& result )
+{
+	OutputBuffer out;
+	Snapshot::Save( result, out );
+	return Snapshot::Load( out.GetData(), out.GetSize() );
+}
+
+static void SnapshotSaveLoadTest()
+{
+	static const char json_text[]=
+	u8R"(
+		{
+			"records" : [ { "id" : 1, "name" : "a\nb" }, { "id" : 2, "name" : "c" }, { "id" : 3000000000, "name" : "\u0000" } ],
+			"packed" : [ 1, 2, 3 ],
+			"doubles" : [ 0.5, 1e300 ],
+			"mixed" : [ null, true, false, 17, -2.5, "s", [], {} ],
+			"escaped" : "x\tyü"
+		}
+	)";
+
+	for( const bool shapes : { false, true } )
+	for( const bool lazy : { false, true } )
+	{
+		Parser parser;
+		parser.SetShareObjectShapes( shapes );
+		parser.SetInternKeys( shapes );
+		parser.SetLazyNumbers( lazy );
+		parser.SetLazyStringsUnescaping( lazy );
+		parser.SetSaveNumberStrings( lazy );
+		const Parser::ResultPtr result= parser.Parse( json_text );
+		test_assert( result->error == Parser::Result::Error::NoError );
+
+		// One of lazy strings is unescaped before saving, other - after loading.
+		test_assert( ToString( result->root["records"][0u]["name"].AsStringView() ) == "a\nb" );
+
+		const Parser::ResultPtr loaded= SaveAndLoad( *result );
+		test_assert( loaded != nullptr );
+		test_assert( loaded->error == Parser::Result::Error::NoError );
+		test_assert( loaded->root == result->root );
+		test_assert( Serialize( loaded->root ) == Serialize( result->root ) );
+
+		test_assert( ToString( loaded->root["escaped"].AsStringView() ) == u8"x\tyü" );
+		test_assert( loaded->root["records"][2u]["name"].AsStringView().size == 1u );
+		test_assert( loaded->root["records"][2u]["id"].AsUint64() == 3000000000u );
+		test_assert( loaded->root["packed"].AsInt64Span().size == ( lazy ? 0u : 3u ) );
+
+		const Key id_key( "id" );
+		int64_t id_sum= 0;
+		for( const Value record : loaded->root["records"].array_elements() )
+			id_sum+= record[id_key].AsInt64();
+		test_assert( id_sum == 3000000003 );
+
+		// Snapshot of snapshot is same.
+		OutputBuffer out0, out1;
+		Snapshot::Save( *result, out0 );
+		Snapshot::Save( *loaded, out1 );
+		test_assert( out0.GetSize() == out1.GetSize() );
+	}
+
+	// Noncomposite roots.
+	for( const char* const text : { "42", "-1073741824", "1e10", "\"str\"", "null", "true" } )
+	{
+		const Parser::ResultPtr result= Parser().Parse( text );
+		test_assert( result->error == Parser::Result::Error::NoError );
+		const Parser::ResultPtr loaded= SaveAndLoad( *result );
+		test_assert( loaded != nullptr );
+		test_assert( loaded->root == result->root );
+		test_assert( loaded->root.GetType() == result->root.GetType() );
+	}
+}
+
+static void SnapshotInvalidDataTest()
+{
+	const Parser::ResultPtr result= Parser().Parse( R"({"a":[1,"b",{"c":null}]})" );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	OutputBuffer out;
+	Snapshot::Save( *result, out );
+	const std::string snapshot( out.GetData(), out.GetSize() );
+	test_assert( Snapshot::Load( snapshot.data(), snapshot.size() ) != nullptr );
+
+	// Any changed byte is detected.
+	for( size_t i= 0u; i < snapshot.size(); ++i )
+	{
+		std::string corrupted= snapshot;
+		corrupted[i]^= 0x10;
+		test_assert( Snapshot::Load( corrupted.data(), corrupted.size() ) == nullptr );
+	}
+
+	// Truncated and extended data.
+	for( size_t size= 0u; size < snapshot.size(); ++size )
+		test_assert( Snapshot::Load( snapshot.data(), size ) == nullptr );
+	const std::string extended= snapshot + std::string( 8u, '\0' );
+	test_assert( Snapshot::Load( extended.data(), extended.size() ) == nullptr );
+}
+
+static void SnapshotFileTest()
+{
+	std::string json_text= "[";
+	for( size_t i= 0u; i < 1000u; ++i )
+		json_text+= ( i == 0u ? "" : "," ) + std::string( R"({"key":)" ) + std::to_string(i) + R"(,"s":"v)" + std::to_string(i) + R"("})";
+	json_text+= "]";
+
+	const Parser::ResultPtr result= Parser().Parse( json_text.data(), json_text.size() );
+	test_assert( result->error == Parser::Result::Error::NoError );
+
+	const char* const file_name= "panzer_json_snapshot_test.bin";
+	test_assert( Snapshot::SaveFile( *result, file_name ) );
+	const Parser::ResultPtr loaded= Snapshot::LoadFile( file_name );
+	std::remove( file_name );
+
+	test_assert( loaded != nullptr );
+	test_assert( Serialize( loaded->root ) == Serialize( result->root ) );
+	test_assert( ToString( loaded->root[999u]["s"].AsStringView() ) == "v999" );
+
+	test_assert( Snapshot::LoadFile( "nonexistent_panzer_json_snapshot.bin" ) == nullptr );
+}
+
+void RunSnapshotTests()
+{
+	SnapshotSaveLoadTest();
+	SnapshotInvalidDataTest();
+	SnapshotFileTest();
+}
@@ -2,6 +2,11 @@ extern void RunParserTests();
 extern void RunParserErrorsTests();
 extern void RunValueTests();
 extern void RunParsersEqualityTests();
+extern void RunColumnsTests();
+extern void RunSerializerTests();
+extern void RunSnapshotTests();
+extern void RunCborTests();
+extern void RunMessagePackTests();
 
 int main()
 {
@@ -9,4 +14,9 @@ int main()
 	RunParserTests();
 	RunParserErrorsTests();
 	RunParsersEqualityTests();
+	RunColumnsTests();
+	RunSerializerTests();
+	RunSnapshotTests();
+	RunCborTests();
+	RunMessagePackTests();
 }
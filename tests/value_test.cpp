@@ -30,15 +30,21 @@ static void SimpleNumberValueTest()
 {
 	static constexpr NumberValueWithStringStorage<12u> number_storage
 	{
-		NumberValue( 42, -14.7, true ),
+		NumberValue::FromDouble( -14.7, true ),
 		"test string"
 	};
 	Value value( &number_storage.value );
 
 	test_assert( value.GetType() == ValueBase::Type::Number );
-	test_assert( value.AsInt() == 42 );
+	test_assert( value.AsInt() == -14 );
 	test_assert( value.AsDouble() == -14.7 );
 	test_assert( std::strcmp( value.AsString(), "test string" ) == 0 );
+
+	static constexpr NumberValue int_number= NumberValue::FromInt64( 42 );
+	static constexpr NumberValue uint_number= NumberValue::FromUint64( 18446744073709551615ull );
+	test_assert( Value( &int_number ).AsInt() == 42 && Value( &int_number ).AsDouble() == 42.0 );
+	test_assert( Value( &uint_number ).AsUint64() == 18446744073709551615ull && Value( &uint_number ).AsDouble() == 18446744073709551615.0 );
+	test_assert( int_number.IsInteger() && uint_number.IsInteger() && !number_storage.value.IsInteger() );
 }
 
 static void SimpleStringValueTest()
@@ -52,6 +58,25 @@ static void SimpleStringValueTest()
 	test_assert( std::strcmp( value.AsString(), u8"Строковое значение\n." ) == 0 );
 }
 
+static void StringWithLengthValueTest()
+{
+	static constexpr StringValueWithStorage<8u> string_storage
+	{
+		StringValue( 7u ),
+		"abc\0def"
+	};
+	Value value( &string_storage.value );
+
+	test_assert( value.AsStringView().size == 7u );
+	test_assert( value.AsStringView().data == value.AsString() );
+	test_assert( std::strcmp( value.AsString(), "abc" ) == 0 );
+
+	// Length of strings without explicit length is calculated.
+	STRING_STORAGE( string_storage_without_length, "abc" );
+	test_assert( Value( &string_storage_without_length.value ).AsStringView().size == 3u );
+	test_assert( Value( &string_storage_without_length.value ) != value );
+}
+
 static void SimpleBoolValueTest0()
 {
 	static constexpr BoolValue bool_value( false );
@@ -76,7 +101,7 @@ static void SimpleObjectValueTest()
 {
 	static constexpr BoolValue bool_value( true );
 	STRING_STORAGE( string_storage, "a" );
-	static constexpr NumberValue number_value( 1458, 1458.4 );
+	static constexpr NumberValue number_value= NumberValue::FromDouble( 1458.4 );
 	static constexpr ObjectValueWithEntriesStorage<3u> object_torage
 	{
 		ObjectValue(3u),
@@ -108,7 +133,7 @@ static void SimpleArrayValueTest()
 {
 	static constexpr BoolValue bool_value( true );
 	STRING_STORAGE( string_storage, "a" );
-	static constexpr NumberValue number_value( 1458, 1458.4 );
+	static constexpr NumberValue number_value= NumberValue::FromDouble( 1458.4 );
 	static constexpr ArrayValueWithElementsStorage<3u> array_storage
 	{
 		ArrayValue(3u),
@@ -136,10 +161,10 @@ static void ObjectValueSearchTest()
 {
 	static constexpr BoolValue bool_value0( true );
 	STRING_STORAGE( string_storage0, "a" );
-	static constexpr NumberValue number_value0( 1458, 1458.4 );
+	static constexpr NumberValue number_value0= NumberValue::FromDouble( 1458.4 );
 	static constexpr BoolValue bool_value1( false );
 	STRING_STORAGE( string_storage1, "wtf" );
-	static constexpr NumberValue number_value1( -25, -25.0);
+	static constexpr NumberValue number_value1= NumberValue::FromInt64( -25 );
 	static constexpr ArrayValueWithElementsStorage<3u> array_storage
 	{
 		ArrayValue(3u),
@@ -180,6 +205,90 @@ static void ObjectValueSearchTest()
 	test_assert( !value.IsMember( "BIG" ) );
 }
 
+static void KeySearchTest()
+{
+	static constexpr BoolValue bool_value( true );
+	STRING_STORAGE( string_storage, "a" );
+	static constexpr NumberValue number_value= NumberValue::FromDouble( 1458.4 );
+	static constexpr ObjectValueWithEntriesStorage<5u> object_storage0
+	{
+		ObjectValue(5u),
+		{
+			{ "apple", &bool_value },
+			{ "long key", &string_storage.value },
+			{ "long key with many symbols 0", &string_storage.value },
+			{ "long key with many symbols 1", &number_value },
+			{ "zzz", &number_value },
+		}
+	};
+	static constexpr ObjectValueWithEntriesStorage<2u> object_storage1
+	{
+		ObjectValue(2u),
+		{
+			{ "long key with many symbols 1", &bool_value },
+			{ "zzz", &string_storage.value },
+		}
+	};
+	const Value value0( &object_storage0.value );
+	const Value value1( &object_storage1.value );
+
+	const Key apple( "apple" );
+	const Key long_key0( "long key with many symbols 0" );
+	const Key long_key1( "long key with many symbols 1" );
+	const Key long_key( "long key" );
+	const Key zzz( "zzz" );
+	const Key nonexistent( "long key with many symbols" );
+	const Key empty( "" );
+
+	test_assert( apple.GetLength() == 5u );
+	test_assert( long_key0.GetLength() == 28u );
+
+	// Repeat search - second search must use cached position.
+	for( unsigned int i= 0u; i < 2u; i++ )
+	{
+		test_assert( value0.IsMember( apple ) && value0[apple].IsBool() );
+		test_assert( value0[long_key0].IsString() );
+		test_assert( value0[long_key1].IsNumber() );
+		test_assert( value0[long_key].IsString() );
+		test_assert( value0[zzz].IsNumber() );
+		test_assert( !value0.IsMember( nonexistent ) && value0[nonexistent].IsNull() );
+		test_assert( !value0.IsMember( empty ) );
+
+		// Same keys with different positions in other object.
+		test_assert( !value1.IsMember( apple ) );
+		test_assert( value1[long_key1].IsBool() );
+		test_assert( value1[zzz].IsString() );
+		test_assert( !value1.IsMember( long_key0 ) );
+	}
+
+	// Lookup in non-object.
+	test_assert( Value( &bool_value )[zzz].IsNull() );
+
+	// Key remembers pointer of found key string. Storage of freed document may be reused by other strings at same address.
+	// Other strings with this pointer must not be found.
+	char reused_key_string[]= "long key with many symbols 0";
+	const ObjectValueWithEntriesStorage<1u> reused_object_storage
+	{
+		ObjectValue(1u),
+		{
+			{ reused_key_string, &bool_value },
+		}
+	};
+	const Value reused_value( &reused_object_storage.value );
+	test_assert( reused_value[long_key0].IsBool() );
+	std::strcpy( reused_key_string, "long key" ); // Same prefix, other length.
+	test_assert( !reused_value.IsMember( long_key0 ) );
+	test_assert( reused_value[long_key0].IsNull() );
+	std::strcpy( reused_key_string, "long key with many" ); // Same prefix, other length.
+	test_assert( reused_value[long_key0].IsNull() );
+	std::strcpy( reused_key_string, "LONG KEY WITH MANY SYMBOLS 0" ); // Same length, other prefix.
+	test_assert( reused_value[long_key0].IsNull() );
+	std::strcpy( reused_key_string, "apple" ); // Short key.
+	test_assert( reused_value[long_key0].IsNull() && reused_value[apple].IsBool() );
+	std::strcpy( reused_key_string, "zzz" );
+	test_assert( reused_value[apple].IsNull() && reused_value[zzz].IsBool() );
+}
+
 static void UniversalIteratorTest0()
 {
 	// Universal iterator over object.
@@ -188,14 +297,14 @@ static void UniversalIteratorTest0()
 	STRING_STORAGE( string_storage0, "a" );
 	static constexpr NumberValueWithStringStorage<7u> number_storage0
 	{
-		NumberValue( 1458, 1458.4 ),
+		NumberValue::FromDouble( 1458.4 ),
 		"1458.4"
 	};
 	static constexpr BoolValue bool_value1( false );
 	STRING_STORAGE( string_storage1, "wtf" );
 	static constexpr NumberValueWithStringStorage<6u> number_storage1
 	{
-		NumberValue( -25, -25.0 ),
+		NumberValue::FromInt64( -25 ),
 		"-25.0"
 	};
 	static constexpr ArrayValueWithElementsStorage<3u> array_storage
@@ -292,7 +401,7 @@ static void UniversalIteratorTest1()
 
 	static constexpr NumberValueWithStringStorage<7u> number_storage
 	{
-		NumberValue( 1458, 1458.4 ),
+		NumberValue::FromDouble( 1458.4 ),
 		"1458.4",
 	};
 	STRING_STORAGE( string_storage, "a" );
@@ -440,7 +549,7 @@ static void UniversalIteratorTest4()
 	STRING_STORAGE( string_storage, "wtf" );
 	test_iterate( Value( &string_storage.value ) );
 
-	static constexpr NumberValue nuber_value( 4578, 4578.5 );
+	static constexpr NumberValue nuber_value= NumberValue::FromDouble( 4578.5 );
 	test_iterate( Value( &nuber_value ) );
 
 	static constexpr BoolValue bool_value( false );
@@ -451,7 +560,7 @@ static void ArrayIteratorTest0()
 {
 	static constexpr NumberValueWithStringStorage<7u> number_storage
 	{
-		NumberValue( 1458, 1458.4 ),
+		NumberValue::FromDouble( 1458.4 ),
 		"1458.4"
 	};
 	STRING_STORAGE( string_storage, "a" );
@@ -578,7 +687,7 @@ static void ArrayIteratorTest2()
 	STRING_STORAGE( string_storage, "wtf" );
 	test_iterate( Value( &string_storage.value ) );
 
-	static constexpr NumberValue nuber_value( 4578, 4578.5 );
+	static constexpr NumberValue nuber_value= NumberValue::FromDouble( 4578.5 );
 	test_iterate( Value( &nuber_value ) );
 
 	static constexpr BoolValue bool_value( false );
@@ -603,14 +712,14 @@ static void ObjectIteratorTest0()
 	STRING_STORAGE( string_storage0, "a" );
 	static constexpr NumberValueWithStringStorage<7u> number_storage0
 	{
-		NumberValue( 1458, 1458.4 ),
+		NumberValue::FromDouble( 1458.4 ),
 		"1458.4"
 	};
 	static constexpr BoolValue bool_value1( false );
 	STRING_STORAGE( string_storage1, "wtf" );
 	static constexpr NumberValueWithStringStorage<7u> number_storage1
 	{
-		NumberValue( -25, -25.0 ),
+		NumberValue::FromInt64( -25 ),
 		"-25"
 	};
 	static constexpr ArrayValueWithElementsStorage<3u> array_storage
@@ -744,7 +853,7 @@ static void ObjectIteratorTest2()
 	STRING_STORAGE( string_storage, "wtf" );
 	test_iterate( Value( &string_storage.value ) );
 
-	static constexpr NumberValue nuber_value( 4578, 4578.5 );
+	static constexpr NumberValue nuber_value= NumberValue::FromDouble( 4578.5 );
 	test_iterate( Value( &nuber_value ) );
 
 	static constexpr BoolValue bool_value( false );
@@ -767,9 +876,9 @@ static void IteratorsAlgorithms()
 
 	static constexpr NumberValue number_values[3]
 	{
-		NumberValue( 158, 158.0 ),
-		NumberValue( -14, -14.0 ),
-		NumberValue( 25, 25.0 ),
+		NumberValue::FromInt64( 158 ),
+		NumberValue::FromInt64( -14 ),
+		NumberValue::FromInt64( 25 ),
 	};
 	static constexpr ArrayValueWithElementsStorage<3u> array_storage
 	{
@@ -824,9 +933,9 @@ static void ValueEqualityTest2()
 {
 	// Basic numbers equality test.
 
-	static constexpr NumberValue number0( 3, 3.14 );
-	static constexpr NumberValue number1( 3, 3.14 );
-	static constexpr NumberValue number2( 2, 2.718281828 );
+	static constexpr NumberValue number0= NumberValue::FromDouble( 3.14 );
+	static constexpr NumberValue number1= NumberValue::FromDouble( 3.14 );
+	static constexpr NumberValue number2= NumberValue::FromDouble( 2.718281828 );
 	const Value number_value0( &number0 );
 	const Value number_value1( &number1 );
 	const Value number_value2( &number2 );
@@ -847,8 +956,8 @@ static void ValueEqualityTest2()
 static void ValueEqualityTest3()
 {
 	// Numbers with same integer part but with dirrerent double part are not equal.
-	static constexpr NumberValue number0( 3, 3.14 );
-	static constexpr NumberValue number1( 3, 3.15 );
+	static constexpr NumberValue number0= NumberValue::FromDouble( 3.14 );
+	static constexpr NumberValue number1= NumberValue::FromDouble( 3.15 );
 	const Value number_value0( &number0 );
 	const Value number_value1( &number1 );
 
@@ -913,9 +1022,9 @@ static void ValueEqualityTest5()
 	STRING_STORAGE( string1, u8"A" );
 	STRING_STORAGE( string2, u8"" );
 	STRING_STORAGE( string3, u8"" );
-	static constexpr NumberValue number0( 3, 3.14 );
-	static constexpr NumberValue number1( 2, 2.718281828 );
-	static constexpr NumberValue number2( 2, 2.718281828 );
+	static constexpr NumberValue number0= NumberValue::FromDouble( 3.14 );
+	static constexpr NumberValue number1= NumberValue::FromDouble( 2.718281828 );
+	static constexpr NumberValue number2= NumberValue::FromDouble( 2.718281828 );
 	static constexpr NullValue null_value;
 
 	static constexpr ArrayValue array0( 0u );
@@ -980,9 +1089,9 @@ static void ValueEqualityTest6()
 
 	STRING_STORAGE( string0, u8"Quick brown fox jumps over the lazy dog" );
 	STRING_STORAGE( string1, u8"" );
-	static constexpr NumberValue number0( 3, 3.14 );
-	static constexpr NumberValue number1( 2, 2.718281828 );
-	static constexpr NumberValue number2( 2, 2.718281828 );
+	static constexpr NumberValue number0= NumberValue::FromDouble( 3.14 );
+	static constexpr NumberValue number1= NumberValue::FromDouble( 2.718281828 );
+	static constexpr NumberValue number2= NumberValue::FromDouble( 2.718281828 );
 	static constexpr NullValue null_value;
 
 	static constexpr ObjectValue object0( 0u );
@@ -1047,17 +1156,114 @@ static void ValueEqualityTest6()
 	test_assert( !( Value(&object4.value) == Value(&object6.value) ) );
 }
 
+static void PackedArrayValueTest()
+{
+	static constexpr PackedInt64ArrayValueWithStorage<3u> packed_ints
+	{
+		ArrayValue( 3u, ArrayValue::Layout::PackedInt64s ),
+		{ 5, -7, 1024 },
+	};
+	static constexpr PackedDoubleArrayValueWithStorage<3u> packed_doubles
+	{
+		ArrayValue( 3u, ArrayValue::Layout::PackedDoubles ),
+		{ 5.0, -7.0, 1024.0 },
+	};
+	static constexpr NumberValue n0= NumberValue::FromInt64( 5 ), n1= NumberValue::FromInt64( -7 ), n2= NumberValue::FromInt64( 1024 );
+	static constexpr ArrayValueWithElementsStorage<3u> elements
+	{
+		ArrayValue( 3u ),
+		{ &n0, &n1, &n2 },
+	};
+
+	const Value ints( &packed_ints.value ), doubles( &packed_doubles.value ), not_packed( &elements.value );
+	test_assert( ints.IsArray() && ints.ElementCount() == 3u );
+	test_assert( ints[1u].IsNumber() && ints[1u].AsInt() == -7 && ints[1u].AsDouble() == -7.0 );
+	test_assert( doubles[2u].AsInt() == 1024 );
+
+	// Layout does not affect equality.
+	test_assert( ints == doubles );
+	test_assert( ints == not_packed );
+	test_assert( ints[0u] == not_packed[0u] );
+	test_assert( ints[0u] != not_packed[1u] );
+
+	const auto it= std::find_if( doubles.array_begin(), doubles.array_end(), []( const Value v ){ return v.AsInt() < 0; } );
+	test_assert( it != doubles.array_end() && (*it).AsDouble() == -7.0 );
+}
+
+static void ExtractNumbersTest()
+{
+	static constexpr PackedDoubleArrayValueWithStorage<4u> packed_doubles
+	{
+		ArrayValue( 4u, ArrayValue::Layout::PackedDoubles ),
+		{ 1.5, -2.75, 3.0, 1e20 },
+	};
+	static constexpr PackedInt64ArrayValueWithStorage<3u> packed_ints
+	{
+		ArrayValue( 3u, ArrayValue::Layout::PackedInt64s ),
+		{ 7, -8, 5000000000 },
+	};
+	static constexpr NumberValue number= NumberValue::FromDouble( 42.5 );
+	static constexpr BoolValue bool_value( true );
+	STRING_STORAGE( str, "str" );
+	static constexpr ArrayValueWithElementsStorage<4u> elements
+	{
+		ArrayValue( 4u ),
+		{ &number, &str.value, &bool_value, &number },
+	};
+
+	{
+		double d[4];
+		const NumbersExtractionResult result= Value( &packed_doubles.value ).ExtractNumbers( d, 4u );
+		test_assert( result.count == 4u && result.non_number_count == 0u && result.first_non_number_index == 4u );
+		test_assert( d[0] == 1.5 && d[1] == -2.75 && d[3] == 1e20 );
+	}
+	{
+		int32_t i[4];
+		const NumbersExtractionResult result= Value( &packed_doubles.value ).ExtractNumbers( i, 4u );
+		test_assert( result.count == 4u );
+		for( size_t n= 0u; n < 4u; n++ )
+			test_assert( i[n] == Value( &packed_doubles.value )[n].AsInt() );
+	}
+	{
+		float f[2];
+		const NumbersExtractionResult result= Value( &packed_ints.value ).ExtractNumbers( f, 2u );
+		test_assert( result.count == 2u );
+		test_assert( f[0] == 7.0f && f[1] == -8.0f );
+	}
+	{
+		int64_t i[8];
+		const NumbersExtractionResult result= Value( &packed_ints.value ).ExtractNumbers( i, 8u );
+		test_assert( result.count == 3u && i[2] == 5000000000ll );
+	}
+	{
+		double d[4];
+		const NumbersExtractionResult result= Value( &elements.value ).ExtractNumbers( d, 4u );
+		test_assert( result.count == 4u && result.non_number_count == 2u && result.first_non_number_index == 1u );
+		test_assert( d[0] == 42.5 && d[1] == 0.0 && d[2] == 1.0 && d[3] == 42.5 );
+
+		int64_t i[4];
+		Value( &elements.value ).ExtractNumbers( i, 4u );
+		test_assert( i[0] == 42 && i[2] == 1 );
+	}
+	{
+		double d[1];
+		test_assert( Value( &number ).ExtractNumbers( d, 1u ).count == 0u );
+	}
+}
+
 void RunValueTests()
 {
 
 	SimpleNullValueTest();
 	SimpleNumberValueTest();
 	SimpleStringValueTest();
+	StringWithLengthValueTest();
 	SimpleBoolValueTest0();
 	SimpleBoolValueTest1();
 	SimpleObjectValueTest();
 	SimpleArrayValueTest();
 	ObjectValueSearchTest();
+	KeySearchTest();
 	UniversalIteratorTest0();
 	UniversalIteratorTest1();
 	UniversalIteratorTest2();
@@ -1077,4 +1283,6 @@ void RunValueTests()
 	ValueEqualityTest4();
 	ValueEqualityTest5();
 	ValueEqualityTest6();
+	PackedArrayValueTest();
+	ExtractNumbersTest();
 }